@@ -27,6 +27,7 @@
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/impacted.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -43,6 +44,8 @@
 
 namespace graphene { namespace app {
 
+    using graphene::account_history::account_history_plugin;
+
     login_api::login_api(application& a)
     :_app(a)
     {
@@ -84,6 +87,10 @@ namespace graphene { namespace app {
        {
           _block_api = std::make_shared< block_api >( std::ref( *_app.chain_database() ) );
        }
+       else if( api_name == "block_export_api" )
+       {
+          _block_export_api = std::make_shared< block_export_api >( std::ref( _app ) );
+       }
        else if( api_name == "network_broadcast_api" )
        {
           _network_broadcast_api = std::make_shared< network_broadcast_api >( std::ref( _app ) );
@@ -108,6 +115,10 @@ namespace graphene { namespace app {
        {
           _orders_api = std::make_shared< orders_api >( std::ref( _app ) );
        }
+       else if( api_name == "financing_api" )
+       {
+          _financing_api = std::make_shared< financing_api >( std::ref( _app ) );
+       }
        else if( api_name == "debug_api" )
        {
           // can only enable this API if the plugin was loaded
@@ -131,6 +142,112 @@ namespace graphene { namespace app {
        return res;
     }
 
+    vector<optional<vector<char>>> block_api::get_blocks_raw(uint32_t block_num_from, uint32_t block_num_to)const
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       vector<optional<vector<char>>> res;
+       for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
+          res.push_back(_db.fetch_raw_block_by_number(block_num));
+       }
+       return res;
+    }
+
+    // block_export_api
+    block_export_api::block_export_api(application& a)
+       : _app(a), _db( *a.chain_database() ), _buffer( a.get_block_export_buffer() )
+    {
+       if( !_buffer )
+       {
+          _buffer = std::make_shared<block_export_buffer>();
+          _buffer->set_max_blocks( 0 );
+       }
+       _applied_block_connection = _db.applied_block.connect([this](const signed_block& b){ on_applied_block(b); });
+    }
+
+    block_export_api::~block_export_api() { }
+
+    vector<optional<exported_block>> block_export_api::get_exported_blocks(uint32_t block_num_from, uint32_t block_num_to)const
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       FC_ASSERT( block_num_to - block_num_from < 100, "At most 100 blocks can be exported per call" );
+       vector<optional<exported_block>> res;
+       for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
+          res.push_back(_buffer->fetch(_db, block_num));
+       }
+       return res;
+    }
+
+    void block_export_api::subscribe_blocks( std::function<void(const variant&)> cb, uint32_t start_block,
+                                             uint32_t max_unacknowledged )
+    {
+       FC_ASSERT( start_block > 0 );
+       FC_ASSERT( max_unacknowledged > 0 && max_unacknowledged <= 1000 );
+       _callback = cb;
+       _next_block = start_block;
+       _last_acknowledged = start_block - 1;
+       _max_unacknowledged = max_unacknowledged;
+       schedule_push();
+    }
+
+    void block_export_api::acknowledge( uint32_t block_num )
+    {
+       FC_ASSERT( _callback, "No block subscription is active" );
+       // after a fork switch the cursor moves back to the fork point, while acknowledgements for blocks of the old
+       // fork may still be on their way; the client has received everything up to the fork point in that case
+       block_num = std::min( block_num, _next_block - 1 );
+       if( block_num > _last_acknowledged )
+          _last_acknowledged = block_num;
+       schedule_push();
+    }
+
+    void block_export_api::unsubscribe_blocks()
+    {
+       _callback = std::function<void(const variant&)>();
+    }
+
+    /** note: this method cannot yield because it is called in the middle of
+     * apply a block.
+     */
+    void block_export_api::on_applied_block( const signed_block& b )
+    {
+       if( !_callback )
+          return;
+       // a block at or below the cursor means the chain switched forks, resend from the fork point
+       const uint32_t num = b.block_num();
+       if( num < _next_block )
+       {
+          _next_block = num;
+          _last_acknowledged = std::min( _last_acknowledged, num - 1 );
+       }
+       schedule_push();
+    }
+
+    void block_export_api::schedule_push()
+    {
+       if( _push_scheduled || !_callback )
+          return;
+       _push_scheduled = true;
+       /// we need to ensure the block_export_api is not deleted for the life of the async operation
+       auto capture_this = shared_from_this();
+       fc::async( [capture_this](){
+          capture_this->_push_scheduled = false;
+          capture_this->push_blocks();
+       } );
+    }
+
+    void block_export_api::push_blocks()
+    {
+       while( _callback && _next_block <= _db.head_block_num()
+              && _next_block - _last_acknowledged <= _max_unacknowledged )
+       {
+          optional<exported_block> blk = _buffer->fetch( _db, _next_block );
+          if( !blk.valid() )
+             break;
+          ++_next_block;
+          _callback( fc::variant( *blk, GRAPHENE_MAX_NESTED_OBJECTS ) );
+       }
+    }
+
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
     {
        _applied_block_connection = _app.chain_database()->applied_block.connect([this](const signed_block& b){ on_applied_block(b); });
@@ -242,6 +359,12 @@ namespace graphene { namespace app {
        return *_block_api;
     }
 
+    fc::api<block_export_api> login_api::block_export()const
+    {
+       FC_ASSERT(_block_export_api);
+       return *_block_export_api;
+    }
+
     fc::api<network_node_api> login_api::network_node()const
     {
        FC_ASSERT(_network_node_api);
@@ -278,6 +401,12 @@ namespace graphene { namespace app {
        return *_orders_api;
     }
 
+    fc::api<financing_api> login_api::financing() const
+    {
+       FC_ASSERT(_financing_api);
+       return *_financing_api;
+    }
+
     fc::api<graphene::debug_witness::debug_api> login_api::debug() const
     {
        FC_ASSERT(_debug_api);
@@ -318,6 +447,18 @@ namespace graphene { namespace app {
        const auto& db = *_app.chain_database();
        FC_ASSERT( limit <= 100 );
        vector<operation_history_object> result;
+       if( auto plugin = compact_history_plugin() )
+       {
+          if( start == operation_history_id_type() )
+             start = operation_history_id_type( GRAPHENE_DB_MAX_INSTANCE_ID );
+          plugin->for_each_compact_entry( account, start, [&]( operation_history_id_type id ) {
+             if( result.size() >= limit || ( id.instance.value <= stop.instance.value && stop.instance.value != 0 ) )
+                return false;
+             result.push_back( plugin->get_operation( id ) );
+             return true;
+          });
+          return result;
+       }
        try {
           const account_transaction_history_object& node = account(db).statistics(db).most_recent_op(db);
           if(start == operation_history_id_type() || start.instance.value > node.operation_id.instance.value)
@@ -352,6 +493,20 @@ namespace graphene { namespace app {
        const auto& db = *_app.chain_database();
        FC_ASSERT( limit <= 100 );
        vector<operation_history_object> result;
+       if( auto plugin = compact_history_plugin() )
+       {
+          if( start == operation_history_id_type() )
+             start = operation_history_id_type( GRAPHENE_DB_MAX_INSTANCE_ID );
+          plugin->for_each_compact_entry( account, start, [&]( operation_history_id_type id ) {
+             if( result.size() >= limit || ( id.instance.value <= stop.instance.value && stop.instance.value != 0 ) )
+                return false;
+             const operation_history_object oho = plugin->get_operation( id );
+             if( oho.op.which() == operation_id )
+                result.push_back( oho );
+             return true;
+          });
+          return result;
+       }
        const auto& stats = account(db).statistics(db);
        if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
        const account_transaction_history_object* node = &stats.most_recent_op(db);
@@ -387,6 +542,12 @@ namespace graphene { namespace app {
        const auto& db = *_app.chain_database();
        FC_ASSERT(limit <= 100);
        vector<operation_history_object> result;
+       if( auto plugin = compact_history_plugin() )
+       {
+          for( const operation_history_id_type& id : plugin->get_compact_relative_history( account, stop, limit, start ) )
+             result.push_back( plugin->get_operation( id ) );
+          return result;
+       }
        const auto& stats = account(db).statistics(db);
        if( start == 0 )
           start = stats.total_ops;
@@ -412,6 +573,14 @@ namespace graphene { namespace app {
        return result;
     }
 
+    std::shared_ptr<account_history_plugin> history_api::compact_history_plugin()const
+    {
+       auto plugin = std::dynamic_pointer_cast<account_history_plugin>( _app.get_plugin( "account_history" ) );
+       if( plugin && plugin->compact_history() )
+          return plugin;
+       return std::shared_ptr<account_history_plugin>();
+    }
+
     flat_set<uint32_t> history_api::get_market_history_buckets()const
     {
        auto hist = _app.get_plugin<market_history_plugin>( "market_history" );
@@ -640,4 +809,58 @@ namespace graphene { namespace app {
       return result;
    }
 
+   // financing_api
+   flat_set<uint32_t> financing_api::get_financing_bucket_sizes()const
+   {
+      auto plugin = _app.get_plugin<khc_financing_plugin>( "khc_financing" );
+      FC_ASSERT( plugin );
+      return plugin->tracked_buckets();
+   }
+
+   optional<financing_progress> financing_api::get_financing_progress( asset_id_type asset_id )const
+   { try {
+      FC_ASSERT( _app.get_plugin<khc_financing_plugin>( "khc_financing" ) );
+      const auto& db = *_app.chain_database();
+      const auto& idx = db.get_index_type<financing_project_index>().indices().get<by_financing_project>();
+      auto itr = idx.find( asset_id );
+      if( itr == idx.end() )
+         return optional<financing_progress>();
+
+      const asset_object& project_asset = asset_id( db );
+      financing_progress result;
+      result.project = *itr;
+      result.min_financing_amount = project_asset.proj_options.min_financing_amount;
+      result.max_financing_amount = project_asset.proj_options.max_financing_amount;
+      result.start_financing_block_num = project_asset.proj_options.start_financing_block_num;
+      result.end_financing_block_num = project_asset.proj_options.end_financing_block_num;
+      result.state = project_asset.dynamic_asset_data_id( db ).state;
+      if( result.max_financing_amount > 0 )
+         result.percent_of_max = std::min<uint64_t>( GRAPHENE_100_PERCENT,
+               ( fc::uint128_t( itr->total_invested.value ) * GRAPHENE_100_PERCENT
+                 / result.max_financing_amount.value ).to_uint64() );
+      result.min_reached = itr->total_invested >= result.min_financing_amount;
+      return result;
+   } FC_CAPTURE_AND_RETHROW( (asset_id) ) }
+
+   vector<financing_bucket_object> financing_api::get_financing_history( asset_id_type asset_id, uint32_t bucket_seconds,
+                                                                         fc::time_point_sec start, fc::time_point_sec end )const
+   { try {
+      FC_ASSERT( _app.get_plugin<khc_financing_plugin>( "khc_financing" ) );
+      const auto& db = *_app.chain_database();
+      vector<financing_bucket_object> result;
+      if( start > end )
+         return result;
+      result.reserve(200);
+
+      const auto& by_key_idx = db.get_index_type<financing_bucket_index>().indices().get<by_financing_key>();
+      auto itr = by_key_idx.lower_bound( financing_bucket_key( asset_id, bucket_seconds, start ) );
+      auto end_itr = by_key_idx.upper_bound( financing_bucket_key( asset_id, bucket_seconds, end ) );
+      while( itr != end_itr && result.size() < 200 )
+      {
+         result.push_back( *itr );
+         ++itr;
+      }
+      return result;
+   } FC_CAPTURE_AND_RETHROW( (asset_id)(bucket_seconds)(start)(end) ) }
+
 } } // graphene::app
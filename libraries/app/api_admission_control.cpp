@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_admission_control.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace app {
+
+api_admission_control::api_admission_control( const api_cost_limits& limits )
+   : _limits( limits )
+{
+   if( _limits.tokens_per_second > 0 && _limits.burst == 0 )
+      _limits.burst = _limits.tokens_per_second;
+}
+
+uint32_t api_admission_control::method_cost( const std::string& method )const
+{
+   auto itr = _limits.method_costs.find( method );
+   return ( itr != _limits.method_costs.end() ) ? itr->second : _limits.default_cost;
+}
+
+bool api_admission_control::try_begin_call()
+{
+   uint32_t in_flight = ++_in_flight;
+   if( _limits.max_concurrent_calls > 0 && in_flight > _limits.max_concurrent_calls )
+   {
+      --_in_flight;
+      return false;
+   }
+   return true;
+}
+
+void api_admission_control::end_call()
+{
+   --_in_flight;
+}
+
+api_session_limiter::api_session_limiter( std::shared_ptr<api_admission_control> global )
+   : _global( global ),
+     _tokens( global->limits().burst ),
+     _last_refill( fc::time_point::now() )
+{
+}
+
+void api_session_limiter::refill()
+{
+   const auto& limits = _global->limits();
+   if( limits.tokens_per_second == 0 )
+      return;
+   auto now = fc::time_point::now();
+   double elapsed_seconds = double( ( now - _last_refill ).count() ) / 1000000.0;
+   _tokens = std::min( double( limits.burst ), _tokens + elapsed_seconds * limits.tokens_per_second );
+   _last_refill = now;
+}
+
+fc::optional<std::string> api_session_limiter::admit( const std::string& method )
+{
+   const auto& limits = _global->limits();
+   if( limits.max_concurrent_calls_per_connection > 0 && _in_flight >= limits.max_concurrent_calls_per_connection )
+      return std::string( "Too many concurrent calls on this connection" );
+
+   uint32_t cost = 0;
+   if( limits.tokens_per_second > 0 )
+   {
+      refill();
+      cost = _global->method_cost( method );
+      if( _tokens < cost )
+         return std::string( "API rate limit exceeded, method " ) + method + " costs " + std::to_string( cost )
+                + " tokens";
+   }
+
+   if( !_global->try_begin_call() )
+      return std::string( "Server is busy, too many concurrent API calls" );
+
+   _tokens -= cost;
+   ++_in_flight;
+   return fc::optional<std::string>();
+}
+
+void api_session_limiter::release()
+{
+   --_in_flight;
+   _global->end_call();
+}
+
+} }
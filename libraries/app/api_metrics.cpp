@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_metrics.hpp>
+
+#include <graphene/chain/database.hpp>
+
+#include <cctype>
+#include <sstream>
+
+namespace graphene { namespace app {
+
+namespace detail {
+
+   /// bounds the number of distinct labels, clients may call any method name they like
+   const size_t max_tracked_methods = 512;
+
+   std::string sanitize_label( const std::string& method )
+   {
+      std::string result = method.substr( 0, 64 );
+      for( char& c : result )
+         if( !std::isalnum( static_cast<unsigned char>( c ) ) && c != '_' )
+            c = '_';
+      return result.empty() ? std::string( "unknown" ) : result;
+   }
+
+   void write_histogram( std::ostream& out, const std::string& name, const std::string& labels, const histogram& h )
+   {
+      const std::string sep = labels.empty() ? "" : ",";
+      for( size_t i = 0; i < histogram::bucket_count; ++i )
+         out << name << "_bucket{" << labels << sep << "le=\"" << histogram::bucket_bound( i ) << "\"} "
+             << h.cumulative_count( i ) << "\n";
+      out << name << "_bucket{" << labels << sep << "le=\"+Inf\"} " << h.count() << "\n";
+      const std::string braced = labels.empty() ? "" : "{" + labels + "}";
+      out << name << "_sum" << braced << " " << h.sum() << "\n";
+      out << name << "_count" << braced << " " << h.count() << "\n";
+   }
+
+   void write_header( std::ostream& out, const std::string& name, const std::string& type, const std::string& help )
+   {
+      out << "# HELP " << name << " " << help << "\n";
+      out << "# TYPE " << name << " " << type << "\n";
+   }
+
+}
+
+void histogram::record( uint64_t value )
+{
+   size_t i = 0;
+   while( i < bucket_count && value > bucket_bound( i ) )
+      ++i;
+   ++_buckets[i];
+   ++_count;
+   _sum += value;
+}
+
+uint64_t histogram::cumulative_count( size_t i )const
+{
+   uint64_t result = 0;
+   for( size_t j = 0; j <= i && j < _buckets.size(); ++j )
+      result += _buckets[j];
+   return result;
+}
+
+api_method_metrics& api_metrics::method_metrics( const std::string& method )
+{
+   const std::string label = detail::sanitize_label( method );
+   auto itr = _methods.find( label );
+   if( itr != _methods.end() )
+      return itr->second;
+   if( _methods.size() >= detail::max_tracked_methods )
+      return _methods[ "other" ];
+   return _methods[ label ];
+}
+
+void api_metrics::record_call( const std::string& method, const fc::microseconds& elapsed,
+                               size_t request_size, size_t response_size )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   api_method_metrics& m = method_metrics( method );
+   m.latency.record( elapsed.count() > 0 ? elapsed.count() : 0 );
+   m.response_size.record( response_size );
+   m.request_bytes += request_size;
+}
+
+void api_metrics::record_rejected_call( const std::string& method )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   ++method_metrics( method ).rejected;
+}
+
+void api_metrics::record_block_pushed( const fc::microseconds& elapsed )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _block_push_time.record( elapsed.count() > 0 ? elapsed.count() : 0 );
+}
+
+void api_metrics::record_block_applied()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   ++_blocks_applied;
+}
+
+std::string api_metrics::to_prometheus_text( const graphene::chain::database& db )const
+{
+   std::ostringstream out;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+
+      detail::write_header( out, "graphene_api_call_duration_microseconds", "histogram",
+                            "Time spent executing API calls" );
+      for( const auto& m : _methods )
+         detail::write_histogram( out, "graphene_api_call_duration_microseconds", "method=\"" + m.first + "\"",
+                                  m.second.latency );
+
+      detail::write_header( out, "graphene_api_response_bytes", "histogram", "Size of API call replies" );
+      for( const auto& m : _methods )
+         detail::write_histogram( out, "graphene_api_response_bytes", "method=\"" + m.first + "\"",
+                                  m.second.response_size );
+
+      detail::write_header( out, "graphene_api_request_bytes_total", "counter", "Size of API call requests" );
+      for( const auto& m : _methods )
+         out << "graphene_api_request_bytes_total{method=\"" << m.first << "\"} " << m.second.request_bytes << "\n";
+
+      detail::write_header( out, "graphene_api_rejected_calls_total", "counter",
+                            "API calls rejected by admission control" );
+      for( const auto& m : _methods )
+         out << "graphene_api_rejected_calls_total{method=\"" << m.first << "\"} " << m.second.rejected << "\n";
+
+      detail::write_header( out, "graphene_block_push_duration_microseconds", "histogram",
+                            "Time spent pushing blocks received from the network" );
+      detail::write_histogram( out, "graphene_block_push_duration_microseconds", "", _block_push_time );
+
+      detail::write_header( out, "graphene_blocks_applied_total", "counter", "Blocks applied to the chain database" );
+      out << "graphene_blocks_applied_total " << _blocks_applied << "\n";
+   }
+
+   detail::write_header( out, "graphene_head_block_number", "gauge", "Head block number" );
+   out << "graphene_head_block_number " << db.head_block_num() << "\n";
+   detail::write_header( out, "graphene_pending_transactions", "gauge", "Transactions waiting for the next block" );
+   out << "graphene_pending_transactions " << db.get_pending_transaction_count() << "\n";
+   detail::write_header( out, "graphene_undo_stack_depth", "gauge", "Number of undo states kept by the database" );
+   out << "graphene_undo_stack_depth " << db._undo_db.size() << "\n";
+   detail::write_header( out, "graphene_expirations_scheduled", "gauge",
+                         "Objects waiting in the expiration scheduler, by kind" );
+   for( int kind = 0; kind < graphene::chain::expiration_kind_count; ++kind )
+      if( kind != graphene::chain::expired_force_settlements )
+         out << "graphene_expirations_scheduled{kind=\""
+             << graphene::chain::apply_profiler::expiration_name( graphene::chain::expiration_kind( kind ) ) << "\"} "
+             << db.get_expiration_scheduler().size( graphene::chain::expiration_kind( kind ) ) << "\n";
+
+   const graphene::chain::apply_profiler& profiler = db.get_apply_profiler();
+   if( profiler.enabled() )
+   {
+      const graphene::chain::apply_profile profile = profiler.get_profile();
+
+      detail::write_header( out, "graphene_operations_applied_total", "counter",
+                            "Operations applied in blocks, by operation type" );
+      for( const auto& op : profile.operations )
+         out << "graphene_operations_applied_total{operation=\"" << op.name << "\"} " << op.evaluate.count << "\n";
+      detail::write_header( out, "graphene_operation_evaluate_microseconds_total", "counter",
+                            "Time spent evaluating operations applied in blocks" );
+      for( const auto& op : profile.operations )
+         out << "graphene_operation_evaluate_microseconds_total{operation=\"" << op.name << "\"} "
+             << op.evaluate.total_us << "\n";
+      detail::write_header( out, "graphene_operation_apply_microseconds_total", "counter",
+                            "Time spent applying operations in blocks" );
+      for( const auto& op : profile.operations )
+         out << "graphene_operation_apply_microseconds_total{operation=\"" << op.name << "\"} "
+             << op.apply.total_us << "\n";
+
+      detail::write_header( out, "graphene_block_phase_microseconds_total", "counter",
+                            "Time spent in each phase of block application" );
+      for( const auto& phase : profile.phases )
+         out << "graphene_block_phase_microseconds_total{phase=\"" << phase.name << "\"} "
+             << phase.timing.total_us << "\n";
+      detail::write_header( out, "graphene_block_phase_max_microseconds", "gauge",
+                            "Longest time spent in each phase of block application" );
+      for( const auto& phase : profile.phases )
+         out << "graphene_block_phase_max_microseconds{phase=\"" << phase.name << "\"} "
+             << phase.timing.max_us << "\n";
+
+      detail::write_header( out, "graphene_expired_objects_total", "counter",
+                            "Objects removed or processed by the expiration steps of block application" );
+      for( const auto& e : profile.expirations )
+         out << "graphene_expired_objects_total{kind=\"" << e.name << "\"} " << e.total << "\n";
+      detail::write_header( out, "graphene_expired_objects_max_per_block", "gauge",
+                            "Most objects of a kind expired by a single block" );
+      for( const auto& e : profile.expirations )
+         out << "graphene_expired_objects_max_per_block{kind=\"" << e.name << "\"} " << e.max_per_block << "\n";
+
+      detail::write_header( out, "graphene_block_apply_microseconds_total", "counter",
+                            "Time spent applying blocks while profiling" );
+      out << "graphene_block_apply_microseconds_total " << profile.blocks.total_us << "\n";
+      detail::write_header( out, "graphene_slow_blocks_total", "counter",
+                            "Blocks that took longer than slow-block-threshold-ms to apply" );
+      out << "graphene_slow_blocks_total " << profile.slow_blocks << "\n";
+   }
+
+   return out.str();
+}
+
+} }
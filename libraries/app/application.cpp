@@ -52,6 +52,7 @@
 #include <boost/range/algorithm/reverse.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <cctype>
 #include <iostream>
 
 #include <fc/log/file_appender.hpp>
@@ -116,6 +117,180 @@ namespace detail {
 
 namespace graphene { namespace app { namespace detail {
 
+batching_websocket_api_connection::batching_websocket_api_connection( fc::http::websocket_connection& c,
+                                                                      uint32_t max_conversion_depth,
+                                                                      uint32_t max_batch_size,
+                                                                      api_metrics* metrics,
+                                                                      std::shared_ptr<api_session_limiter> limiter )
+   : fc::rpc::websocket_api_connection( c, max_conversion_depth ),
+     _max_batch_size( max_batch_size ),
+     _metrics( metrics ),
+     _limiter( limiter )
+{
+   // replace the handlers installed by the base class, single calls are still forwarded to it
+   _connection.on_message_handler( [this]( const std::string& msg ){ on_batch_message( msg, true ); } );
+   _connection.on_http_handler( [this]( const std::string& msg ){ return on_batch_message( msg, false ); } );
+}
+
+std::string batching_websocket_api_connection::on_batch_message( const std::string& message, bool send_message )
+{
+   auto first = std::find_if( message.begin(), message.end(),
+                              []( char ch ){ return !std::isspace( static_cast<unsigned char>( ch ) ); } );
+   if( first == message.end() || *first != '[' )
+      return dispatch_call( message, send_message, nullptr );
+
+   // failures of the batch as a whole are answered with a single error object, as JSON-RPC 2.0 asks
+   fc::variants batch;
+   string error;
+   try
+   {
+      batch = fc::json::from_string( message, fc::json::legacy_parser, _max_conversion_depth ).get_array();
+   }
+   catch ( const fc::exception& e )
+   {
+      error = json_rpc_error( fc::variant(), -32700, "Parse error: " + e.to_string() );
+   }
+   if( error.empty() && batch.empty() )
+      error = json_rpc_error( fc::variant(), -32600, "Empty batch request" );
+   if( error.empty() && batch.size() > _max_batch_size )
+      error = json_rpc_error( fc::variant(), -32600, "Batch request contains " + std::to_string( batch.size() )
+                                                     + " calls, the limit is " + std::to_string( _max_batch_size ) );
+   if( !error.empty() )
+   {
+      if( send_message )
+         _connection.send_message( error );
+      return error;
+   }
+
+   vector<string> replies;
+   replies.reserve( batch.size() );
+   for( const fc::variant& call : batch )
+   {
+      string reply;
+      if( !call.is_object() || !call.get_object().contains( "method" ) )
+         reply = json_rpc_error( request_id( call ), -32600, "Invalid Request" );
+      else
+      {
+         // notifications (calls without id) produce no reply
+         reply = dispatch_call( fc::json::to_string( call ), false, &call );
+         // the base class answers calls it can not make sense of with the plain exception text
+         if( !reply.empty() && reply[0] != '{' )
+            reply = json_rpc_error( request_id( call ), -32600, reply );
+      }
+      if( !reply.empty() )
+         replies.push_back( std::move(reply) );
+   }
+   if( replies.empty() )
+      return string();
+
+   string reply = "[" + boost::algorithm::join( replies, "," ) + "]";
+   if( send_message )
+      _connection.send_message( reply );
+   return reply;
+}
+
+std::string batching_websocket_api_connection::dispatch_call( const std::string& message, bool send_message,
+                                                              const fc::variant* parsed )
+{
+   if( _metrics == nullptr && _limiter == nullptr )
+      return on_message( message, send_message );
+
+   fc::variant request;
+   try
+   {
+      request = parsed ? *parsed : fc::json::from_string( message, fc::json::legacy_parser, _max_conversion_depth );
+   }
+   catch ( const fc::exception& )
+   {
+      // let the base class report the malformed request
+      return on_message( message, send_message );
+   }
+   const string method = get_method_name( request );
+
+   if( _limiter )
+   {
+      optional<string> rejection = _limiter->admit( method );
+      if( rejection.valid() )
+      {
+         if( _metrics )
+            _metrics->record_rejected_call( method );
+         return reject_call( request, *rejection, send_message );
+      }
+   }
+
+   auto start = fc::time_point::now();
+   string reply;
+   try
+   {
+      reply = on_message( message, send_message );
+   }
+   catch ( ... )
+   {
+      if( _limiter )
+         _limiter->release();
+      throw;
+   }
+   if( _limiter )
+      _limiter->release();
+   if( _metrics )
+      _metrics->record_call( method, fc::time_point::now() - start, message.size(), reply.size() );
+   return reply;
+}
+
+std::string batching_websocket_api_connection::reject_call( const fc::variant& request, const std::string& reason,
+                                                            bool send_message )
+{
+   // notifications are dropped silently
+   if( !request.is_object() || !request.get_object().contains( "id" ) )
+      return string();
+
+   string reply = json_rpc_error( request.get_object()["id"], -32005, reason );
+   if( send_message )
+      _connection.send_message( reply );
+   return reply;
+}
+
+std::string batching_websocket_api_connection::json_rpc_error( const fc::variant& id, int64_t code,
+                                                               const std::string& message )
+{
+   fc::mutable_variant_object error;
+   error( "code", code )( "message", message );
+   fc::mutable_variant_object response;
+   response( "id", id )( "jsonrpc", "2.0" )( "error", error );
+   return fc::json::to_string( fc::variant( response ) );
+}
+
+fc::variant batching_websocket_api_connection::request_id( const fc::variant& request )
+{
+   if( !request.is_object() )
+      return fc::variant();
+   const auto& obj = request.get_object();
+   auto itr = obj.find( "id" );
+   return itr == obj.end() ? fc::variant() : itr->value();
+}
+
+std::string batching_websocket_api_connection::get_method_name( const fc::variant& request )
+{
+   if( !request.is_object() )
+      return "invalid";
+   const auto& obj = request.get_object();
+   auto method_itr = obj.find( "method" );
+   if( method_itr == obj.end() || !method_itr->value().is_string() )
+      return "invalid";
+   const string& method = method_itr->value().get_string();
+   if( method != "call" )
+      return method;
+
+   // {"method":"call","params":[api,"method_name",[args]]}
+   auto params_itr = obj.find( "params" );
+   if( params_itr == obj.end() || !params_itr->value().is_array() )
+      return method;
+   const auto& params = params_itr->value().get_array();
+   if( params.size() < 2 || !params[1].is_string() )
+      return method;
+   return params[1].get_string();
+}
+
 void application_impl::reset_p2p_node(const fc::path& data_dir)
 { try {
    _p2p_network = std::make_shared<net::node>("BitShares Reference Implementation");
@@ -245,7 +420,11 @@ std::vector<fc::ip::endpoint> application_impl::resolve_string_to_ip_endpoints(c
 
 void application_impl::new_connection( const fc::http::websocket_connection_ptr& c )
 {
-   auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c, GRAPHENE_NET_MAX_NESTED_OBJECTS);
+   std::shared_ptr<api_session_limiter> limiter;
+   if( _admission_control )
+      limiter = std::make_shared<api_session_limiter>( _admission_control );
+   auto wsc = std::make_shared<batching_websocket_api_connection>( *c, GRAPHENE_NET_MAX_NESTED_OBJECTS, _max_batch_size,
+                                                                   _api_metrics.get(), limiter );
    auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
    login->enable_api("database_api");
 
@@ -307,6 +486,38 @@ void application_impl::reset_websocket_tls_server()
    _websocket_tls_server->start_accept();
 } FC_CAPTURE_AND_RETHROW() }
 
+void application_impl::reset_metrics_server()
+{ try {
+   if( !_options->count("metrics-endpoint") )
+      return;
+
+   _api_metrics = std::make_shared<api_metrics>();
+   _metrics_applied_block_connection = _chain_db->applied_block.connect( [this]( const signed_block& ) {
+      _api_metrics->record_block_applied();
+   });
+
+   _metrics_server = std::make_shared<fc::http::server>();
+   ilog("Configured metrics server to listen on ${ip}", ("ip",_options->at("metrics-endpoint").as<string>()));
+   _metrics_server->listen( fc::ip::endpoint::from_string(_options->at("metrics-endpoint").as<string>()) );
+   // due to implementation, on_request() must come AFTER listen()
+   _metrics_server->on_request( [this]( const fc::http::request& req, const fc::http::server::response& resp )
+   {
+      if( req.path != "/metrics" )
+      {
+         resp.set_status( fc::http::reply::NotFound );
+         resp.set_length( 0 );
+         return;
+      }
+      string body = _api_metrics->to_prometheus_text( *_chain_db );
+      for( const auto& provider : _metrics_providers )
+         body += provider();
+      resp.set_status( fc::http::reply::OK );
+      resp.add_header( "Content-Type", "text/plain; version=0.0.4" );
+      resp.set_length( body.size() );
+      resp.write( body.data(), body.size() );
+   });
+} FC_CAPTURE_AND_RETHROW() }
+
 void application_impl::set_dbg_init_key( graphene::chain::genesis_state_type& genesis, const std::string& init_key )
 {
    flat_set< std::string > initial_witness_names;
@@ -384,12 +595,33 @@ void application_impl::startup()
    }
    _chain_db->add_checkpoints( loaded_checkpoints );
 
+   if( _options->count("block-cache-size") )
+      _chain_db->set_block_cache_size( _options->at("block-cache-size").as<uint32_t>() );
+
+   if( _options->count("fork-db-max-mb") )
+      _chain_db->set_fork_db_max_bytes( size_t( _options->at("fork-db-max-mb").as<uint32_t>() ) * 1024 * 1024 );
+
+   if( _options->count("recent-transaction-cache-size") )
+      _chain_db->set_recent_transaction_cache_size( _options->at("recent-transaction-cache-size").as<uint32_t>() );
+
+   if( _options->count("maintenance-threads") )
+      _chain_db->set_maintenance_threads( _options->at("maintenance-threads").as<uint32_t>() );
+
+   if( _options->count("apply-profiling") )
+      _chain_db->get_apply_profiler().enable( _options->at("apply-profiling").as<bool>() );
+   if( _options->count("slow-block-threshold-ms") )
+      _chain_db->get_apply_profiler().set_slow_block_threshold(
+            fc::milliseconds( _options->at("slow-block-threshold-ms").as<uint32_t>() ) );
+
    if( _options->count("replay-blockchain") )
       _chain_db->wipe( _data_dir / "blockchain", false );
 
    try
    {
-      _chain_db->open( _data_dir / "blockchain", initial_state, GRAPHENE_CURRENT_DB_VERSION );
+      fc::path snapshot;
+      if( _options->count("import-snapshot") )
+         snapshot = _options->at("import-snapshot").as<boost::filesystem::path>();
+      _chain_db->open( _data_dir / "blockchain", initial_state, GRAPHENE_CURRENT_DB_VERSION, snapshot );
    }
    catch( const fc::exception& e )
    {
@@ -397,12 +629,23 @@ void application_impl::startup()
       throw;
    }
 
+   _block_export_buffer = std::make_shared<block_export_buffer>();
+   if( _options->count("export-buffer-blocks") )
+      _block_export_buffer->set_max_blocks( _options->at("export-buffer-blocks").as<uint32_t>() );
+   if( _block_export_buffer->max_blocks() > 0 )
+      _block_export_connection = _chain_db->applied_block.connect( [this]( const signed_block& b ) {
+         _block_export_buffer->on_applied_block( *_chain_db, b );
+      });
+
    if( _options->count("force-validate") )
    {
       ilog( "All transaction signatures will be validated" );
       _force_validate = true;
    }
 
+   if( _options->count("rpc-max-batch-size") )
+      _max_batch_size = _options->at("rpc-max-batch-size").as<uint32_t>();
+
    // TODO uncomment this when GUI is ready
    //if( _options->count("enable-subscribe-to-all") )
    //   _app_options.enable_subscribe_to_all = _options->at("enable-subscribe-to-all").as<bool>();
@@ -438,9 +681,37 @@ void application_impl::startup()
       wild_access.allowed_apis.push_back( "history_api" );
       wild_access.allowed_apis.push_back( "crypto_api" );
       wild_access.allowed_apis.push_back( "orders_api" );
+      wild_access.allowed_apis.push_back( "financing_api" );
       _apiaccess.permission_map["*"] = wild_access;
    }
 
+   if( _apiaccess.cost_limits.enabled() )
+   {
+      auto& limits = _apiaccess.cost_limits;
+      if( limits.tokens_per_second > 0 )
+      {
+         if( limits.burst == 0 )
+            limits.burst = limits.tokens_per_second;
+         // a call more expensive than a full bucket could never run
+         if( limits.default_cost > limits.burst )
+         {
+            wlog( "API default_cost ${c} exceeds burst ${b}, using ${b}", ("c",limits.default_cost)("b",limits.burst) );
+            limits.default_cost = limits.burst;
+         }
+         for( auto& method_cost : limits.method_costs )
+         {
+            if( method_cost.second <= limits.burst )
+               continue;
+            wlog( "API cost ${c} of method ${m} exceeds burst ${b}, using ${b}",
+                  ("c",method_cost.second)("m",method_cost.first)("b",limits.burst) );
+            method_cost.second = limits.burst;
+         }
+      }
+      ilog( "API admission control enabled: ${l}", ("l",_apiaccess.cost_limits) );
+      _admission_control = std::make_shared<api_admission_control>( _apiaccess.cost_limits );
+   }
+
+   reset_metrics_server();
    reset_p2p_node(_data_dir);
    reset_websocket_server();
    reset_websocket_tls_server();
@@ -512,9 +783,12 @@ bool application_impl::handle_block(const graphene::net::block_message& blk_msg,
       // you can help the network code out by throwing a block_older_than_undo_history exception.
       // when the net code sees that, it will stop trying to push blocks from that chain, but
       // leave that peer connected so that they can get sync blocks from us
+      auto push_start = fc::time_point::now();
       bool result = _chain_db->push_block( blk_msg.block,
                                            (_is_block_producer | _force_validate) ?
                                               database::skip_nothing : database::skip_transaction_signatures );
+      if( _api_metrics )
+         _api_metrics->record_block_pushed( fc::time_point::now() - push_start );
 
       // the block was accepted, so we now know all of the transactions contained in the block
       if (!sync_mode)
@@ -931,6 +1205,24 @@ void application::set_program_options(boost::program_options::options_descriptio
           "Endpoint for websocket RPC to listen on")
          ("rpc-tls-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8089"),
           "Endpoint for TLS websocket RPC to listen on")
+         ("rpc-max-batch-size", bpo::value<uint32_t>()->default_value(100),
+          "Maximum number of calls accepted in a single JSON-RPC batch request")
+         ("block-cache-size", bpo::value<uint32_t>()->default_value(512),
+          "Number of recently applied blocks kept decoded in memory to serve block API calls, 0 to disable")
+         ("fork-db-max-mb", bpo::value<uint32_t>()->default_value(0),
+          "Megabytes of blocks from abandoned forks kept in the fork database, 0 for no limit")
+         ("recent-transaction-cache-size", bpo::value<uint32_t>()->default_value(10000),
+          "Number of recently applied transactions kept in full to serve peers and get_recent_transaction_by_id, 0 to disable")
+         ("maintenance-threads", bpo::value<uint32_t>()->default_value(0),
+          "Number of threads tallying votes during chain maintenance, 0 to use one per core when there are many accounts")
+         ("apply-profiling", bpo::value<bool>()->default_value(false),
+          "Time the evaluate and apply steps of each operation type and the phases of block application")
+         ("slow-block-threshold-ms", bpo::value<uint32_t>()->default_value(0),
+          "With apply-profiling, log the timing breakdown of blocks that take at least this long to apply, 0 to disable")
+         ("export-buffer-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Number of recent blocks whose virtual operations are kept for block_export_api, 0 to disable")
+         ("metrics-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8091"),
+          "Endpoint for the HTTP server exposing API and chain metrics in Prometheus text format at /metrics")
          ("server-pem,p", bpo::value<string>()->implicit_value("server.pem"), "The TLS certificate file for this server")
          ("server-pem-password,P", bpo::value<string>()->implicit_value(""), "Password for this certificate")
          ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
@@ -950,6 +1242,8 @@ void application::set_program_options(boost::program_options::options_descriptio
           "invalid file is found, it will be replaced with an example Genesis State.")
          ("replay-blockchain", "Rebuild object graph by replaying all blocks")
          ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
+         ("import-snapshot", bpo::value<boost::filesystem::path>(),
+          "Replace the object graph with the state in this binary snapshot, then apply the blocks after it")
          ("force-validate", "Force validation of all transactions")
          ("genesis-timestamp", bpo::value<uint32_t>(),
           "Replace timestamp from genesis.json with current time plus this many seconds (experts only!)")
@@ -1118,5 +1412,15 @@ const application_options& application::get_options()
    return my->_app_options;
 }
 
+std::shared_ptr<block_export_buffer> application::get_block_export_buffer()const
+{
+   return my->_block_export_buffer;
+}
+
+void application::add_metrics_provider( std::function<std::string()> provider )
+{
+   my->_metrics_providers.push_back( provider );
+}
+
 // namespace detail
 } }
@@ -1,14 +1,56 @@
 #pragma once
 
+#include <fc/network/http/server.hpp>
 #include <fc/network/http/websocket.hpp>
+#include <fc/rpc/websocket_api.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_admission_control.hpp>
+#include <graphene/app/api_metrics.hpp>
+#include <graphene/app/block_export.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/net/message.hpp>
 
 namespace graphene { namespace app { namespace detail {
 
+/**
+ * @brief Websocket API connection that also accepts JSON-RPC 2.0 batch requests
+ *
+ * A batch is a JSON array of ordinary request objects. Every element is dispatched through the
+ * regular single-call path and all replies are returned to the client as one JSON array, so that
+ * bulk consumers can fetch many blocks or objects in a single round trip.
+ * Elements which are not valid calls are answered with a JSON-RPC error object in their place; an unparsable,
+ * empty or oversized batch is answered with a single error object.
+ *
+ * When metrics are enabled every call is timed and recorded under its method name. When admission control is
+ * configured, calls exceeding the connection's budget are answered with an error without being executed.
+ */
+class batching_websocket_api_connection : public fc::rpc::websocket_api_connection
+{
+   public:
+      batching_websocket_api_connection( fc::http::websocket_connection& c, uint32_t max_conversion_depth,
+                                         uint32_t max_batch_size, api_metrics* metrics,
+                                         std::shared_ptr<api_session_limiter> limiter );
+
+   private:
+      std::string on_batch_message( const std::string& message, bool send_message );
+      std::string dispatch_call( const std::string& message, bool send_message, const fc::variant* parsed );
+
+      std::string reject_call( const fc::variant& request, const std::string& reason, bool send_message );
+
+      /// @return a JSON-RPC 2.0 error reply
+      static std::string json_rpc_error( const fc::variant& id, int64_t code, const std::string& message );
+      /// @return the id of a request, null if it has none
+      static fc::variant request_id( const fc::variant& request );
+
+      /// @return the name of the API method addressed by a request, as used for metrics
+      static std::string get_method_name( const fc::variant& request );
+
+      uint32_t                             _max_batch_size;
+      api_metrics*                         _metrics;
+      std::shared_ptr<api_session_limiter> _limiter;
+};
 
 class application_impl : public net::node_delegate
    {
@@ -28,6 +70,8 @@ class application_impl : public net::node_delegate
 
       void reset_websocket_tls_server();
 
+      void reset_metrics_server();
+
       explicit application_impl(application* self)
          : _self(self),
            _chain_db(std::make_shared<chain::database>())
@@ -189,11 +233,19 @@ class application_impl : public net::node_delegate
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
+      std::shared_ptr<fc::http::server>                _metrics_server;
+      std::shared_ptr<api_metrics>                     _api_metrics;
+      std::shared_ptr<api_admission_control>           _admission_control;
+      boost::signals2::scoped_connection               _metrics_applied_block_connection;
+      std::vector<std::function<std::string()>>       _metrics_providers;
+      std::shared_ptr<block_export_buffer>             _block_export_buffer;
+      boost::signals2::scoped_connection               _block_export_connection;
 
       std::map<string, std::shared_ptr<abstract_plugin>> _active_plugins;
       std::map<string, std::shared_ptr<abstract_plugin>> _available_plugins;
 
       bool _is_finished_syncing = false;
+      uint32_t _max_batch_size = 100;
    };
 
 }}} // namespace graphene namespace app namespace detail
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/block_export.hpp>
+#include <graphene/chain/database.hpp>
+
+namespace graphene { namespace app {
+
+void block_export_buffer::set_max_blocks( uint32_t n )
+{
+   _max_blocks = n;
+   while( _blocks.size() > _max_blocks )
+      _blocks.erase( _blocks.begin() );
+}
+
+void block_export_buffer::on_applied_block( const database& db, const signed_block& b )
+{
+   const uint32_t num = b.block_num();
+   _blocks.erase( _blocks.lower_bound( num ), _blocks.end() );
+   if( _max_blocks == 0 )
+      return;
+
+   recorded_block& rec = _blocks[num];
+   rec.id = b.id();
+   for( const optional< operation_history_object >& o_op : db.get_applied_operations() )
+      if( o_op.valid() )
+         rec.operations.push_back( *o_op );
+
+   while( _blocks.size() > _max_blocks )
+      _blocks.erase( _blocks.begin() );
+}
+
+optional<exported_block> block_export_buffer::fetch( const database& db, uint32_t block_num )const
+{
+   optional<signed_block> b = db.fetch_block_by_number( block_num );
+   if( !b.valid() )
+      return optional<exported_block>();
+
+   exported_block result;
+   result.block_num = block_num;
+   result.block_id = b->id();
+   result.header = *b;
+
+   auto itr = _blocks.find( block_num );
+   if( itr != _blocks.end() && itr->second.id == result.block_id )
+   {
+      result.virtual_ops_included = true;
+      result.operations = itr->second.operations;
+      return result;
+   }
+
+   for( uint16_t trx_in_block = 0; trx_in_block < b->transactions.size(); ++trx_in_block )
+   {
+      const processed_transaction& trx = b->transactions[trx_in_block];
+      for( uint16_t op_in_trx = 0; op_in_trx < trx.operations.size(); ++op_in_trx )
+      {
+         operation_history_object oh;
+         oh.op = trx.operations[op_in_trx];
+         if( op_in_trx < trx.operation_results.size() )
+            oh.result = trx.operation_results[op_in_trx];
+         oh.block_num = block_num;
+         oh.trx_in_block = trx_in_block;
+         oh.op_in_trx = op_in_trx;
+         result.operations.push_back( std::move(oh) );
+      }
+   }
+   return result;
+}
+
+} } // graphene::app
@@ -59,6 +59,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       // Objects
       fc::variants get_objects(const vector<object_id_type>& ids)const;
+      vector<optional<vector<char>>> get_objects_raw(const vector<object_id_type>& ids)const;
 
       // Subscriptions
       void set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create );
@@ -166,6 +167,10 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       vector<asset_investment_object> list_account_investment(account_id_type account_id);
 
+      vector<account_power_rank_info> get_power_leaderboard(bool by_available, uint32_t start, uint32_t limit)const;
+      optional<account_power_rank_info> get_account_power_rank(account_id_type account)const;
+      account_power_rank_info power_rank_info(const account_power_rank& rank)const;
+
 
    //private:
       static string price_to_string( const price& _price, const asset_object& _base, const asset_object& _quote );
@@ -190,11 +195,12 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          return _subscribe_filter.contains( i );
       }
 
-      bool is_impacted_account( const flat_set<account_id_type>& accounts)
+      bool is_impacted_account( const lazy_impacted_accounts& impacted )
       {
-         if( !_subscribed_accounts.size() || !accounts.size() )
+         if( !_subscribed_accounts.size() )
             return false;
 
+         const flat_set<account_id_type>& accounts = impacted.get();
          return std::any_of(accounts.begin(), accounts.end(), [this](const account_id_type& account) {
             return _subscribed_accounts.find(account) != _subscribed_accounts.end();
          });
@@ -231,12 +237,12 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       void broadcast_updates( const vector<variant>& updates );
       void broadcast_market_updates( const market_queue_type& queue);
-      void handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object);
+      void handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts, std::function<const object*(object_id_type id)> find_object);
 
       /** called every time a block is applied to report the objects that were changed */
-      void on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts);
+      void on_objects_new(const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts);
+      void on_objects_changed(const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts);
+      void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs, const lazy_impacted_accounts& impacted_accounts);
       void on_applied_block();
 
       bool _notify_remove_create = false;
@@ -272,13 +278,13 @@ database_api_impl::database_api_impl( graphene::chain::database& db, const appli
 :_db(db), _app_options(app_options)
 {
    wlog("creating database api ${x}", ("x",int64_t(this)) );
-   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
+   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts) {
                                 on_objects_new(ids, impacted_accounts);
                                 });
-   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
+   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts) {
                                 on_objects_changed(ids, impacted_accounts);
                                 });
-   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
+   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const lazy_impacted_accounts& impacted_accounts) {
                                 on_objects_removed(ids, objs, impacted_accounts);
                                 });
    _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
@@ -329,6 +335,26 @@ fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)co
    return result;
 }
 
+vector<optional<vector<char>>> database_api::get_objects_raw(const vector<object_id_type>& ids)const
+{
+   return my->get_objects_raw( ids );
+}
+
+vector<optional<vector<char>>> database_api_impl::get_objects_raw(const vector<object_id_type>& ids)const
+{
+   vector<optional<vector<char>>> result;
+   result.reserve(ids.size());
+
+   std::transform(ids.begin(), ids.end(), std::back_inserter(result),
+                  [this](object_id_type id) -> optional<vector<char>> {
+      if(auto obj = _db.find_object(id))
+         return obj->pack();
+      return {};
+   });
+
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Subscriptions                                                    //
@@ -1867,7 +1893,8 @@ set<public_key_type> database_api_impl::get_required_signatures( const signed_tr
                                        available_keys,
                                        [&]( account_id_type id ){ return &id(_db).active; },
                                        [&]( account_id_type id ){ return &id(_db).owner; },
-                                       _db.get_global_properties().parameters.max_authority_depth );
+                                       _db.get_global_properties().parameters.max_authority_depth,
+                                       &_db.get_authority_cache() );
    return result;
 }
 
@@ -1950,7 +1977,8 @@ bool database_api_impl::verify_authority( const signed_transaction& trx )const
    trx.verify_authority( _db.get_chain_id(),
                          [this]( account_id_type id ){ return &id(_db).active; },
                          [this]( account_id_type id ){ return &id(_db).owner; },
-                          _db.get_global_properties().parameters.max_authority_depth );
+                          _db.get_global_properties().parameters.max_authority_depth,
+                          &_db.get_authority_cache() );
    return true;
 }
 
@@ -2006,11 +2034,11 @@ vector< fc::variant > database_api::get_required_fees( const vector<operation>&
 struct get_required_fees_helper
 {
    get_required_fees_helper(
-      const fee_schedule& _current_fee_schedule,
+      const fee_table& _current_fees,
       const price& _core_exchange_rate,
       uint32_t _max_recursion
       )
-      : current_fee_schedule(_current_fee_schedule),
+      : current_fees(_current_fees),
         core_exchange_rate(_core_exchange_rate),
         max_recursion(_max_recursion)
    {}
@@ -2023,7 +2051,7 @@ struct get_required_fees_helper
       }
       else
       {
-         asset fee = current_fee_schedule.set_fee( op, core_exchange_rate );
+         asset fee = current_fees.set_fee( op, core_exchange_rate );
          fc::variant result;
          fc::to_variant( fee, result, GRAPHENE_NET_MAX_NESTED_OBJECTS );
          return result;
@@ -2043,13 +2071,13 @@ struct get_required_fees_helper
       }
       // we need to do this on the boxed version, which is why we use
       // two mutually recursive functions instead of a visitor
-      result.first = current_fee_schedule.set_fee( proposal_create_op, core_exchange_rate );
+      result.first = current_fees.set_fee( proposal_create_op, core_exchange_rate );
       fc::variant vresult;
       fc::to_variant( result, vresult, GRAPHENE_NET_MAX_NESTED_OBJECTS );
       return vresult;
    }
 
-   const fee_schedule& current_fee_schedule;
+   const fee_table& current_fees;
    const price& core_exchange_rate;
    uint32_t max_recursion;
    uint32_t current_recursion = 0;
@@ -2067,7 +2095,7 @@ vector< fc::variant > database_api_impl::get_required_fees( const vector<operati
    result.reserve(ops.size());
    const asset_object& a = id(_db);
    get_required_fees_helper helper(
-      _db.current_fee_schedule(),
+      _db.current_fee_table(),
       a.options.core_exchange_rate,
       GET_REQUIRED_FEES_MAX_RECURSION );
    for( operation& op : _ops )
@@ -2178,6 +2206,16 @@ vector<asset_investment_object> database_api::list_account_investment(account_id
     return my->list_account_investment(account_id);
 }
 
+vector<account_power_rank_info> database_api::get_power_leaderboard(bool by_available, uint32_t start, uint32_t limit)const
+{
+    return my->get_power_leaderboard(by_available, start, limit);
+}
+
+optional<account_power_rank_info> database_api::get_account_power_rank(account_id_type account)const
+{
+    return my->get_account_power_rank(account);
+}
+
 vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_by_recipient(account_id_type account, withdraw_permission_id_type start, uint32_t limit)const
 {
    FC_ASSERT( limit <= 101 );
@@ -2262,6 +2300,54 @@ vector<asset_investment_object> database_api_impl::list_account_investment(accou
     return vec;
 }
 
+account_power_rank_info database_api_impl::power_rank_info(const account_power_rank& rank)const
+{
+    const auto& ranks = _db.get_index_type<account_power_index>().get_secondary_index<account_power_rank_index>();
+    const auto& by_total = ranks.ranks().get<by_total_power>();
+    const auto& by_available = ranks.ranks().get<by_available_power>();
+
+    account_power_rank_info info;
+    info.account = rank.account;
+    info.total_power = rank.total_power;
+    info.available_power = rank.available_power();
+    info.total_power_rank = ranks.rank_of<by_total_power>(
+          by_total.find(boost::make_tuple(rank.total_power, rank.account))) + 1;
+    info.available_power_rank = ranks.rank_of<by_available_power>(
+          by_available.find(boost::make_tuple(rank.available_power(), rank.account))) + 1;
+    return info;
+}
+
+vector<account_power_rank_info> database_api_impl::get_power_leaderboard(bool by_available, uint32_t start, uint32_t limit)const
+{
+    FC_ASSERT( limit <= 101 );
+    const auto& ranks = _db.get_index_type<account_power_index>().get_secondary_index<account_power_rank_index>();
+    vector<account_power_rank_info> result;
+    result.reserve(limit);
+    if( by_available )
+    {
+        const auto& idx = ranks.ranks().get<by_available_power>();
+        for( auto itr = ranks.nth<by_available_power>(start); itr != idx.end() && result.size() < limit; ++itr )
+            result.push_back(power_rank_info(*itr));
+    }
+    else
+    {
+        const auto& idx = ranks.ranks().get<by_total_power>();
+        for( auto itr = ranks.nth<by_total_power>(start); itr != idx.end() && result.size() < limit; ++itr )
+            result.push_back(power_rank_info(*itr));
+    }
+    return result;
+}
+
+optional<account_power_rank_info> database_api_impl::get_account_power_rank(account_id_type account)const
+{
+    const auto& ranks = _db.get_index_type<account_power_index>().get_secondary_index<account_power_rank_index>();
+    const auto& idx = ranks.ranks().get<by_power_account>();
+    auto itr = idx.find(account);
+    if( itr == idx.end() )
+        return optional<account_power_rank_info>();
+    return power_rank_info(*itr);
+}
+
 
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
@@ -2296,7 +2382,7 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
    }
 }
 
-void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts)
+void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, const vector<const object*>& objs, const lazy_impacted_accounts& impacted_accounts)
 {
    handle_object_changed(_notify_remove_create, false, ids, impacted_accounts,
       [objs](object_id_type id) -> const object* {
@@ -2312,29 +2398,30 @@ void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, c
    );
 }
 
-void database_api_impl::on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
+void database_api_impl::on_objects_new(const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts)
 {
    handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
       std::bind(&object_database::find_object, &_db, std::placeholders::_1)
    );
 }
 
-void database_api_impl::on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
+void database_api_impl::on_objects_changed(const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts)
 {
    handle_object_changed(false, true, ids, impacted_accounts,
       std::bind(&object_database::find_object, &_db, std::placeholders::_1)
    );
 }
 
-void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object)
+void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts, std::function<const object*(object_id_type id)> find_object)
 {
    if( _subscribe_callback )
    {
       vector<variant> updates;
+      const bool impacted = !force_notify && is_impacted_account(impacted_accounts);
 
       for(auto id : ids)
       {
-         if( force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts) )
+         if( force_notify || impacted || is_subscribed_to_item(id) )
          {
             if( full_object )
             {
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/block_export.hpp>
 
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/protocol/confidential.hpp>
@@ -32,6 +33,8 @@
 
 #include <graphene/grouped_orders/grouped_orders_plugin.hpp>
 
+#include <graphene/khc_financing/khc_financing_plugin.hpp>
+
 #include <graphene/debug_witness/debug_api.hpp>
 
 #include <graphene/net/node.hpp>
@@ -48,10 +51,13 @@
 #include <string>
 #include <vector>
 
+namespace graphene { namespace account_history { class account_history_plugin; } }
+
 namespace graphene { namespace app {
    using namespace graphene::chain;
    using namespace graphene::market_history;
    using namespace graphene::grouped_orders;
+   using namespace graphene::khc_financing;
    using namespace fc::ecc;
    using namespace std;
 
@@ -181,6 +187,9 @@ namespace graphene { namespace app {
                                                    fc::time_point_sec start, fc::time_point_sec end )const;
          flat_set<uint32_t> get_market_history_buckets()const;
       private:
+           /// @return the account_history plugin if it stores history in account_history_chunk_object
+           std::shared_ptr<graphene::account_history::account_history_plugin> compact_history_plugin()const;
+
            application& _app;
    };
 
@@ -195,10 +204,76 @@ namespace graphene { namespace app {
 
       vector<optional<signed_block>> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
 
+      /**
+       * @brief Retrieve a range of blocks in their binary form
+       * @param block_num_from Height of the first block to return
+       * @param block_num_to Height of the last block to return
+       * @return fc::raw packed signed_block for each height (hex encoded), or null if no matching block was found
+       *
+       * Blocks are served straight from the block log without being decoded, so clients which understand
+       * the chain's reflection can skip JSON conversion entirely.
+       */
+      vector<optional<vector<char>>> get_blocks_raw(uint32_t block_num_from, uint32_t block_num_to)const;
+
    private:
       graphene::chain::database& _db;
    };
 
+   /**
+    * @brief The block_export_api class streams blocks and their applied operations to external indexers
+    *
+    * A subscription starts at any block height, catches up with the head and then follows it live. Every block is
+    * pushed as an @ref exported_block. The server stops pushing once @c max_unacknowledged blocks are awaiting an
+    * @ref acknowledge call, which keeps a slow client from piling up messages on the node. Since blocks are
+    * identified by height, a client resumes after a disconnect by subscribing again from the block after the last
+    * one it processed. If the chain switches forks, the blocks from the fork point on are pushed again; clients
+    * detect this by the block's previous id.
+    */
+   class block_export_api : public std::enable_shared_from_this<block_export_api>
+   {
+      public:
+         block_export_api(application& a);
+         ~block_export_api();
+
+         /**
+          * @brief Retrieve a range of blocks together with their applied operations
+          * @param block_num_from Height of the first block to return
+          * @param block_num_to Height of the last block to return, at most 100 blocks after block_num_from
+          */
+         vector<optional<exported_block>> get_exported_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
+
+         /**
+          * @brief Push every block from @p start_block on to @p cb, replacing any previous subscription
+          * @param max_unacknowledged Number of blocks that may be pushed ahead of the last acknowledged one, 1 to 1000
+          */
+         void subscribe_blocks( std::function<void(const variant&)> cb, uint32_t start_block,
+                                uint32_t max_unacknowledged );
+
+         /**
+          * @brief Report that all blocks up to and including @p block_num were processed
+          *
+          * Acknowledgements beyond the last pushed block, such as those for blocks of a fork the node has switched
+          * away from, only acknowledge the blocks pushed so far.
+          */
+         void acknowledge( uint32_t block_num );
+
+         void unsubscribe_blocks();
+
+      private:
+         void on_applied_block( const signed_block& b );
+         void schedule_push();
+         void push_blocks();
+
+         application&                          _app;
+         graphene::chain::database&            _db;
+         std::shared_ptr<block_export_buffer>  _buffer;
+         std::function<void(const variant&)>   _callback;
+         uint32_t                              _next_block = 0;
+         uint32_t                              _last_acknowledged = 0;
+         uint32_t                              _max_unacknowledged = 0;
+         bool                                  _push_scheduled = false;
+         boost::signals2::scoped_connection    _applied_block_connection;
+   };
 
    /**
     * @brief The network_broadcast_api class allows broadcasting of transactions.
@@ -392,6 +467,42 @@ namespace graphene { namespace app {
          application& _app;
    };
 
+   /**
+    * @brief the financing_api class exposes the KHC financing rollups of the khc_financing plugin.
+    */
+   class financing_api
+   {
+      public:
+         financing_api(application& app):_app(app){}
+
+         /**
+          * @brief Get the bucket sizes configured by the server.
+          * @return A list of bucket sizes in seconds
+          */
+         flat_set<uint32_t> get_financing_bucket_sizes()const;
+
+         /**
+          * @brief Get the totals of a public offering project and its progress toward the financing targets.
+          * @param asset_id ID of the project asset
+          * @return The project progress, or null if nothing was invested in the project yet
+          */
+         optional<financing_progress> get_financing_progress( asset_id_type asset_id )const;
+
+         /**
+          * @brief Get the financing activity of a project grouped into buckets.
+          * @param asset_id ID of the project asset
+          * @param bucket_seconds Bucket size, have to be one of configured values
+          * @param start Open time of the first bucket to retrieve
+          * @param end Open time of the last bucket to retrieve
+          * @return At most 200 buckets in ascending open time, buckets without activity are not returned
+          */
+         vector<financing_bucket_object> get_financing_history( asset_id_type asset_id, uint32_t bucket_seconds,
+                                                                fc::time_point_sec start, fc::time_point_sec end )const;
+
+      private:
+         application& _app;
+   };
+
    /**
     * @brief The login_api class implements the bottom layer of the RPC API
     *
@@ -415,6 +526,8 @@ namespace graphene { namespace app {
          bool login(const string& user, const string& password);
          /// @brief Retrieve the network block API
          fc::api<block_api> block()const;
+         /// @brief Retrieve the block export API
+         fc::api<block_export_api> block_export()const;
          /// @brief Retrieve the network broadcast API
          fc::api<network_broadcast_api> network_broadcast()const;
          /// @brief Retrieve the database API
@@ -429,6 +542,8 @@ namespace graphene { namespace app {
          fc::api<asset_api> asset()const;
          /// @brief Retrieve the orders API
          fc::api<orders_api> orders()const;
+         /// @brief Retrieve the financing API
+         fc::api<financing_api> financing()const;
          /// @brief Retrieve the debug API (if available)
          fc::api<graphene::debug_witness::debug_api> debug()const;
 
@@ -438,6 +553,7 @@ namespace graphene { namespace app {
 
          application& _app;
          optional< fc::api<block_api> > _block_api;
+         optional< fc::api<block_export_api> > _block_export_api;
          optional< fc::api<database_api> > _database_api;
          optional< fc::api<network_broadcast_api> > _network_broadcast_api;
          optional< fc::api<network_node_api> > _network_node_api;
@@ -445,6 +561,7 @@ namespace graphene { namespace app {
          optional< fc::api<crypto_api> > _crypto_api;
          optional< fc::api<asset_api> > _asset_api;
          optional< fc::api<orders_api> > _orders_api;
+         optional< fc::api<financing_api> > _financing_api;
          optional< fc::api<graphene::debug_witness::debug_api> > _debug_api;
    };
 
@@ -477,6 +594,13 @@ FC_API(graphene::app::history_api,
      )
 FC_API(graphene::app::block_api,
        (get_blocks)
+       (get_blocks_raw)
+     )
+FC_API(graphene::app::block_export_api,
+       (get_exported_blocks)
+       (subscribe_blocks)
+       (acknowledge)
+       (unsubscribe_blocks)
      )
 FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
@@ -512,9 +636,15 @@ FC_API(graphene::app::orders_api,
        (get_tracked_groups)
        (get_grouped_limit_orders)
      )
+FC_API(graphene::app::financing_api,
+       (get_financing_bucket_sizes)
+       (get_financing_progress)
+       (get_financing_history)
+     )
 FC_API(graphene::app::login_api,
        (login)
        (block)
+       (block_export)
        (network_broadcast)
        (database)
        (history)
@@ -522,5 +652,6 @@ FC_API(graphene::app::login_api,
        (crypto)
        (asset)
        (orders)
+       (financing)
        (debug)
      )
@@ -38,9 +38,33 @@ struct api_access_info
    std::vector< std::string > allowed_apis;
 };
 
+/**
+ * @brief Limits on the API calls a node accepts, applied per websocket connection and globally
+ *
+ * Every call costs default_cost tokens unless listed in method_costs. Each connection owns a token bucket
+ * holding up to burst tokens which refills at tokens_per_second; calls that do not find enough tokens are
+ * rejected. A zero limit disables the respective check. The node lowers costs above burst to burst when it
+ * loads the configuration, since such calls could never run.
+ */
+struct api_cost_limits
+{
+   uint32_t max_concurrent_calls_per_connection = 0;
+   uint32_t max_concurrent_calls = 0;
+   uint32_t tokens_per_second = 0;
+   uint32_t burst = 0;
+   uint32_t default_cost = 1;
+   std::map< std::string, uint32_t > method_costs;
+
+   bool enabled()const
+   {
+      return max_concurrent_calls_per_connection > 0 || max_concurrent_calls > 0 || tokens_per_second > 0;
+   }
+};
+
 struct api_access
 {
    std::map< std::string, api_access_info > permission_map;
+   api_cost_limits                          cost_limits;
 };
 
 } } // graphene::app
@@ -51,6 +75,16 @@ FC_REFLECT( graphene::app::api_access_info,
     (allowed_apis)
    )
 
+FC_REFLECT( graphene::app::api_cost_limits,
+    (max_concurrent_calls_per_connection)
+    (max_concurrent_calls)
+    (tokens_per_second)
+    (burst)
+    (default_cost)
+    (method_costs)
+   )
+
 FC_REFLECT( graphene::app::api_access,
     (permission_map)
+    (cost_limits)
    )
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/api_access.hpp>
+
+#include <fc/optional.hpp>
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace graphene { namespace app {
+
+   /**
+    * @brief Node wide part of API admission control, shared by all connections
+    */
+   class api_admission_control
+   {
+      public:
+         explicit api_admission_control( const api_cost_limits& limits );
+
+         const api_cost_limits& limits()const { return _limits; }
+
+         /// @return the number of tokens a call to method costs
+         uint32_t method_cost( const std::string& method )const;
+
+         /// @return false if the global concurrency limit has been reached
+         bool try_begin_call();
+         void end_call();
+
+      private:
+         api_cost_limits        _limits;
+         std::atomic<uint32_t>  _in_flight{0};
+   };
+
+   /**
+    * @brief Per connection token bucket and concurrency limit
+    *
+    * Every admitted call must be matched by a call to release() when it finishes.
+    */
+   class api_session_limiter
+   {
+      public:
+         explicit api_session_limiter( std::shared_ptr<api_admission_control> global );
+
+         /// @return the reason if the call has to be rejected, an invalid optional if it may proceed
+         fc::optional<std::string> admit( const std::string& method );
+         void release();
+
+      private:
+         void refill();
+
+         std::shared_ptr<api_admission_control> _global;
+         double                                 _tokens;
+         fc::time_point                         _last_refill;
+         uint32_t                               _in_flight = 0;
+   };
+
+} }
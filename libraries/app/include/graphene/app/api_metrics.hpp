@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace graphene { namespace chain { class database; } }
+
+namespace graphene { namespace app {
+
+   /**
+    * @brief A cumulative histogram with a fixed set of exponentially growing buckets
+    *
+    * Bucket upper bounds are 1, 4, 16, ... 4^(bucket_count-1) units; the last slot counts everything above.
+    */
+   class histogram
+   {
+      public:
+         static const size_t bucket_count = 12;
+
+         void     record( uint64_t value );
+         uint64_t count()const { return _count; }
+         uint64_t sum()const   { return _sum; }
+
+         static uint64_t bucket_bound( size_t i ) { return uint64_t(1) << ( 2 * i ); }
+         /// @return number of recorded values that are <= bucket_bound(i)
+         uint64_t cumulative_count( size_t i )const;
+
+      private:
+         std::array<uint64_t, bucket_count + 1> _buckets{};
+         uint64_t _count = 0;
+         uint64_t _sum = 0;
+   };
+
+   struct api_method_metrics
+   {
+      histogram   latency;         ///< microseconds
+      histogram   response_size;   ///< bytes
+      uint64_t    request_bytes = 0;
+      uint64_t    rejected = 0;
+   };
+
+   /**
+    * @brief Collects API call and chain processing statistics and renders them as Prometheus text
+    *
+    * All recording methods are safe to call from any thread.
+    */
+   class api_metrics
+   {
+      public:
+         void record_call( const std::string& method, const fc::microseconds& elapsed,
+                           size_t request_size, size_t response_size );
+         void record_rejected_call( const std::string& method );
+         void record_block_pushed( const fc::microseconds& elapsed );
+         void record_block_applied();
+
+         /// @return all metrics in the Prometheus text exposition format
+         std::string to_prometheus_text( const graphene::chain::database& db )const;
+
+      private:
+         /// must be called with _mutex held
+         api_method_metrics& method_metrics( const std::string& method );
+
+         mutable std::mutex                          _mutex;
+         std::map<std::string, api_method_metrics>   _methods;
+         histogram                                   _block_push_time;
+         uint64_t                                    _blocks_applied = 0;
+   };
+
+} }
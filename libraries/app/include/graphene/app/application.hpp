@@ -34,6 +34,7 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class block_export_buffer;
 
    class application_options
    {
@@ -99,6 +100,12 @@ namespace graphene { namespace app {
 
          const application_options& get_options();
 
+         /// @return the recent applied operations kept for block_export_api
+         std::shared_ptr<block_export_buffer> get_block_export_buffer()const;
+
+         /// Register a function returning Prometheus text lines which are appended to the metrics endpoint output
+         void add_metrics_provider( std::function<std::string()> provider );
+
       private:
          void enable_plugin( const string& name );
          void add_available_plugin( std::shared_ptr<abstract_plugin> p );
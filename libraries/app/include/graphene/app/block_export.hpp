@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/block.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <map>
+
+namespace graphene { namespace chain { class database; } }
+
+namespace graphene { namespace app {
+   using namespace graphene::chain;
+
+   /**
+    * @brief A block header together with every operation applied by that block, in application order
+    *
+    * When @ref virtual_ops_included is false the block was older than the node's export buffer, so
+    * @ref operations only holds the operations found in the block's transactions along with their results.
+    */
+   struct exported_block
+   {
+      uint32_t                          block_num = 0;
+      block_id_type                     block_id;
+      signed_block_header               header;
+      bool                              virtual_ops_included = false;
+      vector<operation_history_object>  operations;
+   };
+
+   /**
+    * @brief Keeps the applied operations, virtual ones included, of the most recent blocks
+    *
+    * The chain only exposes virtual operations while a block is being applied, so they are captured from the
+    * applied_block signal. Recording block N discards anything held for N and above, which drops the entries of
+    * blocks that were undone by a fork switch.
+    */
+   class block_export_buffer
+   {
+      public:
+         void     set_max_blocks( uint32_t n );
+         uint32_t max_blocks()const { return _max_blocks; }
+         size_t   size()const { return _blocks.size(); }
+
+         /// Must be called from the applied_block signal, while get_applied_operations() is still populated
+         void on_applied_block( const database& db, const signed_block& b );
+
+         /// @return the export of the given block, built from the buffer if possible and from the block log otherwise
+         optional<exported_block> fetch( const database& db, uint32_t block_num )const;
+
+      private:
+         struct recorded_block
+         {
+            block_id_type                     id;
+            vector<operation_history_object>  operations;
+         };
+
+         uint32_t                           _max_blocks = 0;
+         std::map<uint32_t,recorded_block>  _blocks;
+   };
+
+} }
+
+FC_REFLECT( graphene::app::exported_block,
+            (block_num)(block_id)(header)(virtual_ops_included)(operations) )
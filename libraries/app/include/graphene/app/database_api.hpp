@@ -112,6 +112,15 @@ struct market_trade
    account_id_type            side2_account_id = GRAPHENE_NULL_ACCOUNT;
 };
 
+struct account_power_rank_info
+{
+   account_id_type            account;
+   share_type                 total_power;
+   share_type                 available_power;
+   uint32_t                   total_power_rank = 0;     ///< 1 is the account with the most power
+   uint32_t                   available_power_rank = 0;
+};
+
 /**
  * @brief The database_api class implements the RPC API for the chain database.
  *
@@ -138,6 +147,16 @@ class database_api
        */
       fc::variants get_objects(const vector<object_id_type>& ids)const;
 
+      /**
+       * @brief Get the binary form of the objects corresponding to the provided IDs
+       * @param ids IDs of the objects to retrieve
+       * @return The fc::raw packed objects (hex encoded), in the order they are mentioned in ids
+       *
+       * If any of the provided IDs does not map to an object, a null is returned in its position.
+       * Unlike @ref get_objects, this does not subscribe to the objects.
+       */
+      vector<optional<vector<char>>> get_objects_raw(const vector<object_id_type>& ids)const;
+
       ///////////////////
       // Subscriptions //
       ///////////////////
@@ -696,6 +715,20 @@ class database_api
        */
       vector<asset_investment_object> list_account_investment(account_id_type account_id);
 
+      /** Get the accounts with the most power
+       *   @param by_available rank by available power (total power minus the locked power) instead of total power
+       *   @param start 0 based position of the first account to return, for pagination
+       *   @param limit Maximum number of accounts to return, must not exceed 101
+       *   @returns the accounts ordered by decreasing power
+       */
+      vector<account_power_rank_info> get_power_leaderboard(bool by_available, uint32_t start, uint32_t limit)const;
+
+      /** Get the power ranks of an account
+       *   @param account the id of the account
+       *   @returns the account power and ranks, or null if the account has no power
+       */
+      optional<account_power_rank_info> get_account_power_rank(account_id_type account)const;
+
    private:
       std::shared_ptr< database_api_impl > my;
 };
@@ -708,10 +741,13 @@ FC_REFLECT( graphene::app::market_ticker,
             (time)(base)(quote)(latest)(lowest_ask)(highest_bid)(percent_change)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_volume, (time)(base)(quote)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_trade, (sequence)(date)(price)(amount)(value)(side1_account_id)(side2_account_id) );
+FC_REFLECT( graphene::app::account_power_rank_info,
+            (account)(total_power)(available_power)(total_power_rank)(available_power_rank) );
 
 FC_API(graphene::app::database_api,
    // Objects
    (get_objects)
+   (get_objects_raw)
 
    // Subscriptions
    (set_subscribe_callback)
@@ -747,6 +783,8 @@ FC_API(graphene::app::database_api,
    (get_account_count)
    (get_account_power)
    (list_account_investment)
+   (get_power_leaderboard)
+   (get_account_power_rank)
 
    // Balances
    (get_account_balances)
@@ -24,6 +24,7 @@
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <fc/uint128.hpp>
 
@@ -267,4 +268,142 @@ void account_referrer_index::object_modified( const object& after  )
 {
 }
 
+void account_authority_cache_index::object_removed( const object& obj )
+{
+   _cache.clear();
+}
+
+void account_authority_cache_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const account_object*>(&before) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(before);
+   _before_owner = a.owner;
+   _before_active = a.active;
+}
+
+void account_authority_cache_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const account_object*>(&after) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(after);
+   if( !(a.owner == _before_owner) || !(a.active == _before_active) )
+      _cache.clear();
+}
+
+void account_power_rank_index::object_inserted( const object& obj )
+{
+   if( obj.id.space() != implementation_ids )
+      return;
+   switch( obj.id.type() )
+   {
+      case impl_account_power_object_type:
+      {
+         const auto& p = static_cast<const account_power_object&>( obj );
+         adjust( p.owner, p.power_value, 0 );
+         break;
+      }
+      case impl_account_locked_power_object_type:
+      {
+         const auto& l = static_cast<const account_locked_power_object&>( obj );
+         add_locked( l.id, locked_entry{ l.owner, l.power_value, l.unlock_height } );
+         break;
+      }
+      case impl_dynamic_global_property_object_type:
+         set_head_block_num( static_cast<const dynamic_global_property_object&>( obj ).head_block_number );
+         break;
+      default:
+         break;
+   }
+}
+
+void account_power_rank_index::object_removed( const object& obj )
+{
+   if( obj.id.space() != implementation_ids )
+      return;
+   switch( obj.id.type() )
+   {
+      case impl_account_power_object_type:
+      {
+         const auto& p = static_cast<const account_power_object&>( obj );
+         adjust( p.owner, -p.power_value, 0 );
+         break;
+      }
+      case impl_account_locked_power_object_type:
+         remove_locked( obj.id );
+         break;
+      default:
+         break;
+   }
+}
+
+void account_power_rank_index::about_to_modify( const object& before )
+{
+   // the head block number is taken from the modified object alone
+   if( before.id.space() == implementation_ids && before.id.type() != impl_dynamic_global_property_object_type )
+      object_removed( before );
+}
+
+void account_power_rank_index::object_modified( const object& after  )
+{
+   object_inserted( after );
+}
+
+void account_power_rank_index::adjust( account_id_type account, share_type total_delta, share_type locked_delta )
+{
+   if( total_delta == 0 && locked_delta == 0 )
+      return;
+   auto& idx = _ranks.get<by_power_account>();
+   auto itr = idx.find( account );
+   if( itr == idx.end() )
+   {
+      _ranks.insert( account_power_rank{ account, total_delta, locked_delta } );
+      return;
+   }
+   if( itr->total_power + total_delta == 0 && itr->locked_power + locked_delta == 0 )
+   {
+      idx.erase( itr );
+      return;
+   }
+   idx.modify( itr, [&]( account_power_rank& r ) {
+      r.total_power += total_delta;
+      r.locked_power += locked_delta;
+   });
+}
+
+void account_power_rank_index::add_locked( const object_id_type& id, const locked_entry& entry )
+{
+   _locked[id] = entry;
+   _locked_by_height.insert( std::make_pair( entry.unlock_height, id ) );
+   if( entry.unlock_height > _head_block_num )
+      adjust( entry.owner, 0, entry.value );
+}
+
+void account_power_rank_index::remove_locked( const object_id_type& id )
+{
+   auto itr = _locked.find( id );
+   if( itr == _locked.end() )
+      return;
+   if( itr->second.unlock_height > _head_block_num )
+      adjust( itr->second.owner, 0, -itr->second.value );
+   _locked_by_height.erase( std::make_pair( itr->second.unlock_height, id ) );
+   _locked.erase( itr );
+}
+
+void account_power_rank_index::set_head_block_num( uint32_t head_block_num )
+{
+   if( head_block_num == _head_block_num )
+      return;
+
+   // locks with an unlock height between the old and the new head change state
+   const uint32_t low = std::min( head_block_num, _head_block_num );
+   const uint32_t high = std::max( head_block_num, _head_block_num );
+   const share_type sign = ( head_block_num > _head_block_num ? -1 : 1 );
+   auto itr = _locked_by_height.lower_bound( std::make_pair( share_type( int64_t(low) + 1 ), object_id_type() ) );
+   for( ; itr != _locked_by_height.end() && itr->first <= int64_t(high); ++itr )
+   {
+      const locked_entry& entry = _locked.at( itr->second );
+      adjust( entry.owner, 0, sign * entry.value );
+   }
+   _head_block_num = head_block_num;
+}
+
 } } // graphene::chain
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/apply_profiler.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+namespace detail {
+
+   struct operation_name_visitor
+   {
+      typedef std::string result_type;
+
+      template<typename Type>
+      result_type operator()( const Type& )const
+      {
+         std::string name = fc::get_typename<Type>::name();
+         size_t p = name.rfind(':');
+         if( p != std::string::npos )
+            name = name.substr( p+1 );
+         return name;
+      }
+   };
+
+   std::string operation_name( int which )
+   {
+      operation op;
+      if( which < 0 || which >= op.count() )
+         return "unknown";
+      op.set_which( which );
+      return op.visit( operation_name_visitor() );
+   }
+
+}
+
+void apply_timing::record( int64_t us )
+{
+   const uint64_t value = us > 0 ? us : 0;
+   ++count;
+   total_us += value;
+   max_us = std::max( max_us, value );
+}
+
+void apply_timing::merge( const apply_timing& other )
+{
+   count += other.count;
+   total_us += other.total_us;
+   max_us = std::max( max_us, other.max_us );
+}
+
+const char* apply_profiler::phase_name( apply_block_phase phase )
+{
+   switch( phase )
+   {
+      case phase_transactions:                   return "transactions";
+      case phase_update_global_dynamic_data:     return "update_global_dynamic_data";
+      case phase_update_signing_witness:         return "update_signing_witness";
+      case phase_update_last_irreversible_block: return "update_last_irreversible_block";
+      case phase_chain_maintenance:              return "perform_chain_maintenance";
+      case phase_create_block_summary:           return "create_block_summary";
+      case phase_clear_expired_transactions:     return "clear_expired_transactions";
+      case phase_clear_expired_proposals:        return "clear_expired_proposals";
+      case phase_clear_expired_orders:           return "clear_expired_orders";
+      case phase_update_expired_feeds:           return "update_expired_feeds";
+      case phase_update_withdraw_permissions:    return "update_withdraw_permissions";
+      case phase_update_witness_schedule:        return "update_witness_schedule";
+      case phase_notify_applied_block:           return "notify_applied_block";
+      case phase_notify_changed_objects:         return "notify_changed_objects";
+      default:                                   return "unknown";
+   }
+}
+
+const char* apply_profiler::expiration_name( expiration_kind kind )
+{
+   switch( kind )
+   {
+      case expired_transactions:         return "transactions";
+      case expired_proposals:            return "proposals";
+      case expired_limit_orders:         return "limit_orders";
+      case expired_force_settlements:    return "force_settlements";
+      case expired_withdraw_permissions: return "withdraw_permissions";
+      default:                           return "unknown";
+   }
+}
+
+void apply_profiler::record_operation( int which, const fc::microseconds& evaluate, const fc::microseconds& apply )
+{
+   operation_timing& t = _block_operations[which];
+   t.evaluate.record( evaluate.count() );
+   t.apply.record( apply.count() );
+}
+
+void apply_profiler::finish_block( uint32_t block_num, int64_t block_us,
+                                   const std::array<int64_t, apply_block_phase_count>& phases )
+{
+   const int64_t threshold = _slow_block_us;
+   const bool slow = threshold > 0 && block_us >= threshold;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _blocks.record( block_us );
+      for( size_t i = 0; i < phases.size(); ++i )
+      {
+         // maintenance only runs on some blocks, do not count the others
+         if( i == phase_chain_maintenance && phases[i] == 0 )
+            continue;
+         _phases[i].record( phases[i] );
+      }
+      for( const auto& op : _block_operations )
+      {
+         operation_timing& t = _operations[op.first];
+         t.evaluate.merge( op.second.evaluate );
+         t.apply.merge( op.second.apply );
+      }
+      for( size_t i = 0; i < _block_expirations.size(); ++i )
+      {
+         const uint32_t n = _block_expirations[i];
+         if( n == 0 )
+            continue;
+         expiration_stats& e = _expirations[i];
+         e.total += n;
+         ++e.blocks;
+         e.max_per_block = std::max<uint64_t>( e.max_per_block, n );
+      }
+      if( slow )
+         ++_slow_blocks;
+   }
+
+   if( slow )
+   {
+      fc::mutable_variant_object phase_us;
+      for( size_t i = 0; i < phases.size(); ++i )
+         if( phases[i] > 0 )
+            phase_us( phase_name( apply_block_phase(i) ), phases[i] );
+      fc::mutable_variant_object operation_us;
+      for( const auto& op : _block_operations )
+         operation_us( detail::operation_name( op.first ),
+                       fc::mutable_variant_object( "count", op.second.evaluate.count )
+                                                 ( "evaluate", op.second.evaluate.total_us )
+                                                 ( "apply", op.second.apply.total_us ) );
+      fc::mutable_variant_object expired;
+      for( size_t i = 0; i < _block_expirations.size(); ++i )
+         if( _block_expirations[i] > 0 )
+            expired( expiration_name( expiration_kind(i) ), _block_expirations[i] );
+      wlog( "Block ${n} took ${t} us to apply, phases: ${p}, operations: ${o}, expired: ${e}",
+            ("n",block_num)("t",block_us)("p",phase_us)("o",operation_us)("e",expired) );
+   }
+   _block_operations.clear();
+   _block_expirations.fill( 0 );
+}
+
+apply_profile apply_profiler::get_profile()const
+{
+   apply_profile result;
+   result.enabled = _enabled;
+   result.slow_block_threshold_us = _slow_block_us;
+
+   std::lock_guard<std::mutex> guard( _mutex );
+   result.slow_blocks = _slow_blocks;
+   result.blocks = _blocks;
+   result.operations.reserve( _operations.size() );
+   for( const auto& op : _operations )
+   {
+      operation_apply_stats s;
+      s.which = op.first;
+      s.name = detail::operation_name( op.first );
+      s.evaluate = op.second.evaluate;
+      s.apply = op.second.apply;
+      result.operations.push_back( std::move( s ) );
+   }
+   result.phases.reserve( _phases.size() );
+   for( size_t i = 0; i < _phases.size(); ++i )
+      result.phases.push_back( phase_apply_stats{ phase_name( apply_block_phase(i) ), _phases[i] } );
+   result.expirations.reserve( _expirations.size() );
+   for( size_t i = 0; i < _expirations.size(); ++i )
+   {
+      result.expirations.push_back( _expirations[i] );
+      result.expirations.back().name = expiration_name( expiration_kind(i) );
+   }
+   return result;
+}
+
+void apply_profiler::reset()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _operations.clear();
+   _phases = std::array<apply_timing, apply_block_phase_count>();
+   _expirations = std::array<expiration_stats, expiration_kind_count>();
+   _blocks = apply_timing();
+   _slow_blocks = 0;
+}
+
+apply_profiler::block_timer::block_timer( apply_profiler& p )
+   : _profiler( p ), _active( p.enabled() )
+{
+   if( !_active )
+      return;
+   _profiler._block_operations.clear();
+   _profiler._block_expirations.fill( 0 );
+   _profiler._recording = true;
+   _block_start = fc::time_point::now();
+   _phase_start = _block_start;
+}
+
+apply_profiler::block_timer::~block_timer()
+{
+   if( _active )
+   {
+      _profiler._recording = false;
+      _profiler._block_operations.clear();
+      _profiler._block_expirations.fill( 0 );
+   }
+}
+
+void apply_profiler::block_timer::end_phase( apply_block_phase phase )
+{
+   if( !_active )
+      return;
+   const fc::time_point now = fc::time_point::now();
+   _phases[phase] += ( now - _phase_start ).count();
+   _phase_start = now;
+}
+
+void apply_profiler::block_timer::finish( uint32_t block_num )
+{
+   if( !_active )
+      return;
+   _profiler._recording = false;
+   _profiler.finish_block( block_num, ( fc::time_point::now() - _block_start ).count(), _phases );
+   _active = false;
+}
+
+} } // graphene::chain
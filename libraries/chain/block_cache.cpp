@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/block_cache.hpp>
+#include <graphene/chain/protocol/fee_schedule.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+namespace graphene { namespace chain {
+
+void block_cache::set_max_size( size_t s )
+{
+   _max_size = s;
+   while( _blocks.size() > _max_size )
+   {
+      _blocks.erase( _lru.back() );
+      _lru.pop_back();
+   }
+}
+
+void block_cache::insert( const signed_block& b )
+{
+   if( _max_size == 0 )
+      return;
+   insert( std::make_shared<const signed_block>( b ) );
+}
+
+void block_cache::insert( shared_ptr<const signed_block> b )
+{
+   if( _max_size == 0 )
+      return;
+
+   const uint32_t num = b->block_num();
+   remove_from( num );
+   add( num, std::move( b ) );
+}
+
+void block_cache::fill( shared_ptr<const signed_block> b )
+{
+   if( _max_size == 0 )
+      return;
+
+   const uint32_t num = b->block_num();
+   if( _blocks.find( num ) != _blocks.end() )
+      return;
+   add( num, std::move( b ) );
+}
+
+void block_cache::add( uint32_t num, shared_ptr<const signed_block> b )
+{
+   _lru.push_front( num );
+   cached_block& entry = _blocks[num];
+   entry.id = b->id();
+   entry.block = std::move( b );
+   entry.lru_position = _lru.begin();
+
+   if( _blocks.size() > _max_size )
+   {
+      _blocks.erase( _lru.back() );
+      _lru.pop_back();
+   }
+}
+
+void block_cache::remove_from( uint32_t num )
+{
+   auto itr = _blocks.lower_bound( num );
+   while( itr != _blocks.end() )
+   {
+      _lru.erase( itr->second.lru_position );
+      itr = _blocks.erase( itr );
+   }
+}
+
+void block_cache::clear()
+{
+   _blocks.clear();
+   _lru.clear();
+}
+
+void block_cache::touch( cached_block& entry )const
+{
+   _lru.splice( _lru.begin(), _lru, entry.lru_position );
+}
+
+shared_ptr<const signed_block> block_cache::fetch( uint32_t num )const
+{
+   auto itr = _blocks.find( num );
+   if( itr == _blocks.end() )
+      return shared_ptr<const signed_block>();
+   touch( itr->second );
+   return itr->second.block;
+}
+
+shared_ptr<const vector<char>> block_cache::fetch_packed( uint32_t num )const
+{
+   auto itr = _blocks.find( num );
+   if( itr == _blocks.end() )
+      return shared_ptr<const vector<char>>();
+   touch( itr->second );
+   if( !itr->second.packed )
+      itr->second.packed = std::make_shared<const vector<char>>( fc::raw::pack( *itr->second.block ) );
+   return itr->second.packed;
+}
+
+shared_ptr<const signed_block> block_cache::fetch_by_id( const block_id_type& id )const
+{
+   auto itr = _blocks.find( block_header::num_from_id( id ) );
+   if( itr == _blocks.end() || itr->second.id != id )
+      return shared_ptr<const signed_block>();
+   touch( itr->second );
+   return itr->second.block;
+}
+
+} }
@@ -206,6 +206,35 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+optional<vector<char>> block_database::fetch_raw_by_number( uint32_t block_num )const
+{
+   try
+   {
+      index_entry e;
+      int64_t index_pos = sizeof(e) * int64_t(block_num);
+      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+      if ( _block_num_to_pos.tellg() <= index_pos )
+         return {};
+
+      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
+      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+      if( e.block_size == 0 )
+         return {};
+
+      vector<char> data( e.block_size );
+      _blocks.seekg( e.block_pos );
+      _blocks.read( data.data(), e.block_size );
+      return data;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<vector<char>>();
+}
+
 optional<index_entry> block_database::last_index_entry()const {
    try
    {
@@ -32,4 +32,5 @@
 #include "db_market.cpp"
 #include "db_update.cpp"
 #include "db_witness_schedule.cpp"
-#include "db_notify.cpp"
\ No newline at end of file
+#include "db_notify.cpp"
+#include "db_snapshot.cpp"
\ No newline at end of file
@@ -63,6 +63,9 @@ block_id_type  database::get_block_id_for_num( uint32_t block_num )const
 
 optional<signed_block> database::fetch_block_by_id( const block_id_type& id )const
 {
+   auto cached = _block_cache.fetch_by_id( id );
+   if( cached )
+      return *cached;
    auto b = _fork_db.fetch_block( id );
    if( !b )
       return _block_id_to_block.fetch_optional(id);
@@ -71,20 +74,50 @@ optional<signed_block> database::fetch_block_by_id( const block_id_type& id )con
 
 optional<signed_block> database::fetch_block_by_number( uint32_t num )const
 {
+   if( num > head_block_num() )
+   {
+      auto results = _fork_db.fetch_block_by_number(num);
+      if( results.size() == 1 )
+         return results[0]->data;
+      return _block_id_to_block.fetch_by_number(num);
+   }
+
+   auto cached = _block_cache.fetch( num );
+   if( cached )
+      return *cached;
+   // cache the block of the current chain that was missed, popping or replacing it drops it again
    auto results = _fork_db.fetch_block_by_number(num);
    if( results.size() == 1 )
+   {
+      _block_cache.fill( results[0]->block );
       return results[0]->data;
-   else
-      return _block_id_to_block.fetch_by_number(num);
-   return optional<signed_block>();
+   }
+   optional<signed_block> b = _block_id_to_block.fetch_by_number(num);
+   if( b.valid() )
+      _block_cache.fill( std::make_shared<const signed_block>( *b ) );
+   return b;
+}
+
+optional<vector<char>> database::fetch_raw_block_by_number( uint32_t num )const
+{
+   if( num <= head_block_num() )
+   {
+      auto cached = _block_cache.fetch_packed( num );
+      if( cached )
+         return *cached;
+   }
+   auto results = _fork_db.fetch_block_by_number(num);
+   if( results.size() == 1 )
+      return fc::raw::pack( results[0]->data );
+   return _block_id_to_block.fetch_raw_by_number(num);
 }
 
-const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
+signed_transaction database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
-   auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
-   auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
-   return itr->trx;
+   FC_ASSERT( is_known_transaction( trx_id ) );
+   auto trx = _recent_transactions.fetch( trx_id );
+   FC_ASSERT( trx, "Transaction ${id} is no longer cached", ("id",trx_id) );
+   return *trx;
 }
 
 std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of_fork) const
@@ -129,6 +162,16 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
 bool database::_push_block(const signed_block& new_block)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
+   // Check the merkle root once, before the block enters the fork database.  Every block in there has passed
+   // the check, so it is not repeated when the block is applied, including when switching forks.
+   if( !(skip & skip_merkle_check) )
+   {
+      const checksum_type merkle_root = new_block.calculate_merkle_root();
+      FC_ASSERT( new_block.transaction_merkle_root == merkle_root, "",
+                 ("next_block.transaction_merkle_root",new_block.transaction_merkle_root)("calc",merkle_root)
+                 ("next_block",new_block)("id",new_block.id()) );
+      skip |= skip_merkle_check;
+   }
    if( !(skip&skip_fork_db) )
    {
       /// TODO: if the block is greater than the head block and before the next maitenance interval
@@ -184,12 +227,15 @@ bool database::_push_block(const signed_block& new_block)
                    }
 
                    ilog( "Switching back to fork: ${id}", ("id",branches.second.front()->data.id()) );
-                   // restore all blocks from the good fork
+                   // restore all blocks from the good fork, they were applied to the same state before, so
+                   // the checks that do not change the state are not repeated
+                   const uint32_t restore_skip = skip | skip_witness_signature | skip_transaction_signatures
+                                                      | skip_authority_check | skip_merkle_check | skip_block_size_check;
                    for( auto ritr2 = branches.second.rbegin(); ritr2 != branches.second.rend(); ++ritr2 )
                    {
                       ilog( "pushing block #${n} ${id}", ("n",(*ritr2)->data.block_num())("id",(*ritr2)->id) );
                       auto session = _undo_db.start_undo_session();
-                      apply_block( (*ritr2)->data, skip );
+                      apply_block( (*ritr2)->data, restore_skip );
                       _block_id_to_block.store( (*ritr2)->id, (*ritr2)->data );
                       session.commit();
                    }
@@ -415,7 +461,8 @@ signed_block database::_generate_block(
       FC_ASSERT( fc::raw::pack_size(pending_block) <= get_global_properties().parameters.maximum_block_size );
    }
 
-   push_block( pending_block, skip );
+   // the merkle root was calculated above
+   push_block( pending_block, skip | skip_merkle_check );
 
    return pending_block;
 } FC_CAPTURE_AND_RETHROW( (witness_id) ) }
@@ -432,6 +479,7 @@ void database::pop_block()
    GRAPHENE_ASSERT( head_block.valid(), pop_empty_chain, "there are no blocks to pop" );
 
    _fork_db.pop_block();
+   _block_cache.remove_from( head_block->block_num() );
    pop_undo();
 
    _popped_tx.insert( _popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end() );
@@ -498,8 +546,13 @@ void database::_apply_block( const signed_block& next_block )
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
+   _authority_cache.clear();
 
-   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
+   if( !(skip & skip_merkle_check) )
+   {
+      const checksum_type merkle_root = next_block.calculate_merkle_root();
+      FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",next_block.id()) );
+   }
 
    const witness_object& signing_witness = validate_block_header(skip, next_block);
    const auto& global_props = get_global_properties();
@@ -509,6 +562,8 @@ void database::_apply_block( const signed_block& next_block )
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
 
+   apply_profiler::block_timer timer( _apply_profiler );
+
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -520,21 +575,35 @@ void database::_apply_block( const signed_block& next_block )
       apply_transaction( trx, skip );
       ++_current_trx_in_block;
    }
+   timer.end_phase( phase_transactions );
 
    update_global_dynamic_data(next_block);
+   timer.end_phase( phase_update_global_dynamic_data );
    update_signing_witness(signing_witness, next_block);
+   timer.end_phase( phase_update_signing_witness );
    update_last_irreversible_block();
+   timer.end_phase( phase_update_last_irreversible_block );
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
       perform_chain_maintenance(next_block, global_props);
+      timer.end_phase( phase_chain_maintenance );
+   }
 
    create_block_summary(next_block);
+   timer.end_phase( phase_create_block_summary );
+   _expiration_scheduler.advance( head_block_time() );
    clear_expired_transactions();
+   timer.end_phase( phase_clear_expired_transactions );
    clear_expired_proposals();
+   timer.end_phase( phase_clear_expired_proposals );
    clear_expired_orders();
+   timer.end_phase( phase_clear_expired_orders );
    update_expired_feeds();
+   timer.end_phase( phase_update_expired_feeds );
    update_withdraw_permissions();
+   timer.end_phase( phase_update_withdraw_permissions );
 
    // n.b., update_maintenance_flag() happens this late
    // because get_slot_time() / get_slot_at_time() is needed above
@@ -545,12 +614,18 @@ void database::_apply_block( const signed_block& next_block )
    update_witness_schedule();
    if( !_node_property_object.debug_updates.empty() )
       apply_debug_updates();
+   // the maintenance flag and debug updates are cheap, they are charged to the witness schedule
+   timer.end_phase( phase_update_witness_schedule );
 
    // notify observers that the block has been applied
    notify_applied_block( next_block ); //emit
    _applied_ops.clear();
+   timer.end_phase( phase_notify_applied_block );
 
    notify_changed_objects();
+   _recent_transactions.remove_expired( head_block_time() );
+   timer.end_phase( phase_notify_changed_objects );
+   timer.finish( next_block_num );
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 
@@ -585,7 +660,8 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       auto get_active = [&]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [&]( account_id_type id ) { return &id(*this).owner;  };
-      trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth );
+      trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth,
+                            &_authority_cache );
    }
 
    //Skip all manner of expiration and TaPoS checking if we're on block 1; It's impossible that the transaction is
@@ -612,7 +688,7 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
-         transaction.trx = trx;
+         transaction.expiration = trx.expiration;
       });
    }
 
@@ -636,6 +712,9 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
       std::for_each(range.first, range.second, [](const account_balance_object& b) { FC_ASSERT(b.balance == 0); });
    }
 
+   if( !(skip & skip_transaction_dupe_check) )
+      _recent_transactions.insert( trx_id, trx );
+
    return ptrx;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
 
@@ -57,6 +57,13 @@ const fee_schedule&  database::current_fee_schedule()const
    return get_global_properties().parameters.current_fees;
 }
 
+const fee_table& database::current_fee_table()const
+{
+   if( _fee_table.empty() )
+      _fee_table.reset( current_fee_schedule() );
+   return _fee_table;
+}
+
 time_point_sec database::head_block_time()const
 {
    return get( dynamic_global_property_id_type() ).time;
@@ -193,6 +193,7 @@ void database::initialize_evaluators()
 void database::initialize_indexes()
 {
    reset_indexes();
+   _expiration_scheduler.clear();
    _undo_db.set_max_size( GRAPHENE_MIN_UNDO_HISTORY );
 
    //Protocol object indexes
@@ -202,30 +203,39 @@ void database::initialize_indexes()
    auto acnt_index = add_index< primary_index<account_index> >();
    acnt_index->add_secondary_index<account_member_index>();
    acnt_index->add_secondary_index<account_referrer_index>();
+   acnt_index->add_secondary_index<account_authority_cache_index>( std::ref( _authority_cache ) );
 
    add_index< primary_index<committee_member_index> >();
    add_index< primary_index<witness_index> >();
-   add_index< primary_index<limit_order_index > >();
+   auto limit_index = add_index< primary_index<limit_order_index > >();
+   limit_index->add_secondary_index<expiration_schedule_index>( std::ref( _expiration_scheduler ) );
    add_index< primary_index<call_order_index > >();
 
    auto prop_index = add_index< primary_index<proposal_index > >();
    prop_index->add_secondary_index<required_approval_index>();
+   prop_index->add_secondary_index<expiration_schedule_index>( std::ref( _expiration_scheduler ) );
 
-   add_index< primary_index<withdraw_permission_index > >();
+   auto permit_index = add_index< primary_index<withdraw_permission_index > >();
+   permit_index->add_secondary_index<expiration_schedule_index>( std::ref( _expiration_scheduler ) );
    add_index< primary_index<vesting_balance_index> >();
    add_index< primary_index<worker_index> >();
    add_index< primary_index<balance_index> >();
    add_index< primary_index<blinded_balance_index> >();
 
    //Implementation object indexes
-   add_index< primary_index<transaction_index                             > >();
+   auto trx_index = add_index< primary_index<transaction_index                             > >();
+   trx_index->add_secondary_index<expiration_schedule_index>( std::ref( _expiration_scheduler ) );
    add_index< primary_index<account_balance_index                         > >();
-   add_index< primary_index<account_power_index                         > >();
-   add_index< primary_index<account_locked_power_index            > >();
+   auto power_index = add_index< primary_index<account_power_index                         > >();
+   auto power_rank_index = power_index->add_secondary_index<account_power_rank_index>();
+   auto locked_power_index = add_index< primary_index<account_locked_power_index            > >();
+   locked_power_index->add_secondary_index<account_power_rank_forwarder>( power_rank_index );
    add_index< primary_index<asset_investment_index                        > >();
    add_index< primary_index<asset_bitasset_data_index                     > >();
-   add_index< primary_index<simple_index<global_property_object          >> >();
-   add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
+   auto gpo_index = add_index< primary_index<simple_index<global_property_object          >> >();
+   gpo_index->add_secondary_index<fee_table_index>( std::ref( _fee_table ) );
+   auto dgp_index = add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
+   dgp_index->add_secondary_index<account_power_rank_forwarder>( power_rank_index );
    add_index< primary_index<simple_index<account_statistics_object       >> >();
    add_index< primary_index<simple_index<asset_dynamic_data_object       >> >();
    add_index< primary_index<simple_index<block_summary_object            >> >();
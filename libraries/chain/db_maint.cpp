@@ -46,6 +46,9 @@
 #include <graphene/chain/witness_object.hpp>
 #include <graphene/chain/worker_object.hpp>
 
+#include <exception>
+#include <thread>
+
 namespace graphene { namespace chain {
 
 template<class Index>
@@ -72,6 +75,96 @@ vector<std::reference_wrapper<const typename Index::object_type>> database::sort
    return refs;
 }
 
+namespace detail {
+
+   /// below this many accounts per thread, starting threads costs more than the tally
+   const size_t min_accounts_per_tally_thread = 4096;
+
+   /// Votes and stake counted for a set of accounts; tallies of disjoint sets add up to the tally of their union
+   struct vote_tally
+   {
+      vector<uint64_t>  votes;
+      vector<uint64_t>  witness_count_histogram;
+      vector<uint64_t>  committee_count_histogram;
+      uint64_t          total_voting_stake = 0;
+
+      explicit vote_tally( const global_property_object& props )
+         : votes( props.next_available_vote_id ),
+           witness_count_histogram( props.parameters.maximum_witness_count / 2 + 1 ),
+           committee_count_histogram( props.parameters.maximum_committee_count / 2 + 1 ) {}
+
+      void add( const database& d, const global_property_object& props,
+                const account_object& stake_account, uint64_t voting_stake )
+      {
+         // There may be a difference between the account whose stake is voting and the one specifying opinions.
+         // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
+         // specifying the opinions.
+         const account_object& opinion_account =
+               (stake_account.options.voting_account ==
+                GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
+                                  : d.get(stake_account.options.voting_account);
+
+         for( vote_id_type id : opinion_account.options.votes )
+         {
+            uint32_t offset = id.instance();
+            // if they somehow managed to specify an illegal offset, ignore it.
+            if( offset < votes.size() )
+               votes[offset] += voting_stake;
+         }
+
+         if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
+                                       witness_count_histogram.size() - 1);
+            // votes for a number greater than maximum_witness_count
+            // are turned into votes for maximum_witness_count.
+            //
+            // in particular, this takes care of the case where a
+            // member was voting for a high number, then the
+            // parameter was lowered.
+            witness_count_histogram[offset] += voting_stake;
+         }
+         if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
+                                       committee_count_histogram.size() - 1);
+            // votes for a number greater than maximum_committee_count
+            // are turned into votes for maximum_committee_count.
+            //
+            // same rationale as for witnesses
+            committee_count_histogram[offset] += voting_stake;
+         }
+
+         total_voting_stake += voting_stake;
+      }
+
+      void merge( const vote_tally& other )
+      {
+         for( size_t i = 0; i < votes.size(); ++i )
+            votes[i] += other.votes[i];
+         for( size_t i = 0; i < witness_count_histogram.size(); ++i )
+            witness_count_histogram[i] += other.witness_count_histogram[i];
+         for( size_t i = 0; i < committee_count_histogram.size(); ++i )
+            committee_count_histogram[i] += other.committee_count_histogram[i];
+         total_voting_stake += other.total_voting_stake;
+      }
+   };
+
+   bool counts_votes( const database& d, const global_property_object& props, const account_object& stake_account )
+   {
+      return props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time());
+   }
+
+   uint64_t voting_stake( const database& d, const account_object& stake_account )
+   {
+      const auto& stats = stake_account.statistics(d);
+      return stats.total_core_in_orders.value
+            + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
+            + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
+   }
+
+}
+
 template<class... Types>
 void database::perform_account_maintenance(std::tuple<Types...> helpers)
 {
@@ -1106,87 +1199,108 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    distribute_fba_balances(*this);
    create_buyback_orders(*this);
 
-   struct vote_tally_helper {
-      database& d;
-      const global_property_object& props;
-
-      vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
-      {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._total_voting_stake = 0;
-      }
-
-      void operator()(const account_object& stake_account) {
-         if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
+   // The tally only reads the database, so shards of accounts are tallied on separate threads and their sums are
+   // added up afterwards; the sums do not depend on how the accounts were split. Fee processing stays sequential.
+   // It deposits cashback into referrers and registrars, and in a single interleaved pass those deposits were
+   // already counted for accounts later in name order, so such accounts are re-tallied when the fee pass reaches them.
+   const auto& account_idx = get_index_type<account_index>().indices().get<by_name>();
+   vector<const account_object*> accounts;
+   accounts.reserve( account_idx.size() );
+   uint64_t account_count = 0;
+   for( const account_object& a : account_idx )
+   {
+      accounts.push_back( &a );
+      account_count = std::max( account_count, a.id.instance() + 1 );
+   }
+   // the stake each account was tallied with, by account instance
+   vector<uint64_t> tallied_stake( account_count );
+
+   uint32_t thread_count = _maintenance_threads;
+   if( thread_count == 0 )
+      thread_count = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ),
+                                       accounts.size() / detail::min_accounts_per_tally_thread );
+   thread_count = std::max<size_t>( 1, std::min<size_t>( thread_count, accounts.size() ) );
+
+   vector<detail::vote_tally> shards( thread_count, detail::vote_tally( gpo ) );
+   vector<std::exception_ptr> errors( thread_count );
+   auto tally_shard = [&]( uint32_t shard ) {
+      try {
+         const size_t begin = accounts.size() * shard / thread_count;
+         const size_t end = accounts.size() * ( shard + 1 ) / thread_count;
+         for( size_t i = begin; i < end; ++i )
          {
-            // There may be a difference between the account whose stake is voting and the one specifying opinions.
-            // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
-            // specifying the opinions.
-            const account_object& opinion_account =
-                  (stake_account.options.voting_account ==
-                   GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
-                                     : d.get(stake_account.options.voting_account);
-
-            const auto& stats = stake_account.statistics(d);
-            uint64_t voting_stake = stats.total_core_in_orders.value
-                  + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
-                  + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
-
-            for( vote_id_type id : opinion_account.options.votes )
-            {
-               uint32_t offset = id.instance();
-               // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
-            }
-
-            if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_witness_count
-               // are turned into votes for maximum_witness_count.
-               //
-               // in particular, this takes care of the case where a
-               // member was voting for a high number, then the
-               // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
-            }
-            if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_committee_count
-               // are turned into votes for maximum_committee_count.
-               //
-               // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
-            }
-
-            d._total_voting_stake += voting_stake;
+            const account_object& stake_account = *accounts[i];
+            if( !detail::counts_votes( *this, gpo, stake_account ) )
+               continue;
+            const uint64_t voting_stake = detail::voting_stake( *this, stake_account );
+            tallied_stake[stake_account.id.instance()] = voting_stake;
+            shards[shard].add( *this, gpo, stake_account, voting_stake );
          }
+      } catch( ... ) {
+         errors[shard] = std::current_exception();
       }
-   } tally_helper(*this, gpo);
+   };
+   vector<std::thread> threads;
+   for( uint32_t i = 1; i < thread_count; ++i )
+      threads.emplace_back( tally_shard, i );
+   tally_shard( 0 );
+   for( auto& t : threads )
+      t.join();
+   // every shard stops at its first failure, so this is the exception the sequential tally would have thrown
+   for( const auto& e : errors )
+      if( e )
+         std::rethrow_exception( e );
+
+   detail::vote_tally& tally = shards.front();
+   for( size_t i = 1; i < shards.size(); ++i )
+      tally.merge( shards[i] );
+
    struct process_fees_helper {
       database& d;
       const global_property_object& props;
+      detail::vote_tally& tally;
+      const vector<uint64_t>& tallied_stake;
+      vector<bool> received_cashback;
+
+      process_fees_helper(database& d, const global_property_object& gpo, detail::vote_tally& tally,
+                          const vector<uint64_t>& tallied_stake)
+         : d(d), props(gpo), tally(tally), tallied_stake(tallied_stake), received_cashback(tallied_stake.size()) {}
 
-      process_fees_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo) {}
+      void mark_received( account_id_type id ) {
+         if( id.instance.value < received_cashback.size() )
+            received_cashback[id.instance.value] = true;
+      }
 
       void operator()(const account_object& a) {
-         a.statistics(d).process_fees(a, d);
+         const uint64_t instance = a.id.instance();
+         if( received_cashback[instance] && detail::counts_votes( d, props, a ) )
+         {
+            // unsigned wraparound makes adding the difference exact even when the stake went down
+            const uint64_t voting_stake = detail::voting_stake( d, a );
+            tally.add( d, props, a, voting_stake - tallied_stake[instance] );
+         }
+
+         const auto& stats = a.statistics(d);
+         if( stats.pending_fees > 0 || stats.pending_vested_fees > 0 )
+         {
+            // process_fees may replace the referrer with the lifetime referrer, both are marked
+            mark_received( a.lifetime_referrer );
+            mark_received( a.referrer );
+            mark_received( a.registrar );
+         }
+         stats.process_fees(a, d);
       }
-   } fee_helper(*this, gpo);
+   } fee_helper(*this, gpo, tally, tallied_stake);
 
    perform_account_maintenance(std::tie(
-      tally_helper,
       fee_helper
       ));
 
+   _vote_tally_buffer = std::move( tally.votes );
+   _witness_count_histogram_buffer = std::move( tally.witness_count_histogram );
+   _committee_count_histogram_buffer = std::move( tally.committee_count_histogram );
+   _total_voting_stake = tally.total_voting_stake;
+
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
       ~clear_canary() { target.clear(); }
@@ -136,7 +136,8 @@ void database::wipe(const fc::path& data_dir, bool include_blocks)
 void database::open(
    const fc::path& data_dir,
    std::function<genesis_state_type()> genesis_loader,
-   const std::string& db_version)
+   const std::string& db_version,
+   const fc::path& snapshot)
 {
    try
    {
@@ -149,8 +150,10 @@ void database::open(
          fc::read_file_contents( data_dir / "db_version", version_string );
          wipe_object_db = ( version_string != db_version );
       }
+      if( !snapshot.empty() )
+         wipe_object_db = true;
       if( wipe_object_db ) {
-          ilog("Wiping object_database due to missing or wrong version");
+          ilog("Wiping object_database due to missing or wrong version, or snapshot import");
           object_database::wipe( data_dir );
           std::ofstream version_file( (data_dir / "db_version").generic_string().c_str(),
                                       std::ios::out | std::ios::binary | std::ios::trunc );
@@ -162,6 +165,9 @@ void database::open(
 
       _block_id_to_block.open(data_dir / "database" / "block_num_to_block");
 
+      if( !snapshot.empty() )
+         import_snapshot( snapshot, genesis_loader().compute_chain_id(), db_version );
+
       if( !find(global_property_id_type()) )
          init_genesis(genesis_loader());
 
@@ -217,6 +223,11 @@ void database::close(bool rewind)
       _block_id_to_block.close();
 
    _fork_db.reset();
+   _block_cache.clear();
+   _recent_transactions.clear();
+   _authority_cache.clear();
+   _fee_table.clear();
+   _expiration_scheduler.clear();
 
    _opened = false;
 }
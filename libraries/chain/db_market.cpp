@@ -222,7 +222,7 @@ void database::cancel_limit_order( const limit_order_object& order, bool create_
       // only deduct fee if not skipping fee, and there is any fee deferred
       if( !skip_cancel_fee && deferred_fee > 0 )
       {
-         asset core_cancel_fee = current_fee_schedule().calculate_fee( vop );
+         asset core_cancel_fee = current_fee_table().calculate_fee( vop );
          // cap the fee
          if( core_cancel_fee.amount > deferred_fee )
             core_cancel_fee.amount = deferred_fee;
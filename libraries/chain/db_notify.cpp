@@ -293,7 +293,7 @@ static void transaction_get_impacted_accounts( const transaction& tx, flat_set<a
     operation_get_impacted_accounts( op, result );
 }
 
-static void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts )
+static void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts, const database& db )
 {
    if( obj->id.space() == protocol_ids )
    {
@@ -397,7 +397,11 @@ static void get_relevant_accounts( const object* obj, flat_set<account_id_type>&
            } case impl_transaction_object_type:{
               const auto& aobj = dynamic_cast<const transaction_object*>(obj);
               FC_ASSERT( aobj != nullptr );
-              transaction_get_impacted_accounts( aobj->trx, accounts );
+              // the full transaction is only known while it is cached; expired transactions stay cached until
+              // the block's changes are notified, but those evicted early by the cache size limit have no accounts
+              auto trx = db.get_recent_transaction_cache().fetch( aobj->trx_id );
+              if( trx )
+                 transaction_get_impacted_accounts( *trx, accounts );
               break;
            } case impl_blinded_balance_object_type:{
               const auto& aobj = dynamic_cast<const blinded_balance_object*>(obj);
@@ -447,12 +451,18 @@ static void get_relevant_accounts( const object* obj, flat_set<account_id_type>&
           }
       }
    }
-} // end get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts )
+} // end get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts, const database& db )
 
 namespace graphene { namespace chain {
 
 void database::notify_applied_block( const signed_block& block )
 {
+   // blocks pushed through the fork database are shared with it rather than copied
+   const auto item = _fork_db.fetch_block( block.id() );
+   if( item )
+      _block_cache.insert( item->block );
+   else
+      _block_cache.insert( block );
    GRAPHENE_TRY_NOTIFY( applied_block, block )
 }
 
@@ -467,54 +477,54 @@ void database::notify_changed_objects()
    {
       const auto& head_undo = _undo_db.head();
 
+      // The impacted accounts are only computed if a subscriber asks for them, once for all subscribers
+
       // New
-      if( !new_objects.empty() )
+      if( !new_objects.empty() && !head_undo.new_ids.empty() )
       {
-        vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
-        flat_set<account_id_type> new_accounts_impacted;
-        for( const auto& item : head_undo.new_ids )
-        {
-          new_ids.push_back(item);
-          auto obj = find_object(item);
-          if(obj != nullptr)
-            get_relevant_accounts(obj, new_accounts_impacted);
-        }
+        vector<object_id_type> new_ids( head_undo.new_ids.begin(), head_undo.new_ids.end() );
+        lazy_impacted_accounts new_accounts_impacted( [&]( flat_set<account_id_type>& accounts ) {
+          for( const auto& item : new_ids )
+          {
+            auto obj = find_object(item);
+            if(obj != nullptr)
+              get_relevant_accounts(obj, accounts, *this);
+          }
+        });
 
-        if( new_ids.size() )
-           GRAPHENE_TRY_NOTIFY( new_objects, new_ids, new_accounts_impacted)
+        GRAPHENE_TRY_NOTIFY( new_objects, new_ids, new_accounts_impacted)
       }
 
       // Changed
-      if( !changed_objects.empty() )
+      if( !changed_objects.empty() && !head_undo.old_values.empty() )
       {
         vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
-        flat_set<account_id_type> changed_accounts_impacted;
         for( const auto& item : head_undo.old_values )
-        {
           changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted);
-        }
+        lazy_impacted_accounts changed_accounts_impacted( [&]( flat_set<account_id_type>& accounts ) {
+          for( const auto& item : head_undo.old_values )
+            get_relevant_accounts(item.second.get(), accounts, *this);
+        });
 
-        if( changed_ids.size() )
-           GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
+        GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
       }
 
       // Removed
-      if( !removed_objects.empty() )
+      if( !removed_objects.empty() && !head_undo.removed.empty() )
       {
         vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
         vector<const object*> removed; removed.reserve( head_undo.removed.size() );
-        flat_set<account_id_type> removed_accounts_impacted;
         for( const auto& item : head_undo.removed )
         {
           removed_ids.emplace_back( item.first );
-          auto obj = item.second.get();
-          removed.emplace_back( obj );
-          get_relevant_accounts(obj, removed_accounts_impacted);
+          removed.emplace_back( item.second.get() );
         }
+        lazy_impacted_accounts removed_accounts_impacted( [&]( flat_set<account_id_type>& accounts ) {
+          for( const auto* obj : removed )
+            get_relevant_accounts(obj, accounts, *this);
+        });
 
-        if( removed_ids.size() )
-           GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted)
+        GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted)
       }
    }
 } FC_CAPTURE_AND_LOG( (0) ) }
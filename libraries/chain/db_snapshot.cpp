@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/snapshot.hpp>
+#include <graphene/chain/chain_property_object.hpp>
+#include <graphene/chain/global_property_object.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace graphene { namespace chain {
+
+void write_snapshot_record( std::ostream& out, const vector<char>& data )
+{
+   const uint32_t size = data.size();
+   const fc::sha256 checksum = fc::sha256::hash( data.data(), size );
+   out.write( (const char*)&size, sizeof(size) );
+   out.write( data.data(), size );
+   out.write( checksum.data(), checksum.data_size() );
+}
+
+vector<char> read_snapshot_record( std::istream& in )
+{
+   uint32_t size = 0;
+   in.read( (char*)&size, sizeof(size) );
+   FC_ASSERT( in, "Unexpected end of snapshot" );
+   FC_ASSERT( size <= snapshot_max_record_size, "Snapshot record of ${n} bytes is too large", ("n",size) );
+   vector<char> data( size );
+   fc::sha256 checksum;
+   in.read( data.data(), size );
+   in.read( checksum.data(), checksum.data_size() );
+   FC_ASSERT( in, "Unexpected end of snapshot" );
+   FC_ASSERT( checksum == fc::sha256::hash( data.data(), size ), "Snapshot record checksum mismatch" );
+   return data;
+}
+
+/// An index serialized into chunk records in a temporary file of its own
+struct snapshot_part
+{
+   const index*  idx = nullptr;
+   fc::path      file;
+   uint64_t      object_count = 0;
+   uint32_t      chunk_count = 0;
+   std::string   error;
+};
+
+static void write_snapshot_part( snapshot_part& part )
+{
+   std::ofstream out( part.file.generic_string(), std::ios::binary | std::ios::trunc );
+   FC_ASSERT( out, "Unable to create ${f}", ("f",part.file) );
+   vector<char> chunk;
+   chunk.reserve( snapshot_chunk_size );
+   auto flush_chunk = [&]() {
+      write_snapshot_record( out, chunk );
+      ++part.chunk_count;
+      chunk.clear();
+   };
+   part.idx->inspect_all_objects( [&]( const object& o ) {
+      const auto packed = fc::raw::pack( o.pack() );
+      chunk.insert( chunk.end(), packed.begin(), packed.end() );
+      ++part.object_count;
+      if( chunk.size() >= snapshot_chunk_size )
+         flush_chunk();
+   });
+   if( !chunk.empty() )
+      flush_chunk();
+   out.close();
+   FC_ASSERT( out, "Failed to write ${f}", ("f",part.file) );
+}
+
+void database::export_snapshot( const signed_block& head, const fc::path& dest, uint32_t max_threads )const
+{ try {
+   FC_ASSERT( head.id() == head_block_id(), "A snapshot can only be taken at the head block",
+              ("block",head.id())("head",head_block_id()) );
+
+   vector<snapshot_part> parts;
+   for( uint32_t space = 0; space < 256; ++space )
+      for( uint32_t type = 0; type < 256; ++type )
+      {
+         const index* idx = find_index( space, type );
+         if( idx == nullptr )
+            continue;
+         snapshot_part part;
+         part.idx = idx;
+         part.file = dest.generic_string() + "." + fc::to_string(space) + "." + fc::to_string(type) + ".part";
+         parts.push_back( std::move(part) );
+      }
+
+   // Indexes are only read here, so they can be serialized concurrently while the caller waits
+   uint32_t thread_count = max_threads > 0 ? max_threads : std::max( 1u, std::thread::hardware_concurrency() );
+   thread_count = std::min<uint32_t>( thread_count, parts.size() );
+   std::atomic<size_t> next_part( 0 );
+   auto work = [&parts,&next_part]() {
+      for( size_t i = next_part++; i < parts.size(); i = next_part++ )
+      {
+         try {
+            write_snapshot_part( parts[i] );
+         } catch( const fc::exception& e ) {
+            parts[i].error = e.to_detail_string();
+         } catch( const std::exception& e ) {
+            parts[i].error = e.what();
+         }
+      }
+   };
+   vector<std::thread> threads;
+   for( uint32_t i = 1; i < thread_count; ++i )
+      threads.emplace_back( work );
+   work();
+   for( auto& t : threads )
+      t.join();
+
+   for( const auto& part : parts )
+      if( !part.error.empty() )
+      {
+         for( const auto& p : parts )
+            fc::remove_all( p.file );
+         FC_THROW( "Failed to serialize index ${s}.${t}: ${e}",
+                   ("s",part.idx->object_space_id())("t",part.idx->object_type_id())("e",part.error) );
+      }
+
+   const fc::path tmp = dest.generic_string() + ".tmp";
+   std::ofstream out( tmp.generic_string(), std::ios::binary | std::ios::trunc );
+   FC_ASSERT( out, "Unable to create ${f}", ("f",tmp) );
+   out.write( (const char*)&snapshot_magic, sizeof(snapshot_magic) );
+   out.write( (const char*)&snapshot_version, sizeof(snapshot_version) );
+
+   snapshot_header header;
+   header.chain_id = get_chain_id();
+   header.db_version = GRAPHENE_CURRENT_DB_VERSION;
+   header.head_block = head;
+   header.last_irreversible_block_num = get_dynamic_global_properties().last_irreversible_block_num;
+   header.index_count = parts.size();
+   write_snapshot_record( out, fc::raw::pack( header ) );
+
+   for( const auto& part : parts )
+   {
+      snapshot_index_header index_header;
+      index_header.space_id = part.idx->object_space_id();
+      index_header.type_id = part.idx->object_type_id();
+      index_header.next_id = part.idx->get_next_id();
+      index_header.object_count = part.object_count;
+      index_header.chunk_count = part.chunk_count;
+      index_header.object_version = part.idx->get_object_version();
+      write_snapshot_record( out, fc::raw::pack( index_header ) );
+      if( part.chunk_count > 0 )
+      {
+         std::ifstream in( part.file.generic_string(), std::ios::binary );
+         out << in.rdbuf();
+      }
+      fc::remove_all( part.file );
+   }
+   out.close();
+   FC_ASSERT( out, "Failed to write ${f}", ("f",tmp) );
+   fc::rename( tmp, dest );
+   ilog( "Wrote snapshot of ${n} indexes at block ${b} to ${f}",
+         ("n",parts.size())("b",head.block_num())("f",dest) );
+} FC_CAPTURE_AND_RETHROW( (dest)(max_threads) ) }
+
+void database::import_snapshot( const fc::path& src, const chain_id_type& chain_id, const std::string& db_version )
+{ try {
+   FC_ASSERT( !find( global_property_id_type() ), "A snapshot can only be imported into an empty database" );
+
+   std::ifstream in( src.generic_string(), std::ios::binary );
+   FC_ASSERT( in, "Unable to open snapshot" );
+   uint32_t magic = 0;
+   uint32_t version = 0;
+   in.read( (char*)&magic, sizeof(magic) );
+   in.read( (char*)&version, sizeof(version) );
+   FC_ASSERT( in && magic == snapshot_magic, "Not a snapshot file" );
+   FC_ASSERT( version == snapshot_version, "Unsupported snapshot version ${v}", ("v",version) );
+
+   const auto header = fc::raw::unpack<snapshot_header>( read_snapshot_record( in ) );
+   FC_ASSERT( header.chain_id == chain_id, "Snapshot belongs to chain ${s}, expected ${c}",
+              ("s",header.chain_id)("c",chain_id) );
+   FC_ASSERT( header.db_version == db_version, "Snapshot has database version ${s}, expected ${v}",
+              ("s",header.db_version)("v",db_version) );
+   ilog( "Importing snapshot taken at block ${n}", ("n",header.head_block.block_num()) );
+
+   vector<char> packed;
+   for( uint32_t i = 0; i < header.index_count; ++i )
+   {
+      const auto index_header = fc::raw::unpack<snapshot_index_header>( read_snapshot_record( in ) );
+      index* idx = find_mutable_index( index_header.space_id, index_header.type_id );
+      if( idx == nullptr )
+         wlog( "Skipping ${n} objects of index ${s}.${t} which is not registered",
+               ("n",index_header.object_count)("s",index_header.space_id)("t",index_header.type_id) );
+      else
+         FC_ASSERT( index_header.object_version == idx->get_object_version(),
+                    "Incompatible version, the serialization of objects in snapshot index ${s}.${t} has changed",
+                    ("s",index_header.space_id)("t",index_header.type_id) );
+      uint64_t loaded = 0;
+      for( uint32_t c = 0; c < index_header.chunk_count; ++c )
+      {
+         const vector<char> chunk = read_snapshot_record( in );
+         if( idx == nullptr )
+            continue;
+         fc::datastream<const char*> ds( chunk.data(), chunk.size() );
+         while( ds.remaining() > 0 )
+         {
+            fc::raw::unpack( ds, packed );
+            idx->load( packed );
+            ++loaded;
+         }
+      }
+      if( idx != nullptr )
+      {
+         FC_ASSERT( loaded == index_header.object_count, "Snapshot index ${s}.${t} is incomplete",
+                    ("s",index_header.space_id)("t",index_header.type_id)("loaded",loaded)
+                    ("expected",index_header.object_count) );
+         idx->set_next_id( index_header.next_id );
+      }
+   }
+
+   const block_id_type head_id = header.head_block.id();
+   FC_ASSERT( head_block_id() == head_id, "Snapshot state does not match its head block" );
+   if( !_block_id_to_block.contains( head_id ) )
+      _block_id_to_block.store( head_id, header.head_block );
+   _fork_db.start_block( header.head_block );
+   ilog( "Done importing snapshot" );
+} FC_CAPTURE_AND_RETHROW( (src) ) }
+
+} } // graphene::chain
@@ -161,31 +161,31 @@ void database::clear_expired_transactions()
    //Look for expired transactions in the deduplication list, and remove them.
    //Transactions must have expired by at least two forking windows in order to be removed.
    auto& transaction_idx = static_cast<transaction_index&>(get_mutable_index(implementation_ids, impl_transaction_object_type));
-   const auto& dedupe_index = transaction_idx.indices().get<by_expiration>();
-   while( (!dedupe_index.empty()) && (head_block_time() > dedupe_index.begin()->trx.expiration) )
-      transaction_idx.remove(*dedupe_index.begin());
+   dispatch_expired( expired_transactions, [&transaction_idx]( const object& trx ) {
+      transaction_idx.remove( trx );
+   });
+   // _recent_transactions is pruned by _apply_block after notify_changed_objects, which still needs the
+   // transactions behind the removed records to find their impacted accounts
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_expired_proposals()
 {
-   const auto& proposal_expiration_index = get_index_type<proposal_index>().indices().get<by_expiration>();
-   while( !proposal_expiration_index.empty() && proposal_expiration_index.begin()->expiration_time <= head_block_time() )
-   {
-      const proposal_object& proposal = *proposal_expiration_index.begin();
+   dispatch_expired( expired_proposals, [this]( const object& obj ) {
+      const proposal_object& proposal = static_cast<const proposal_object&>( obj );
       processed_transaction result;
       try {
          if( proposal.is_authorized_to_execute(*this) )
          {
             result = push_proposal(proposal);
             //TODO: Do something with result so plugins can process it.
-            continue;
+            return;
          }
       } catch( const fc::exception& e ) {
          elog("Failed to apply proposed transaction on its expiration. Deleting it.\n${proposal}\n${error}",
               ("proposal", proposal)("error", e.to_detail_string()));
       }
       remove(proposal);
-   }
+   });
 }
 
 /**
@@ -277,10 +277,8 @@ void database::clear_expired_orders()
          bool before_core_hardfork_342 = ( maint_time <= HARDFORK_CORE_342_TIME ); // better rounding
          bool before_core_hardfork_606 = ( maint_time <= HARDFORK_CORE_606_TIME ); // feed always trigger call
 
-         auto& limit_index = get_index_type<limit_order_index>().indices().get<by_expiration>();
-         while( !limit_index.empty() && limit_index.begin()->expiration <= head_time )
-         {
-            const limit_order_object& order = *limit_index.begin();
+         dispatch_expired( expired_limit_orders, [this,before_core_hardfork_606]( const object& obj ) {
+            const limit_order_object& order = static_cast<const limit_order_object&>( obj );
             auto base_asset = order.sell_price.base.asset_id;
             auto quote_asset = order.sell_price.quote.asset_id;
             cancel_limit_order( order );
@@ -294,7 +292,7 @@ void database::clear_expired_orders()
                check_call_orders( base_asset( *this ) );
                check_call_orders( quote_asset( *this ) );
             }
-         }
+         });
 
    //Process expired force settlement orders
    auto& settlement_index = get_index_type<force_settlement_index>().indices().get<by_expiration>();
@@ -327,6 +325,7 @@ void database::clear_expired_orders()
       };
 
       uint32_t count = 0;
+      uint32_t finished = 0;
 
       // At each iteration, we either consume the current order and remove it, or we move to the next asset
       for( auto itr = settlement_index.lower_bound(current_asset);
@@ -352,6 +351,7 @@ void database::clear_expired_orders()
          {
             ilog( "Canceling a force settlement because of black swan" );
             cancel_settle_order( order );
+            ++finished;
             continue;
          }
 
@@ -374,6 +374,7 @@ void database::clear_expired_orders()
             ilog("Canceling a force settlement in ${asset} because settlement price is null",
                  ("asset", mia_object.symbol));
             cancel_settle_order(order);
+            ++finished;
             continue;
          }
          if( max_settlement_volume.asset_id != current_asset )
@@ -460,6 +461,8 @@ void database::clear_expired_orders()
                break;
             }
          }
+         if( !find_object( order_id ) ) // filled or cancelled above
+            ++finished;
          if( mia.force_settled_volume != settled.amount )
          {
             modify(mia, [settled](asset_bitasset_data_object& b) {
@@ -467,6 +470,7 @@ void database::clear_expired_orders()
             });
          }
       }
+      record_expirations( expired_force_settlements, finished );
    }
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -515,9 +519,35 @@ void database::update_maintenance_flag( bool new_maintenance_flag )
 
 void database::update_withdraw_permissions()
 {
-   auto& permit_index = get_index_type<withdraw_permission_index>().indices().get<by_expiration>();
-   while( !permit_index.empty() && permit_index.begin()->expiration <= head_block_time() )
-      remove(*permit_index.begin());
+   dispatch_expired( expired_withdraw_permissions, [this]( const object& permit ) {
+      remove( permit );
+   });
+}
+
+void database::dispatch_expired( expiration_kind kind, const std::function<void(const object&)>& f )
+{
+   const fc::time_point_sec now = head_block_time();
+   uint32_t expired = 0;
+   for( auto batch = _expiration_scheduler.due( kind, now ); !batch.empty();
+        batch = _expiration_scheduler.due( kind, now ) )
+   {
+      for( const object_id_type& id : batch )
+      {
+         const object* obj = find_object( id );
+         if( obj == nullptr )
+            continue;
+         f( *obj );
+         FC_ASSERT( find_object( id ) == nullptr, "Expired object ${id} was not removed", ("id",id) );
+         ++expired;
+      }
+   }
+   record_expirations( kind, expired );
+}
+
+void database::record_expirations( expiration_kind kind, uint32_t count )
+{
+   if( count > 0 && _apply_profiler.is_recording() )
+      _apply_profiler.record_expirations( kind, count );
 }
 
 } }
@@ -44,12 +44,34 @@ database& generic_evaluator::db()const { return trx_state->db(); }
    { try {
       trx_state   = &eval_state;
       //check_required_authorities(op);
-      auto result = evaluate( op );
+      apply_profiler& profiler = db().get_apply_profiler();
+      if( !profiler.is_recording() )
+      {
+         auto result = evaluate( op );
+
+         if( apply ) result = this->apply( op );
+         return result;
+      }
 
+      const fc::time_point start = fc::time_point::now();
+      auto result = evaluate( op );
+      const fc::time_point evaluated = fc::time_point::now();
       if( apply ) result = this->apply( op );
+      profiler.record_operation( get_type(), evaluated - start, fc::time_point::now() - evaluated );
       return result;
    } FC_CAPTURE_AND_RETHROW() }
 
+   void generic_evaluator::reset()
+   {
+      fee_from_account = asset();
+      core_fee_paid = 0;
+      fee_paying_account = nullptr;
+      fee_paying_account_statistics = nullptr;
+      fee_asset = nullptr;
+      fee_asset_dyn_data = nullptr;
+      trx_state = nullptr;
+   }
+
    void generic_evaluator::prepare_fee(account_id_type account_id, asset fee)
    {
       const database& d = db();
@@ -121,7 +143,7 @@ database& generic_evaluator::db()const { return trx_state->db(); }
 
    share_type generic_evaluator::calculate_fee_for_operation(const operation& op) const
    {
-     return db().current_fee_schedule().calculate_fee( op ).amount;
+     return db().current_fee_table().calculate_fee( op ).amount;
    }
    void generic_evaluator::db_adjust_balance(const account_id_type& fee_payer, asset fee_from_account)
    {
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/expiration_scheduler.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/transaction_object.hpp>
+#include <graphene/chain/withdraw_permission_object.hpp>
+
+namespace graphene { namespace chain {
+
+void expiration_scheduler::schedule( expiration_kind kind, object_id_type id, fc::time_point_sec when )
+{
+   auto itr = _locations.find( id );
+   if( itr != _locations.end() )
+   {
+      if( itr->second.e.when == when.sec_since_epoch() )
+         return;
+      cancel( id );
+   }
+   ++_counts[kind];
+   place( entry{ when.sec_since_epoch(), id, kind } );
+}
+
+void expiration_scheduler::cancel( object_id_type id )
+{
+   auto itr = _locations.find( id );
+   if( itr == _locations.end() )
+      return;
+   const entry& e = itr->second.e;
+   if( itr->second.level == due_level )
+      _due[e.kind].erase( e );
+   else
+      slot_of( e.when, itr->second.level ).erase( e );
+   --_counts[e.kind];
+   _locations.erase( itr );
+}
+
+expiration_scheduler::slot_type& expiration_scheduler::slot_of( uint32_t when, int level )
+{
+   return _wheels[level][ ( when >> ( level * level_bits ) ) & ( slots - 1 ) ];
+}
+
+void expiration_scheduler::place( const entry& e )
+{
+   int level = due_level;
+   if( e.when > _now )
+   {
+      // the wheel of the highest byte in which the due time differs from now
+      const uint32_t diff = e.when ^ _now;
+      level = levels - 1;
+      while( ( diff >> ( level * level_bits ) ) == 0 )
+         --level;
+      slot_of( e.when, level ).insert( e );
+   }
+   else
+      _due[e.kind].insert( e );
+   _locations[e.id] = location{ e, level };
+}
+
+void expiration_scheduler::make_due( slot_type& slot )
+{
+   for( const entry& e : slot )
+   {
+      _due[e.kind].insert( e );
+      _locations[e.id].level = due_level;
+   }
+   slot.clear();
+}
+
+void expiration_scheduler::advance( fc::time_point_sec now )
+{
+   const uint32_t t = now.sec_since_epoch();
+   if( t <= _now )
+      return;
+
+   // the highest byte that changes, the wheels below it are passed over entirely
+   const uint32_t diff = t ^ _now;
+   int top = levels - 1;
+   while( ( diff >> ( top * level_bits ) ) == 0 )
+      --top;
+   for( int level = 0; level < top; ++level )
+      for( slot_type& slot : _wheels[level] )
+         if( !slot.empty() )
+            make_due( slot );
+
+   // in the top wheel, the slots between the old and the new time are passed over, the one reached cascades
+   const int shift = top * level_bits;
+   const uint32_t first = ( ( _now >> shift ) & ( slots - 1 ) ) + 1;
+   const uint32_t reached = ( t >> shift ) & ( slots - 1 );
+   for( uint32_t i = first; i < reached; ++i )
+      if( !_wheels[top][i].empty() )
+         make_due( _wheels[top][i] );
+
+   _now = t;
+   slot_type cascading;
+   cascading.swap( _wheels[top][reached] );
+   for( const entry& e : cascading )
+      place( e );
+}
+
+std::vector<object_id_type> expiration_scheduler::due( expiration_kind kind, fc::time_point_sec now )const
+{
+   std::vector<object_id_type> result;
+   const uint32_t t = now.sec_since_epoch();
+   for( const entry& e : _due[kind] )
+   {
+      if( e.when > t )
+         break;
+      result.push_back( e.id );
+   }
+   return result;
+}
+
+void expiration_scheduler::clear()
+{
+   for( auto& wheel : _wheels )
+      for( slot_type& slot : wheel )
+         slot.clear();
+   for( slot_type& slot : _due )
+      slot.clear();
+   _locations.clear();
+   _counts = std::array<size_t, expiration_kind_count>();
+   _now = 0;
+}
+
+void expiration_schedule_index::schedule( const object& obj )
+{
+   if( obj.id.space() == implementation_ids && obj.id.type() == impl_transaction_object_type )
+   {
+      // deduplication entries are kept until the head block time is past their expiration
+      const auto& trx = static_cast<const transaction_object&>( obj );
+      if( trx.expiration < fc::time_point_sec::maximum() )
+         _scheduler.schedule( expired_transactions, obj.id, trx.expiration + 1 );
+      return;
+   }
+   if( obj.id.space() != protocol_ids )
+      return;
+
+   fc::time_point_sec when;
+   expiration_kind kind;
+   switch( obj.id.type() )
+   {
+      case proposal_object_type:
+         kind = expired_proposals;
+         when = static_cast<const proposal_object&>( obj ).expiration_time;
+         break;
+      case limit_order_object_type:
+         kind = expired_limit_orders;
+         when = static_cast<const limit_order_object&>( obj ).expiration;
+         break;
+      case withdraw_permission_object_type:
+         kind = expired_withdraw_permissions;
+         when = static_cast<const withdraw_permission_object&>( obj ).expiration;
+         break;
+      default:
+         return;
+   }
+   // most limit orders never expire, there is no need to carry them around
+   if( when == fc::time_point_sec::maximum() )
+      _scheduler.cancel( obj.id );
+   else
+      _scheduler.schedule( kind, obj.id, when );
+}
+
+} } // graphene::chain
@@ -130,6 +130,16 @@ void_result asset_investment_evaluator::do_apply( const asset_investment_operati
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (o) ) }
 
+void issue_asset_to_investors_evaluator::reset()
+{
+   generic_evaluator::reset();
+   total_issue = 0;
+   asset_dyn_data = nullptr;
+   // cleared without releasing the memory, which is reused by the next operation
+   investment_objects.clear();
+   issue_amounts.clear();
+}
+
 void_result issue_asset_to_investors_evaluator::do_evaluate( const issue_asset_to_investors_operation& o )
 { try {
    database& d = db();
@@ -159,11 +169,7 @@ void_result issue_asset_to_investors_evaluator::do_evaluate( const issue_asset_t
    share_type total_investment = 0;
    share_type total_issue_tmp = 0;
    this->investment_objects.clear();
-   std::vector<const asset_investment_object *> empty;
-   this->investment_objects.swap(empty);
    this->issue_amounts.clear();
-   std::vector<share_type> share_empty;
-   this->issue_amounts.swap(share_empty);
    std::for_each(range.first, range.second,
                  [&](const asset_investment_object &obj) {
          KHC_WASSERT(is_authorized_asset(d, obj.investment_account_id(d), obj.investment_asset_id(d)));
@@ -208,6 +214,13 @@ void_result issue_asset_to_investors_evaluator::do_apply( const issue_asset_to_i
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (o) ) }
 
+void refund_investment_evaluator::reset()
+{
+   generic_evaluator::reset();
+   investment_objects.clear();
+   asset_dynamic = nullptr;
+}
+
 void_result refund_investment_evaluator::do_evaluate( const refund_investment_operation& o )
 { try {
    database& d = db();
@@ -220,8 +233,6 @@ void_result refund_investment_evaluator::do_evaluate( const refund_investment_op
    share_type total_investment(0);
    bool investment_flag(false);
    this->investment_objects.clear();
-   std::vector<const asset_investment_object *> empty;
-   this->investment_objects.swap(empty);
    const auto& idx = d.get_index_type<asset_investment_index>().indices().get<by_account>();
    auto range = idx.equal_range(o.account_id);
    std::for_each(range.first,range.second,
@@ -331,6 +342,14 @@ void_result claim_bitasset_investment_evaluator::do_apply( const claim_bitasset_
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (o) ) }
 
+void claim_asset_investment_evaluator::reset()
+{
+   generic_evaluator::reset();
+   tokens = 0;
+   asset_dyn_data = nullptr;
+   investment_objects.clear();
+}
+
 void_result claim_asset_investment_evaluator::do_evaluate( const claim_asset_investment_operation& o )
 { try {
    database& d = db();
@@ -344,8 +363,6 @@ void_result claim_asset_investment_evaluator::do_evaluate( const claim_asset_inv
    const auto &idx = d.get_index_type<asset_investment_index>().indices().get<by_account>();
    auto range = idx.equal_range(o.account_id);
    this->investment_objects.clear();
-   std::vector<const asset_investment_object *> empty;
-   this->investment_objects.swap(empty);
    std::for_each(range.first, range.second,
                  [&](const asset_investment_object &obj) {
                      KHC_WASSERT(is_authorized_asset(d, obj.investment_account_id(d), obj.investment_asset_id(d)));
@@ -26,6 +26,8 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <unordered_set>
+
 namespace graphene { namespace chain {
 fork_database::fork_database()
 {
@@ -34,6 +36,7 @@ void fork_database::reset()
 {
    _head.reset();
    _index.clear();
+   _total_bytes = 0;
 }
 
 void fork_database::pop_block()
@@ -47,7 +50,8 @@ void fork_database::pop_block()
 void     fork_database::start_block(signed_block b)
 {
    auto item = std::make_shared<fork_item>(std::move(b));
-   _index.insert(item);
+   if( _index.insert(item).second )
+      _total_bytes += item->packed_size;
    _head = item;
 }
 
@@ -73,6 +77,8 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
 
 void  fork_database::_push_block(const item_ptr& item)
 {
+   const item_ptr previous_head = _head;
+
    if( _head ) // make sure the block is within the range that we are caching
    {
       FC_ASSERT( item->num > std::max<int64_t>( 0, int64_t(_head->num) - (_max_size) ),
@@ -88,7 +94,8 @@ void  fork_database::_push_block(const item_ptr& item)
       item->prev = *itr;
    }
 
-   _index.insert(item);
+   if( _index.insert(item).second )
+      _total_bytes += item->packed_size;
    if( !_head ) _head = item;
    else if( item->num > _head->num )
    {
@@ -97,10 +104,14 @@ void  fork_database::_push_block(const item_ptr& item)
 //      ilog( "min block in fork DB ${n}, max_size: ${m}", ("n",min_num)("m",_max_size) );
       auto& num_idx = _index.get<block_num>();
       while( num_idx.size() && (*num_idx.begin())->num < min_num )
+      {
+         _total_bytes -= (*num_idx.begin())->packed_size;
          num_idx.erase( num_idx.begin() );
+      }
       
       _unlinked_index.get<block_num>().erase(_head->num - _max_size);
    }
+   _prune_to_max_bytes( previous_head );
    //_push_next( item );
 }
 
@@ -136,7 +147,10 @@ void fork_database::set_max_size( uint32_t s )
       while( itr != by_num_idx.end() )
       {
          if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
+         {
+            _total_bytes -= (*itr)->packed_size;
             by_num_idx.erase(itr);
+         }
          else
             break;
          itr = by_num_idx.begin();
@@ -156,6 +170,50 @@ void fork_database::set_max_size( uint32_t s )
    }
 }
 
+void fork_database::set_max_bytes( size_t s )
+{
+   _max_bytes = s;
+   _prune_to_max_bytes();
+}
+
+void fork_database::_prune_to_max_bytes( const item_ptr& previous_head )
+{
+   if( _max_bytes == 0 || _total_bytes <= _max_bytes || !_head )
+      return;
+
+   // popping blocks walks the branch of the head, and the database is still on the branch of the previous head
+   // when this push makes it switch forks
+   std::unordered_set<block_id_type, std::hash<fc::ripemd160>> kept;
+   for( item_ptr item = _head; item; item = item->prev.lock() )
+      kept.insert( item->id );
+   for( item_ptr item = previous_head; item && kept.find( item->id ) == kept.end(); item = item->prev.lock() )
+      kept.insert( item->id );
+
+   // a dropped block takes its descendants with it, none of them is kept since their ancestors are not,
+   // and leaving them would let a later block extend a branch that no longer links to the head
+   auto& num_idx = _index.get<block_num>();
+   auto& prev_idx = _index.get<by_previous>();
+   while( _total_bytes > _max_bytes )
+   {
+      auto itr = num_idx.begin();
+      while( itr != num_idx.end() && kept.find( (*itr)->id ) != kept.end() )
+         ++itr;
+      if( itr == num_idx.end() )
+         break;
+
+      vector<item_ptr> subtree{ *itr };
+      while( !subtree.empty() )
+      {
+         const item_ptr item = subtree.back();
+         subtree.pop_back();
+         auto children = prev_idx.equal_range( item->id );
+         subtree.insert( subtree.end(), children.first, children.second );
+         _total_bytes -= item->packed_size;
+         _index.get<block_id>().erase( item->id );
+      }
+   }
+}
+
 bool fork_database::is_known_block(const block_id_type& id)const
 {
    auto& index = _index.get<block_id>();
@@ -246,7 +304,12 @@ void fork_database::set_head(shared_ptr<fork_item> h)
 
 void fork_database::remove(block_id_type id)
 {
-   _index.get<block_id>().erase(id);
+   auto& index = _index.get<block_id>();
+   auto itr = index.find(id);
+   if( itr == index.end() )
+      return;
+   _total_bytes -= (*itr)->packed_size;
+   index.erase(itr);
 }
 
 } } // graphene::chain
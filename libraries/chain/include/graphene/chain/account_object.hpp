@@ -22,9 +22,17 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <graphene/chain/protocol/authority_cache.hpp>
 #include <graphene/chain/protocol/operations.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/version.hpp>
+#if BOOST_VERSION >= 105900
+#include <boost/multi_index/ranked_index.hpp>
+#define GRAPHENE_POWER_RANK_INDEX ranked_unique
+#else
+#define GRAPHENE_POWER_RANK_INDEX ordered_unique
+#endif
 
 namespace graphene { namespace chain {
    class database;
@@ -344,6 +352,142 @@ namespace graphene { namespace chain {
          map< account_id_type, set<account_id_type> > referred_by;
    };
 
+   /**
+    *  @brief This secondary index clears the authority cache of the database whenever the owner or active authority
+    *  of an account changes or an account is removed, including when undo does it.
+    */
+   class account_authority_cache_index : public secondary_index
+   {
+      public:
+         explicit account_authority_cache_index( authority_cache& cache ) : _cache( cache ) {}
+
+         virtual void object_inserted( const object& obj ) override {}
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+      private:
+         authority_cache& _cache;
+         authority        _before_owner;
+         authority        _before_active;
+   };
+
+   /**
+    *  @brief Total and available power of one account, as kept by account_power_rank_index
+    */
+   struct account_power_rank
+   {
+      account_id_type  account;
+      share_type       total_power;  ///< sum of the account_power_objects of the account
+      share_type       locked_power; ///< locked power that is not unlocked at the head block yet
+
+      share_type available_power()const { return total_power - locked_power; }
+   };
+
+   struct by_power_account;
+   struct by_total_power;
+   struct by_available_power;
+   typedef multi_index_container<
+      account_power_rank,
+      indexed_by<
+         ordered_unique< tag<by_power_account>, member< account_power_rank, account_id_type, &account_power_rank::account > >,
+         GRAPHENE_POWER_RANK_INDEX< tag<by_total_power>,
+            composite_key< account_power_rank,
+               member< account_power_rank, share_type, &account_power_rank::total_power >,
+               member< account_power_rank, account_id_type, &account_power_rank::account >
+            >,
+            composite_key_compare< std::greater< share_type >, std::less< account_id_type > >
+         >,
+         GRAPHENE_POWER_RANK_INDEX< tag<by_available_power>,
+            composite_key< account_power_rank,
+               const_mem_fun< account_power_rank, share_type, &account_power_rank::available_power >,
+               member< account_power_rank, account_id_type, &account_power_rank::account >
+            >,
+            composite_key_compare< std::greater< share_type >, std::less< account_id_type > >
+         >
+      >
+   > account_power_rank_multi_index_type;
+
+   /**
+    *  @brief This secondary index ranks accounts by their total and available power.
+    *
+    *  It is added to the account_power_index, and the account_locked_power_index and the dynamic global property
+    *  index forward their changes to it through account_power_rank_forwarder.  Locked power stops counting once the
+    *  head block passes its unlock height, so every head block change moves the locks it crosses, in both directions
+    *  to follow undone blocks.
+    */
+   class account_power_rank_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         const account_power_rank_multi_index_type& ranks()const { return _ranks; }
+
+         /// @return 0 based position of @ref itr in the by_total_power or by_available_power order
+         template<typename Tag>
+         uint32_t rank_of( typename account_power_rank_multi_index_type::index<Tag>::type::const_iterator itr )const
+         {
+            const auto& idx = _ranks.get<Tag>();
+#if BOOST_VERSION >= 105900
+            return idx.rank( itr );
+#else
+            return std::distance( idx.begin(), itr );
+#endif
+         }
+
+         /// @return iterator to the entry at 0 based position @ref n of the by_total_power or by_available_power order
+         template<typename Tag>
+         typename account_power_rank_multi_index_type::index<Tag>::type::const_iterator nth( uint32_t n )const
+         {
+            const auto& idx = _ranks.get<Tag>();
+            if( n >= idx.size() )
+               return idx.end();
+#if BOOST_VERSION >= 105900
+            return idx.nth( n );
+#else
+            return std::next( idx.begin(), n );
+#endif
+         }
+
+      private:
+         struct locked_entry
+         {
+            account_id_type owner;
+            share_type      value;
+            share_type      unlock_height;
+         };
+
+         void adjust( account_id_type account, share_type total_delta, share_type locked_delta );
+         void add_locked( const object_id_type& id, const locked_entry& entry );
+         void remove_locked( const object_id_type& id );
+         void set_head_block_num( uint32_t head_block_num );
+
+         account_power_rank_multi_index_type             _ranks;
+         map< object_id_type, locked_entry >             _locked;
+         set< std::pair< share_type, object_id_type > >  _locked_by_height;
+         uint32_t                                        _head_block_num = 0;
+   };
+
+   /**
+    *  @brief Forwards the changes of another primary index to an account_power_rank_index
+    */
+   class account_power_rank_forwarder : public secondary_index
+   {
+      public:
+         account_power_rank_forwarder( account_power_rank_index* target ) : _target( target ) {}
+
+         virtual void object_inserted( const object& obj ) override { _target->object_inserted( obj ); }
+         virtual void object_removed( const object& obj ) override { _target->object_removed( obj ); }
+         virtual void about_to_modify( const object& before ) override { _target->about_to_modify( before ); }
+         virtual void object_modified( const object& after  ) override { _target->object_modified( after ); }
+
+      private:
+         account_power_rank_index* _target;
+   };
+
    struct by_account_asset;
    struct by_asset_balance;
    /**
@@ -455,6 +599,8 @@ FC_REFLECT_DERIVED( graphene::chain::account_object,
                     (allowed_assets)
                     )
 
+FC_REFLECT( graphene::chain::account_power_rank, (account)(total_power)(locked_power) )
+
 FC_REFLECT_DERIVED( graphene::chain::account_power_object,
                     (graphene::db::object),
                     (owner)(power_from)(power_value) )
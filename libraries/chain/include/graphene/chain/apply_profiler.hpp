@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/expiration_scheduler.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * The steps of database::_apply_block that are timed separately, in the order they run.
+    */
+   enum apply_block_phase
+   {
+      phase_transactions,
+      phase_update_global_dynamic_data,
+      phase_update_signing_witness,
+      phase_update_last_irreversible_block,
+      phase_chain_maintenance,
+      phase_create_block_summary,
+      phase_clear_expired_transactions,
+      phase_clear_expired_proposals,
+      phase_clear_expired_orders,
+      phase_update_expired_feeds,
+      phase_update_withdraw_permissions,
+      phase_update_witness_schedule,
+      phase_notify_applied_block,
+      phase_notify_changed_objects,
+      apply_block_phase_count
+   };
+
+   struct apply_timing
+   {
+      uint64_t count    = 0;
+      uint64_t total_us = 0;
+      uint64_t max_us   = 0;
+
+      void record( int64_t us );
+      void merge( const apply_timing& other );
+   };
+
+   struct operation_apply_stats
+   {
+      int32_t       which = 0; ///< operation tag
+      std::string   name;
+      apply_timing  evaluate;  ///< time spent in do_evaluate, including prepare_fee
+      apply_timing  apply;     ///< time spent in do_apply, including pay_fee
+   };
+
+   struct phase_apply_stats
+   {
+      std::string   name;
+      apply_timing  timing;
+   };
+
+   struct expiration_stats
+   {
+      std::string   name;
+      uint64_t      total = 0;         ///< objects expired over all recorded blocks
+      uint64_t      blocks = 0;        ///< recorded blocks that expired at least one object of this kind
+      uint64_t      max_per_block = 0; ///< the most objects of this kind expired by a single block
+   };
+
+   struct apply_profile
+   {
+      bool                                enabled = false;
+      uint64_t                            slow_block_threshold_us = 0;
+      uint64_t                            slow_blocks = 0;
+      apply_timing                        blocks;
+      std::vector<operation_apply_stats>  operations;
+      std::vector<phase_apply_stats>      phases;
+      std::vector<expiration_stats>       expirations;
+   };
+
+   /**
+    *  @brief Records where the time goes while blocks are applied
+    *
+    *  When enabled, every operation applied as part of a block is timed in its evaluate and apply steps, and
+    *  every phase of database::_apply_block is timed as a whole. Nothing is recorded while disabled, which is
+    *  the default, apart from one flag check per block and per operation.
+    *
+    *  Operations and phases are accumulated per block on the database thread and merged into the totals once
+    *  the block has been applied, so readers on other threads only contend for one lock per block. Operations
+    *  evaluated for pending transactions are not recorded, and neither is a block that fails to apply.
+    *
+    *  The number of objects each expiration step handles is counted per kind as well, to tell which of them
+    *  makes a slow clear_expired_* phase slow.
+    */
+   class apply_profiler
+   {
+      public:
+         void enable( bool e ) { _enabled = e; }
+         bool enabled()const   { return _enabled; }
+         /// Log the breakdown of any block that takes at least this long to apply; 0 disables the log
+         void set_slow_block_threshold( const fc::microseconds& t ) { _slow_block_us = t.count(); }
+
+         /// @return true while a block is being applied with profiling enabled
+         bool is_recording()const { return _recording; }
+         /// Only called by the evaluator while is_recording() is true
+         void record_operation( int which, const fc::microseconds& evaluate, const fc::microseconds& apply );
+         /// Only called by the expiration steps of the database while is_recording() is true
+         void record_expirations( expiration_kind kind, uint32_t count ) { _block_expirations[kind] += count; }
+
+         apply_profile get_profile()const;
+         void          reset();
+
+         static const char* phase_name( apply_block_phase phase );
+         static const char* expiration_name( expiration_kind kind );
+
+         /**
+          *  Times the consecutive phases of one block. Each end_phase() call charges the time since the previous
+          *  one to the given phase. The totals are only updated by finish(), so an exception leaves them alone.
+          */
+         class block_timer
+         {
+            public:
+               explicit block_timer( apply_profiler& p );
+               ~block_timer();
+
+               void end_phase( apply_block_phase phase );
+               void finish( uint32_t block_num );
+
+            private:
+               apply_profiler&                                _profiler;
+               bool                                           _active;
+               fc::time_point                                 _block_start;
+               fc::time_point                                 _phase_start;
+               std::array<int64_t, apply_block_phase_count>   _phases{};
+         };
+
+      private:
+         struct operation_timing
+         {
+            apply_timing evaluate;
+            apply_timing apply;
+         };
+
+         void finish_block( uint32_t block_num, int64_t block_us,
+                            const std::array<int64_t, apply_block_phase_count>& phases );
+
+         std::atomic<bool>                               _enabled{ false };
+         std::atomic<int64_t>                            _slow_block_us{ 0 };
+         /// the members below up to _mutex are only used by the database thread
+         bool                                            _recording = false;
+         std::map<int, operation_timing>                 _block_operations;
+         std::array<uint32_t, expiration_kind_count>     _block_expirations{};
+
+         mutable std::mutex                              _mutex;
+         std::map<int, operation_timing>                 _operations;
+         std::array<apply_timing, apply_block_phase_count> _phases;
+         std::array<expiration_stats, expiration_kind_count> _expirations;
+         apply_timing                                    _blocks;
+         uint64_t                                        _slow_blocks = 0;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::apply_timing, (count)(total_us)(max_us) )
+FC_REFLECT( graphene::chain::operation_apply_stats, (which)(name)(evaluate)(apply) )
+FC_REFLECT( graphene::chain::phase_apply_stats, (name)(timing) )
+FC_REFLECT( graphene::chain::expiration_stats, (name)(total)(blocks)(max_per_block) )
+FC_REFLECT( graphene::chain::apply_profile,
+            (enabled)(slow_block_threshold_us)(slow_blocks)(blocks)(operations)(phases)(expirations) )
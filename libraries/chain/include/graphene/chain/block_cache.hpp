@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/block.hpp>
+
+#include <list>
+#include <map>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @brief LRU cache of recently applied blocks, keyed by block number
+    *
+    *  Blocks are kept decoded, and their fc::raw encoding is computed once on first request. The owner must
+    *  insert every applied block and call remove_from() whenever blocks are popped; inserting a block also
+    *  drops any cached block at the same or a higher number, so a fork switch never leaves stale entries.
+    *  Older blocks read back on a cache miss can be added with fill(), which leaves the others alone.
+    */
+   class block_cache
+   {
+      public:
+         void   set_max_size( size_t s );
+         size_t max_size()const { return _max_size; }
+         size_t size()const { return _blocks.size(); }
+
+         void insert( const signed_block& b );
+         /// Keep a block that is already shared, e.g. by the fork database, without copying it
+         void insert( shared_ptr<const signed_block> b );
+         /// Cache a block of the current chain that was fetched on a miss, keeping the blocks after it
+         void fill( shared_ptr<const signed_block> b );
+         /// Drop all cached blocks with block_num >= num
+         void remove_from( uint32_t num );
+         void clear();
+
+         shared_ptr<const signed_block>  fetch( uint32_t num )const;
+         shared_ptr<const vector<char>>  fetch_packed( uint32_t num )const;
+         /// @return the cached block only if its id matches
+         shared_ptr<const signed_block>  fetch_by_id( const block_id_type& id )const;
+
+      private:
+         typedef std::list<uint32_t> lru_list_type;
+         struct cached_block
+         {
+            shared_ptr<const signed_block>  block;
+            block_id_type                   id;
+            shared_ptr<const vector<char>>  packed;
+            lru_list_type::iterator         lru_position;
+         };
+
+         void touch( cached_block& entry )const;
+         void add( uint32_t num, shared_ptr<const signed_block> b );
+
+         size_t                                   _max_size = 512;
+         mutable lru_list_type                    _lru; ///< most recently used at the front
+         mutable std::map<uint32_t,cached_block>  _blocks;
+   };
+
+} } // graphene::chain
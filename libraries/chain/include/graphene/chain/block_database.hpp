@@ -43,6 +43,8 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /// Returns the block exactly as stored on disk (fc::raw encoded), without decoding it
+         optional<vector<char>> fetch_raw_by_number( uint32_t block_num )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
       private:
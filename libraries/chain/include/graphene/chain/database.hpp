@@ -28,6 +28,10 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/block_cache.hpp>
+#include <graphene/chain/recent_transaction_cache.hpp>
+#include <graphene/chain/expiration_scheduler.hpp>
+#include <graphene/chain/apply_profiler.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 
@@ -50,6 +54,34 @@ namespace graphene { namespace chain {
 
    struct budget_record;
 
+   /**
+    *  @brief The accounts impacted by the objects of one change notification
+    *
+    *  The set is computed the first time a subscriber asks for it and is then shared by all the subscribers of the
+    *  notification.  It refers to the state being notified and must not be kept after the callback returns.
+    */
+   class lazy_impacted_accounts
+   {
+      public:
+         explicit lazy_impacted_accounts( std::function<void(flat_set<account_id_type>&)> compute )
+            : _compute( std::move( compute ) ) {}
+
+         const flat_set<account_id_type>& get()const
+         {
+            if( !_accounts.valid() )
+            {
+               _accounts = flat_set<account_id_type>();
+               _compute( *_accounts );
+            }
+            return *_accounts;
+         }
+         bool computed()const { return _accounts.valid(); }
+
+      private:
+         std::function<void(flat_set<account_id_type>&)> _compute;
+         mutable optional<flat_set<account_id_type>>     _accounts;
+   };
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -72,7 +104,7 @@ namespace graphene { namespace chain {
             skip_block_size_check       = 1 << 4,  ///< used when applying locally generated transactions
             skip_tapos_check            = 1 << 5,  ///< used while reindexing -- note this skips expiration check as well
             skip_authority_check        = 1 << 6,  ///< used while reindexing -- disables any checking of authority on transactions
-            skip_merkle_check           = 1 << 7,  ///< used while reindexing
+            skip_merkle_check           = 1 << 7,  ///< used while reindexing and for blocks that were checked already
             skip_assert_evaluation      = 1 << 8,  ///< used while reindexing
             skip_undo_history_check     = 1 << 9,  ///< used while reindexing
             skip_witness_schedule_check = 1 << 10,  ///< used while reindexing
@@ -90,11 +122,13 @@ namespace graphene { namespace chain {
           * @param data_dir Path to open or create database in
           * @param genesis_loader A callable object which returns the genesis state to initialize new databases on
           * @param db_version a version string that changes when the internal database format and/or logic is modified
+          * @param snapshot if not empty, the object database is replaced with the state in this snapshot file
           */
           void open(
              const fc::path& data_dir,
              std::function<genesis_state_type()> genesis_loader,
-             const std::string& db_version );
+             const std::string& db_version,
+             const fc::path& snapshot = fc::path() );
 
          /**
           * @brief Rebuild object graph from block history and open detabase
@@ -124,7 +158,26 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
-         const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
+         /// @return the block in its fc::raw encoding, read from the block log without decoding when possible
+         optional<vector<char>>     fetch_raw_block_by_number( uint32_t num )const;
+         /// @return a transaction that is still in the deduplication index, if it is still cached
+         signed_transaction         get_recent_transaction( const transaction_id_type& trx_id )const;
+         /// Set how many transactions behind the deduplication index are kept for get_recent_transaction; 0 disables
+         void                       set_recent_transaction_cache_size( size_t s ) { _recent_transactions.set_max_size( s ); }
+         const recent_transaction_cache& get_recent_transaction_cache()const { return _recent_transactions; }
+         /// Set how many recently applied blocks are kept decoded in memory for the fetch_* calls; 0 disables
+         void                       set_block_cache_size( size_t s ) { _block_cache.set_max_size( s ); }
+         /// Limit the memory held by blocks of abandoned forks in the fork database; 0 disables the limit
+         void                       set_fork_db_max_bytes( size_t s ) { _fork_db.set_max_bytes( s ); }
+         const block_cache&         get_block_cache()const { return _block_cache; }
+         /// Number of threads tallying votes at maintenance; 0 picks one per core once there are enough accounts
+         void                       set_maintenance_threads( uint32_t n ) { _maintenance_threads = n; }
+         /// Timing of operations and block phases, see apply_profiler
+         apply_profiler&            get_apply_profiler() { return _apply_profiler; }
+         const apply_profiler&      get_apply_profiler()const { return _apply_profiler; }
+         /// Authorities and authority checks remembered between transactions, cleared at every block
+         authority_cache&           get_authority_cache() { return _authority_cache; }
+         const expiration_scheduler& get_expiration_scheduler()const { return _expiration_scheduler; }
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
          /**
@@ -142,6 +195,8 @@ namespace graphene { namespace chain {
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const signed_transaction& trx );
 
+         size_t get_pending_transaction_count()const { return _pending_tx.size(); }
+
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
@@ -193,20 +248,21 @@ namespace graphene { namespace chain {
 
          /**
           *  Emitted After a block has been applied and committed.  The callback
-          *  should not yield and should execute quickly.
+          *  should not yield and should execute quickly.  The impacted accounts
+          *  are only computed if a callback asks for them.
           */
-         fc::signal<void(const vector<object_id_type>&, const flat_set<account_id_type>&)> new_objects;
+         fc::signal<void(const vector<object_id_type>&, const lazy_impacted_accounts&)> new_objects;
 
          /**
           *  Emitted After a block has been applied and committed.  The callback
           *  should not yield and should execute quickly.
           */
-         fc::signal<void(const vector<object_id_type>&, const flat_set<account_id_type>&)> changed_objects;
+         fc::signal<void(const vector<object_id_type>&, const lazy_impacted_accounts&)> changed_objects;
 
          /** this signal is emitted any time an object is removed and contains a
           * pointer to the last value of every object that was removed.
           */
-         fc::signal<void(const vector<object_id_type>&, const vector<const object*>&, const flat_set<account_id_type>&)>  removed_objects;
+         fc::signal<void(const vector<object_id_type>&, const vector<const object*>&, const lazy_impacted_accounts&)>  removed_objects;
 
          //////////////////// db_witness_schedule.cpp ////////////////////
 
@@ -257,6 +313,8 @@ namespace graphene { namespace chain {
          const dynamic_global_property_object&  get_dynamic_global_properties()const;
          const node_property_object&            get_node_properties()const;
          const fee_schedule&                    current_fee_schedule()const;
+         /// The current fee schedule resolved per operation type, use it to price operations
+         const fee_table&                       current_fee_table()const;
 
          time_point_sec   head_block_time()const;
          uint32_t         head_block_num()const;
@@ -329,6 +387,25 @@ namespace graphene { namespace chain {
          // helper to handle witness pay
          void deposit_witness_pay(const witness_object& wit, share_type amount);
 
+         //////////////////// db_snapshot.cpp ////////////////////
+
+         /**
+          * @brief Write the current state to a binary snapshot file
+          * @param head the head block, i.e. the block whose application produced the current state
+          * @param max_threads number of threads serializing indexes in parallel, 0 to use all cores
+          *
+          * The caller must not modify the database until this returns. Indexes are serialized into temporary
+          * files next to @p dest, which are then joined into @p dest.
+          */
+         void export_snapshot( const signed_block& head, const fc::path& dest, uint32_t max_threads = 0 )const;
+         /**
+          * @brief Load the state from a snapshot created by export_snapshot() into this empty database
+          *
+          * Indexes in the snapshot which are not registered in this database are skipped. The head block of
+          * the snapshot is added to the block database and the fork database.
+          */
+         void import_snapshot( const fc::path& src, const chain_id_type& chain_id, const std::string& db_version );
+
          //////////////////// db_debug.cpp ////////////////////
 
          void debug_dump();
@@ -455,6 +532,14 @@ namespace graphene { namespace chain {
          void update_expired_feeds();
          void update_maintenance_flag( bool new_maintenance_flag );
          void update_withdraw_permissions();
+         /// Counts objects handled by an expiration step when the block is being profiled
+         void record_expirations( expiration_kind kind, uint32_t count );
+         /**
+          *  Hands every object of @p kind that is due at the head block time to @p f, in batches taken from the
+          *  expiration scheduler, until none is left. @p f must remove the object. Objects removed while a
+          *  batch is processed are skipped, objects that become due are handled by the next batch.
+          */
+         void dispatch_expired( expiration_kind kind, const std::function<void(const object&)>& f );
          bool check_for_blackswan( const asset_object& mia, bool enable_black_swan = true );
 
          ///Steps performed only at maintenance intervals
@@ -492,6 +577,13 @@ namespace graphene { namespace chain {
           *  the fork tree relatively simple.
           */
          block_database   _block_id_to_block;
+         mutable block_cache _block_cache;
+         recent_transaction_cache _recent_transactions;
+         apply_profiler   _apply_profiler;
+         authority_cache  _authority_cache;
+         expiration_scheduler _expiration_scheduler;
+         /// built from current_fee_schedule() on first use, cleared by fee_table_index when it changes
+         mutable fee_table _fee_table;
 
          /**
           * Contains the set of ops that are in the process of being applied from
@@ -510,6 +602,7 @@ namespace graphene { namespace chain {
          vector<uint64_t>                  _witness_count_histogram_buffer;
          vector<uint64_t>                  _committee_count_histogram_buffer;
          uint64_t                          _total_voting_stake;
+         uint32_t                          _maintenance_threads = 0;
 
          flat_map<uint32_t,block_id_type>  _checkpoints;
 
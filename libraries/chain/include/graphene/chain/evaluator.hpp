@@ -65,6 +65,12 @@ namespace graphene { namespace chain {
        */
       virtual void pay_fee();
 
+      /**
+       * Restores the state of a newly constructed evaluator, so that op_evaluator_impl can reuse the instance for
+       * the next operation. This implementation resets the fee members; derived evaluators reset their own state.
+       */
+      virtual void reset();
+
       database& db()const;
 
       //void check_required_authorities(const operation& op);
@@ -114,7 +120,7 @@ namespace graphene { namespace chain {
       const account_statistics_object* fee_paying_account_statistics = nullptr;
       const asset_object*              fee_asset          = nullptr;
       const asset_dynamic_data_object* fee_asset_dyn_data = nullptr;
-      transaction_evaluation_state*    trx_state;
+      transaction_evaluation_state*    trx_state = nullptr;
    };
 
    class op_evaluator
@@ -124,15 +130,50 @@ namespace graphene { namespace chain {
       virtual operation_result evaluate(transaction_evaluation_state& eval_state, const operation& op, bool apply) = 0;
    };
 
+   /**
+    * Keeps the evaluators of one operation type for reuse, so that buffers held by an evaluator keep their memory
+    * from one operation to the next. The registry belongs to one database, which is only used by one thread at a
+    * time, so no locking is needed.
+    */
    template<typename T>
    class op_evaluator_impl : public op_evaluator
    {
    public:
       virtual operation_result evaluate(transaction_evaluation_state& eval_state, const operation& op, bool apply = true) override
       {
-         T eval;
-         return eval.start_evaluate(eval_state, op, apply);
+         evaluator_lease lease( *this );
+         return lease.eval->start_evaluate(eval_state, op, apply);
       }
+
+   private:
+      /// Proposals apply operations from inside an evaluator, so an instance is only reused once it is returned
+      struct evaluator_lease
+      {
+         explicit evaluator_lease( op_evaluator_impl& o ) : owner( o )
+         {
+            if( owner._idle.empty() )
+               eval.reset( new T() );
+            else
+            {
+               eval = std::move( owner._idle.back() );
+               owner._idle.pop_back();
+            }
+         }
+         ~evaluator_lease()
+         {
+            eval->reset();
+            try {
+               owner._idle.push_back( std::move( eval ) );
+            } catch( ... ) {
+               // the instance is simply freed
+            }
+         }
+
+         op_evaluator_impl&   owner;
+         std::unique_ptr<T>   eval;
+      };
+
+      std::vector< std::unique_ptr<T> > _idle;
    };
 
    template<typename DerivedEvaluator>
@@ -141,6 +182,12 @@ namespace graphene { namespace chain {
    public:
       virtual int get_type()const override { return operation::tag<typename DerivedEvaluator::operation_type>::value; }
 
+      /// Assigns a newly constructed evaluator; evaluators that keep buffers override this to keep their memory
+      virtual void reset() override
+      {
+         *static_cast<DerivedEvaluator*>(this) = DerivedEvaluator();
+      }
+
       virtual operation_result evaluate(const operation& o) final override
       {
          auto* eval = static_cast<DerivedEvaluator*>(this);
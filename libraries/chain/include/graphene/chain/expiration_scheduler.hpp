@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/index.hpp>
+#include <graphene/db/object_id.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace chain {
+   using graphene::db::object;
+   using graphene::db::object_id_type;
+   using graphene::db::secondary_index;
+
+   /**
+    * The kinds of objects removed or processed by the expiration steps of database::_apply_block.
+    */
+   enum expiration_kind
+   {
+      expired_transactions,         ///< entries dropped from the transaction deduplication index
+      expired_proposals,            ///< proposals executed or deleted at their expiration time
+      expired_limit_orders,         ///< limit orders cancelled at their expiration time
+      expired_force_settlements,    ///< force settlements filled or cancelled
+      expired_withdraw_permissions, ///< withdraw permissions removed at their expiration time
+      expiration_kind_count
+   };
+
+   /**
+    *  @brief Hierarchical timing wheel of the objects that expire at a given time
+    *
+    *  Every scheduled object sits in one of four wheels of 256 slots, one per byte of its due time in seconds.
+    *  An object is kept in the wheel of the highest byte in which its due time differs from the time the
+    *  scheduler was last advanced to, so advancing only touches the slots that were passed over. An object
+    *  whose slot is passed over becomes due, or moves down to the wheel of a lower byte when its slot is the
+    *  one reached. Slots are ordered sets, so scheduling and cancelling cost a lookup in one slot, and
+    *  advancing by one block visits a handful of slots.
+    *
+    *  Due objects are kept per kind in (due time, id) order, which is the order of the by_expiration indexes,
+    *  and handed out in batches by due(). The scheduler is not undo-tracked: expiration_schedule_index keeps it
+    *  in sync with the object indexes, including on undo. Advancing is never undone, a due time at or before
+    *  the time advanced to simply makes the object due at once, and due() only returns objects due at the
+    *  time it is asked for, so popping blocks needs no special care.
+    *
+    *  Force settlements are not scheduled. They are processed per asset with a settlement volume limit and
+    *  are cancelled whatever their settlement date when their asset is globally settled.
+    */
+   class expiration_scheduler
+   {
+      public:
+         /// Schedule or reschedule an object, it is due once the scheduler is advanced to @p when or later
+         void schedule( expiration_kind kind, object_id_type id, fc::time_point_sec when );
+         void cancel( object_id_type id );
+         /// Make every object scheduled at or before @p now due
+         void advance( fc::time_point_sec now );
+         /// @return a batch of the objects of @p kind due at @p now, in (due time, id) order
+         std::vector<object_id_type> due( expiration_kind kind, fc::time_point_sec now )const;
+
+         /// @return the number of scheduled objects of @p kind, due or not
+         size_t size( expiration_kind kind )const { return _counts[kind]; }
+         void   clear();
+
+      private:
+         static const int level_bits = 8;
+         static const int levels = 4;
+         static const int slots = 1 << level_bits;
+         static const int due_level = levels;
+
+         struct entry
+         {
+            uint32_t         when;
+            object_id_type   id;
+            expiration_kind  kind;
+
+            bool operator < ( const entry& other )const
+            {
+               return when < other.when || ( when == other.when && id < other.id );
+            }
+         };
+         typedef std::set<entry> slot_type;
+
+         struct id_hash
+         {
+            size_t operator()( const object_id_type& id )const { return std::hash<uint64_t>()( id.number ); }
+         };
+
+         void       place( const entry& e );
+         slot_type& slot_of( uint32_t when, int level );
+         void       make_due( slot_type& slot );
+
+         uint32_t                                                   _now = 0;
+         std::array<std::array<slot_type, slots>, levels>           _wheels;
+         std::array<slot_type, expiration_kind_count>               _due;
+         struct location
+         {
+            entry  e;
+            int    level; ///< the wheel holding the entry, or due_level
+         };
+
+         std::unordered_map<object_id_type, location, id_hash>      _locations;
+         std::array<size_t, expiration_kind_count>                  _counts{};
+   };
+
+   /**
+    *  @brief Keeps an expiration_scheduler in sync with the transaction, proposal, limit order and withdraw
+    *  permission indexes
+    */
+   class expiration_schedule_index : public secondary_index
+   {
+      public:
+         explicit expiration_schedule_index( expiration_scheduler& scheduler ) : _scheduler( scheduler ) {}
+
+         virtual void object_inserted( const object& obj ) override { schedule( obj ); }
+         virtual void object_removed( const object& obj ) override  { _scheduler.cancel( obj.id ); }
+         virtual void object_modified( const object& after ) override { schedule( after ); }
+
+      private:
+         void schedule( const object& obj );
+
+         expiration_scheduler& _scheduler;
+   };
+
+} } // graphene::chain
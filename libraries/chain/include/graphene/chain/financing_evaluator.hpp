@@ -55,6 +55,7 @@ class issue_asset_to_investors_evaluator : public evaluator<issue_asset_to_inves
         std::vector<const asset_investment_object*>           investment_objects;
         std::vector<share_type>           issue_amounts;
 
+        virtual void reset() override;
         void_result do_evaluate( const issue_asset_to_investors_operation& op );
         void_result do_apply( const issue_asset_to_investors_operation& op );
 };
@@ -66,6 +67,7 @@ class refund_investment_evaluator : public evaluator<refund_investment_evaluator
 
         std::vector<const asset_investment_object *> investment_objects;
         const asset_dynamic_data_object *asset_dynamic = nullptr;
+        virtual void reset() override;
         void_result do_evaluate( const refund_investment_operation& op );
         void_result do_apply( const refund_investment_operation& op );
 };
@@ -91,6 +93,7 @@ class claim_asset_investment_evaluator : public evaluator<claim_asset_investment
         share_type tokens;
         const asset_dynamic_data_object *asset_dyn_data = nullptr;
         std::vector<const asset_investment_object *> investment_objects;
+        virtual void reset() override;
         void_result do_evaluate( const claim_asset_investment_operation& op);
         void_result do_apply( const claim_asset_investment_operation& op);
 };
@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <graphene/chain/protocol/block.hpp>
+#include <fc/io/raw.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
@@ -37,15 +38,21 @@ namespace graphene { namespace chain {
 
    struct fork_item
    {
+      fork_item( shared_ptr<const signed_block> b )
+      :num(b->block_num()),id(b->id()),block( std::move(b) ),data( *block ),packed_size( fc::raw::pack_size( data ) ){}
       fork_item( signed_block d )
-      :num(d.block_num()),id(d.id()),data( std::move(d) ){}
+      :fork_item( std::make_shared<const signed_block>( std::move(d) ) ){}
 
       block_id_type previous_id()const { return data.previous; }
 
       weak_ptr< fork_item > prev;
       uint32_t              num;    // initialized in ctor
       block_id_type         id;
-      signed_block          data;
+      /// the only copy of the block, shared with the block cache once the block is applied
+      shared_ptr<const signed_block> block;
+      const signed_block&   data;
+      /// size of the encoded block, counted against the memory limit of the fork database
+      size_t                packed_size;
    };
    typedef shared_ptr<fork_item> item_ptr;
 
@@ -59,6 +66,12 @@ namespace graphene { namespace chain {
     *
     *  Every time a block is pushed into the fork DB the
     *  block with the highest block_num will be returned.
+    *
+    *  The memory held by blocks of abandoned forks can also be
+    *  limited with set_max_bytes(), the oldest of them are
+    *  dropped first.  The branch of the head, and of the
+    *  previous head while a fork switch may still be undone,
+    *  are only limited by set_max_size().
     */
    class fork_database
    {
@@ -104,13 +117,19 @@ namespace graphene { namespace chain {
          > fork_multi_index_type;
 
          void set_max_size( uint32_t s );
+         /// Limit the encoded size of the blocks kept outside the branch of the head, 0 for no limit
+         void set_max_bytes( size_t s );
+         size_t total_bytes()const { return _total_bytes; }
 
       private:
          /** @return a pointer to the newly pushed item */
          void _push_block(const item_ptr& b );
          void _push_next(const item_ptr& newly_inserted);
+         void _prune_to_max_bytes( const item_ptr& previous_head = item_ptr() );
 
          uint32_t                 _max_size = 1024;
+         size_t                   _max_bytes = 0;
+         size_t                   _total_bytes = 0;
 
          fork_multi_index_type    _unlinked_index;
          fork_multi_index_type    _index;
@@ -25,8 +25,10 @@
 #include <fc/uint128.hpp>
 
 #include <graphene/chain/protocol/chain_parameters.hpp>
+#include <graphene/chain/protocol/fee_schedule.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/db/index.hpp>
 #include <graphene/db/object.hpp>
 
 namespace graphene { namespace chain {
@@ -54,6 +56,24 @@ namespace graphene { namespace chain {
          // n.b. witness scheduling is done by witness_schedule object
    };
 
+   /**
+    *  @brief Drops the database's fee_table whenever the global properties change, including on undo
+    *
+    *  The table is rebuilt from the current fee schedule the next time it is used.
+    */
+   class fee_table_index : public secondary_index
+   {
+      public:
+         explicit fee_table_index( fee_table& table ) : _table( table ) {}
+
+         virtual void object_inserted( const object& obj ) override { _table.clear(); }
+         virtual void object_removed( const object& obj ) override  { _table.clear(); }
+         virtual void object_modified( const object& after ) override { _table.clear(); }
+
+      private:
+         fee_table& _table;
+   };
+
    /**
     * @class dynamic_global_property_object
     * @brief Maintains global state information (committee_member list, current fees)
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/authority.hpp>
+
+#include <functional>
+#include <map>
+#include <tuple>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @class authority_cache
+    *  @brief Memoizes the authorities resolved by verify_authority() and the outcome of checking them
+    *
+    *  Checking the authority of an account against a set of signature keys only depends on the authorities reachable
+    *  from that account, so an account that signs many transactions with the same keys through other accounts has
+    *  its authority tree walked once.  The owner of the cache must clear() it whenever the owner or active authority
+    *  of any account changes, including changes made by undo, and whenever an account is removed.  All the getters
+    *  used with one cache must return the same, stable authority objects.
+    */
+   class authority_cache
+   {
+      public:
+         /** everything the outcome of a check depends on besides the authorities themselves */
+         struct check_key
+         {
+            account_id_type            account;
+            bool                       owner = false;
+            uint32_t                   max_recursion = 0;
+            flat_set<public_key_type>  signatures;
+            flat_set<public_key_type>  available_keys;
+            /** accounts already approved when the check started */
+            flat_set<account_id_type>  approved;
+
+            friend bool operator < ( const check_key& a, const check_key& b )
+            {
+               return std::tie( a.account, a.owner, a.max_recursion, a.signatures, a.available_keys, a.approved )
+                    < std::tie( b.account, b.owner, b.max_recursion, b.signatures, b.available_keys, b.approved );
+            }
+         };
+
+         struct check_result
+         {
+            bool                       satisfied = false;
+            /** keys the check signed with, they count as used signatures */
+            flat_set<public_key_type>  used_keys;
+            /** accounts found to be approved on the way */
+            flat_set<account_id_type>  approved;
+         };
+
+         typedef std::function<const authority*(account_id_type)> authority_getter;
+
+         /** returns the authority fetched for an account before, or fetches and remembers it */
+         const authority* get_active( account_id_type id, const authority_getter& fetch );
+         const authority* get_owner( account_id_type id, const authority_getter& fetch );
+
+         const check_result* find( const check_key& key );
+         void                store( check_key key, check_result result );
+
+         void                clear();
+         void                set_max_size( size_t s );
+         size_t              size()const { return _checks.size(); }
+         uint64_t            hits()const { return _hits; }
+         uint64_t            misses()const { return _misses; }
+
+      private:
+         const authority* resolve( std::map<account_id_type, const authority*>& resolved,
+                                   account_id_type id, const authority_getter& fetch );
+
+         std::map<account_id_type, const authority*>  _active;
+         std::map<account_id_type, const authority*>  _owner;
+         std::map<check_key, check_result>            _checks;
+         size_t                                       _max_size = 10000;
+         uint64_t                                     _hits = 0;
+         uint64_t                                     _misses = 0;
+   };
+
+} } // graphene::chain
@@ -150,6 +150,53 @@ namespace graphene { namespace chain {
 
    typedef fee_schedule fee_schedule_type;
 
+   /**
+    *  @brief The parameters of a fee_schedule resolved for every operation type, indexed by operation tag
+    *
+    *  fee_schedule::calculate_fee searches the parameter set and applies the fallbacks of fee_helper for every
+    *  operation it prices. A fee_table does that once per operation type when it is built and computes fees
+    *  from a direct lookup afterwards, with the same results. Operations whose fee does not depend on their
+    *  contents keep their base fee in the table, so pricing them does not visit the operation at all, and
+    *  set_fee does not need to iterate for them.
+    *
+    *  A fee_table is a snapshot: it must be rebuilt whenever the schedule it was built from changes.
+    */
+   class fee_table
+   {
+      public:
+         fee_table() {}
+         explicit fee_table( const fee_schedule& schedule ) { reset( schedule ); }
+
+         void reset( const fee_schedule& schedule );
+         void clear() { _entries.clear(); }
+         bool empty()const { return _entries.empty(); }
+
+         asset calculate_fee( const operation& op, const price& core_exchange_rate = price::unit_price() )const;
+         asset set_fee( operation& op, const price& core_exchange_rate = price::unit_price() )const;
+
+         /// @return true if the fee of operations with this tag does not depend on their contents
+         bool has_fixed_fee( int which )const;
+
+         template<typename Operation>
+         const typename Operation::fee_parameters_type& get()const
+         {
+            return entry( operation::tag<Operation>::value ).parameters.template get<typename Operation::fee_parameters_type>();
+         }
+
+      private:
+         struct entry_type
+         {
+            fee_parameters parameters;
+            bool           fixed = false;    ///< the fee is fixed_fee, whatever the operation contains
+            uint64_t       fixed_fee = 0;    ///< the unscaled fee of fixed fee operations
+         };
+
+         const entry_type& entry( int which )const;
+
+         std::vector<entry_type>  _entries;
+         uint32_t                 _scale = GRAPHENE_100_PERCENT;
+   };
+
 } } // graphene::chain
 
 FC_REFLECT_TYPENAME( graphene::chain::fee_parameters )
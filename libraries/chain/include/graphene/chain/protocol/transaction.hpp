@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <graphene/chain/protocol/authority_cache.hpp>
 #include <graphene/chain/protocol/operations.hpp>
 #include <graphene/chain/protocol/types.hpp>
 
@@ -135,20 +136,25 @@ namespace graphene { namespace chain {
        *  for a transaction.  The result is not always a minimal set of
        *  signatures, but any non-minimal result will still pass
        *  validation.
+       *
+       *  When a @ref cache is given, authorities and the outcome of
+       *  checking them are taken from it and remembered in it.
        */
       set<public_key_type> get_required_signatures(
          const chain_id_type& chain_id,
          const flat_set<public_key_type>& available_keys,
          const std::function<const authority*(account_id_type)>& get_active,
          const std::function<const authority*(account_id_type)>& get_owner,
-         uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH
+         uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH,
+         authority_cache* cache = nullptr
          )const;
 
       void verify_authority(
          const chain_id_type& chain_id,
          const std::function<const authority*(account_id_type)>& get_active,
          const std::function<const authority*(account_id_type)>& get_owner,
-         uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH )const;
+         uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH,
+         authority_cache* cache = nullptr )const;
 
       /**
        * This is a slower replacement for get_required_signatures()
@@ -179,7 +185,8 @@ namespace graphene { namespace chain {
                           uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH,
                           bool allow_committe = false,
                           const flat_set<account_id_type>& active_aprovals = flat_set<account_id_type>(),
-                          const flat_set<account_id_type>& owner_approvals = flat_set<account_id_type>());
+                          const flat_set<account_id_type>& owner_approvals = flat_set<account_id_type>(),
+                          authority_cache* cache = nullptr );
 
    /**
     *  @brief captures the result of evaluating the operations contained in the transaction
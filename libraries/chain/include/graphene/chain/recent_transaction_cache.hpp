@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/transaction.hpp>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @brief Bounded cache of the full transactions behind the deduplication records
+    *
+    *  The deduplication index only keeps transaction ids and expirations. The transactions themselves are kept
+    *  here for get_recent_transaction() and for serving them to peers. The cache is not undo-tracked, so it may
+    *  hold transactions whose block was popped; callers check the deduplication index first. When full, the
+    *  transaction expiring first is dropped.
+    */
+   class recent_transaction_cache
+   {
+      public:
+         void   set_max_size( size_t s );
+         size_t max_size()const { return _max_size; }
+         size_t size()const { return _transactions.size(); }
+
+         void insert( const transaction_id_type& id, const signed_transaction& trx );
+         /// Drop all transactions that expired before @p now
+         void remove_expired( fc::time_point_sec now );
+         void clear();
+
+         shared_ptr<const signed_transaction> fetch( const transaction_id_type& id )const;
+
+      private:
+         void remove_first();
+
+         size_t                                                     _max_size = 10000;
+         std::unordered_map<transaction_id_type, shared_ptr<const signed_transaction>,
+                            std::hash<transaction_id_type>>         _transactions;
+         /// expiration time of every cached transaction, earliest first
+         std::multimap<fc::time_point_sec, transaction_id_type>     _expiration_queue;
+   };
+
+} } // graphene::chain
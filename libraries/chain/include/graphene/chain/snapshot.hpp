@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/block.hpp>
+
+#include <iosfwd>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @defgroup snapshot Binary state snapshots
+    *
+    *  A snapshot file starts with snapshot_magic and snapshot_version as raw uint32 values, followed
+    *  by a sequence of records. Each record is a uint32 byte count, the bytes, and their sha256, so corruption is
+    *  detected before anything is loaded. The first record holds the packed snapshot_header. For each of its
+    *  index_count indexes follow a record holding the packed snapshot_index_header and chunk_count chunk records.
+    *  A chunk is a concatenation of objects, each in the same encoding primary_index uses on disk (the fc::raw
+    *  encoding of the object, prefixed by its size). Like primary_index::open, importing refuses an index whose
+    *  object_version differs from the running node's.
+    *  @{
+    */
+   const uint32_t snapshot_magic = 0x504e5347; // "GSNP"
+   const uint32_t snapshot_version = 2;
+   /// Objects are collected into chunks of roughly this many bytes
+   const uint32_t snapshot_chunk_size = 1024 * 1024;
+   const uint32_t snapshot_max_record_size = 256 * 1024 * 1024;
+
+   struct snapshot_header
+   {
+      chain_id_type  chain_id;
+      std::string    db_version;
+      /// The state in the snapshot is the state right after applying this block
+      signed_block   head_block;
+      uint32_t       last_irreversible_block_num = 0;
+      uint32_t       index_count = 0;
+   };
+
+   struct snapshot_index_header
+   {
+      uint8_t        space_id = 0;
+      uint8_t        type_id = 0;
+      object_id_type next_id;
+      uint64_t       object_count = 0;
+      uint32_t       chunk_count = 0;
+      /// index::get_object_version() of the exporting node
+      fc::sha256     object_version;
+   };
+
+   void         write_snapshot_record( std::ostream& out, const vector<char>& data );
+   /// Reads one record and verifies its checksum
+   vector<char> read_snapshot_record( std::istream& in );
+   /// @}
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::snapshot_header,
+            (chain_id)(db_version)(head_block)(last_irreversible_block_num)(index_count) )
+FC_REFLECT( graphene::chain::snapshot_index_header,
+            (space_id)(type_id)(next_id)(object_count)(chunk_count)(object_version) )
@@ -43,6 +43,9 @@ namespace graphene { namespace chain {
     * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
     * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
     * expired can be removed from the index.
+    *
+    * Only the id and expiration are kept, so that the index and its undo history stay small. The full transaction
+    * is kept in the database's recent_transaction_cache.
     */
    class transaction_object : public abstract_object<transaction_object>
    {
@@ -50,10 +53,10 @@ namespace graphene { namespace chain {
          static const uint8_t space_id = implementation_ids;
          static const uint8_t type_id  = impl_transaction_object_type;
 
-         signed_transaction  trx;
          transaction_id_type trx_id;
+         time_point_sec      expiration;
 
-         time_point_sec get_expiration()const { return trx.expiration; }
+         time_point_sec get_expiration()const { return expiration; }
    };
 
    struct by_expiration;
@@ -71,4 +74,4 @@ namespace graphene { namespace chain {
    typedef generic_index<transaction_object, transaction_multi_index_type> transaction_index;
 } }
 
-FC_REFLECT_DERIVED( graphene::chain::transaction_object, (graphene::db::object), (trx)(trx_id) )
+FC_REFLECT_DERIVED( graphene::chain::transaction_object, (graphene::db::object), (trx_id)(expiration) )
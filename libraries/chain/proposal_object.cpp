@@ -38,7 +38,8 @@ bool proposal_object::is_authorized_to_execute(database& db) const
                         db.get_global_properties().parameters.max_authority_depth,
                         true, /* allow committeee */
                         available_active_approvals,
-                        available_owner_approvals );
+                        available_owner_approvals,
+                        &db.get_authority_cache() );
    } 
    catch ( const fc::exception& e )
    {
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/chain/protocol/authority_cache.hpp>
+
+namespace graphene { namespace chain {
+
+const authority* authority_cache::resolve( std::map<account_id_type, const authority*>& resolved,
+                                           account_id_type id, const authority_getter& fetch )
+{
+   auto itr = resolved.find( id );
+   if( itr != resolved.end() )
+      return itr->second;
+   const authority* auth = fetch( id );
+   if( auth != nullptr )
+      resolved.emplace( id, auth );
+   return auth;
+}
+
+const authority* authority_cache::get_active( account_id_type id, const authority_getter& fetch )
+{
+   return resolve( _active, id, fetch );
+}
+
+const authority* authority_cache::get_owner( account_id_type id, const authority_getter& fetch )
+{
+   return resolve( _owner, id, fetch );
+}
+
+const authority_cache::check_result* authority_cache::find( const check_key& key )
+{
+   auto itr = _checks.find( key );
+   if( itr == _checks.end() )
+   {
+      ++_misses;
+      return nullptr;
+   }
+   ++_hits;
+   return &itr->second;
+}
+
+void authority_cache::store( check_key key, check_result result )
+{
+   if( _max_size == 0 )
+      return;
+   if( _checks.size() >= _max_size )
+      _checks.clear();
+   _checks.emplace( std::move( key ), std::move( result ) );
+}
+
+void authority_cache::clear()
+{
+   _active.clear();
+   _owner.clear();
+   _checks.clear();
+}
+
+void authority_cache::set_max_size( size_t s )
+{
+   _max_size = s;
+   if( _checks.size() > _max_size )
+      _checks.clear();
+}
+
+} } // graphene::chain
@@ -25,8 +25,55 @@
 #include <fc/io/raw.hpp>
 #include <fc/bitutil.hpp>
 #include <algorithm>
+#include <exception>
+#include <thread>
 
 namespace graphene { namespace chain {
+   namespace {
+      /// below this many transactions per thread, starting the threads costs more than hashing on the caller
+      const size_t min_transactions_per_digest_thread = 128;
+
+      void merkle_digests( const vector<processed_transaction>& transactions, vector<digest_type>& ids )
+      {
+         const size_t count = transactions.size();
+         const size_t threads = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                  count / min_transactions_per_digest_thread );
+         if( threads < 2 )
+         {
+            for( size_t i = 0; i < count; ++i )
+               ids[i] = transactions[i].merkle_digest();
+            return;
+         }
+
+         // every thread hashes its own slice of the leaves
+         const size_t per_thread = ( count + threads - 1 ) / threads;
+         vector<std::exception_ptr> errors( threads );
+         vector<std::thread> workers;
+         workers.reserve( threads );
+         for( size_t t = 0; t < threads; ++t )
+         {
+            const size_t begin = t * per_thread;
+            const size_t end = std::min( count, begin + per_thread );
+            workers.emplace_back( [&transactions, &ids, &errors, t, begin, end]() {
+               try
+               {
+                  for( size_t i = begin; i < end; ++i )
+                     ids[i] = transactions[i].merkle_digest();
+               }
+               catch( ... )
+               {
+                  errors[t] = std::current_exception();
+               }
+            });
+         }
+         for( auto& worker : workers )
+            worker.join();
+         for( const auto& error : errors )
+            if( error )
+               std::rethrow_exception( error );
+      }
+   }
+
    digest_type block_header::digest()const
    {
       return digest_type::hash(*this);
@@ -69,8 +116,7 @@ namespace graphene { namespace chain {
 
       vector<digest_type> ids;
       ids.resize( transactions.size() );
-      for( uint32_t i = 0; i < transactions.size(); ++i )
-         ids[i] = transactions[i].merkle_digest();
+      merkle_digests( transactions, ids );
 
       vector<digest_type>::size_type current_number_of_hashes = ids.size();
       while( current_number_of_hashes > 1 )
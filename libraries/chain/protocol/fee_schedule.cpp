@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #include <algorithm>
+#include <type_traits>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <fc/smart_ref_impl.hpp>
 
@@ -130,13 +131,9 @@ namespace graphene { namespace chain {
       this->scale = 0;
    }
 
-   asset fee_schedule::calculate_fee( const operation& op, const price& core_exchange_rate )const
+   static asset core_fee_to_asset( const fc::uint128& scaled, const price& core_exchange_rate )
    {
-      auto base_value = op.visit( calc_fee_visitor( *this, op ) );
-      auto scaled = fc::uint128(base_value) * scale;
-      scaled /= GRAPHENE_100_PERCENT;
       FC_ASSERT( scaled <= GRAPHENE_MAX_SHARE_SUPPLY );
-      //idump( (base_value)(scaled)(core_exchange_rate) );
       auto result = asset( scaled.to_uint64(), asset_id_type(0) ) * core_exchange_rate;
       //FC_ASSERT( result * core_exchange_rate >= asset( scaled.to_uint64()) );
 
@@ -147,14 +144,15 @@ namespace graphene { namespace chain {
       return result;
    }
 
-   asset fee_schedule::set_fee( operation& op, const price& core_exchange_rate )const
+   template<typename Schedule>
+   static asset stabilize_fee( const Schedule& schedule, operation& op, const price& core_exchange_rate )
    {
-      auto f = calculate_fee( op, core_exchange_rate );
+      auto f = schedule.calculate_fee( op, core_exchange_rate );
       auto f_max = f;
       for( int i=0; i<MAX_FEE_STABILIZATION_ITERATION; i++ )
       {
          op.visit( set_fee_visitor( f_max ) );
-         auto f2 = calculate_fee( op, core_exchange_rate );
+         auto f2 = schedule.calculate_fee( op, core_exchange_rate );
          if( f == f2 )
             break;
          f_max = std::max( f_max, f2 );
@@ -169,6 +167,112 @@ namespace graphene { namespace chain {
       return f_max;
    }
 
+   asset fee_schedule::calculate_fee( const operation& op, const price& core_exchange_rate )const
+   {
+      auto base_value = op.visit( calc_fee_visitor( *this, op ) );
+      auto scaled = fc::uint128(base_value) * scale;
+      scaled /= GRAPHENE_100_PERCENT;
+      //idump( (base_value)(scaled)(core_exchange_rate) );
+      return core_fee_to_asset( scaled, core_exchange_rate );
+   }
+
+   asset fee_schedule::set_fee( operation& op, const price& core_exchange_rate )const
+   {
+      return stabilize_fee( *this, op, core_exchange_rate );
+   }
+
+   /// true for operations that replace base_operation::calculate_fee, which only returns the fee parameter
+   template<typename OpType>
+   struct has_own_calculate_fee
+   {
+      template<typename T> static std::true_type test( decltype(&T::calculate_fee) );
+      template<typename T> static std::false_type test( ... );
+      static const bool value = decltype( test<OpType>( nullptr ) )::value;
+   };
+
+   struct fee_table_entry_visitor
+   {
+      typedef void result_type;
+
+      const fee_schedule& schedule;
+      fee_parameters&     parameters;
+      bool&               fixed;
+      uint64_t&           fixed_fee;
+
+      template<typename OpType>
+      void operator()( const OpType& )const
+      {
+         typedef typename OpType::fee_parameters_type parameters_type;
+         // same lookup and fallbacks as calc_fee_visitor
+         try {
+            parameters = fee_parameters( schedule.get<OpType>() );
+         } catch( const fc::assert_exception& ) {
+            parameters = fee_parameters( parameters_type() );
+         }
+         fixed = !has_own_calculate_fee<OpType>::value;
+         if( fixed )
+            fixed_fee = OpType().calculate_fee( parameters.get<parameters_type>() ).value;
+      }
+   };
+
+   struct fee_table_calc_visitor
+   {
+      typedef uint64_t result_type;
+
+      const fee_parameters& parameters;
+
+      template<typename OpType>
+      result_type operator()( const OpType& op )const
+      {
+         return op.calculate_fee( parameters.get<typename OpType::fee_parameters_type>() ).value;
+      }
+   };
+
+   void fee_table::reset( const fee_schedule& schedule )
+   {
+      operation op;
+      const int count = op.count();
+      _entries.clear();
+      _entries.resize( count );
+      _scale = schedule.scale;
+      for( int i = 0; i < count; ++i )
+      {
+         entry_type& e = _entries[i];
+         op.set_which( i );
+         op.visit( fee_table_entry_visitor{ schedule, e.parameters, e.fixed, e.fixed_fee } );
+      }
+   }
+
+   const fee_table::entry_type& fee_table::entry( int which )const
+   {
+      FC_ASSERT( which >= 0 && size_t(which) < _entries.size(), "No fee parameters for operation ${w}", ("w",which) );
+      return _entries[which];
+   }
+
+   bool fee_table::has_fixed_fee( int which )const
+   {
+      return entry( which ).fixed;
+   }
+
+   asset fee_table::calculate_fee( const operation& op, const price& core_exchange_rate )const
+   {
+      const entry_type& e = entry( op.which() );
+      const uint64_t base_value = e.fixed ? e.fixed_fee : op.visit( fee_table_calc_visitor{ e.parameters } );
+      auto scaled = fc::uint128(base_value) * _scale;
+      scaled /= GRAPHENE_100_PERCENT;
+      return core_fee_to_asset( scaled, core_exchange_rate );
+   }
+
+   asset fee_table::set_fee( operation& op, const price& core_exchange_rate )const
+   {
+      if( !entry( op.which() ).fixed )
+         return stabilize_fee( *this, op, core_exchange_rate );
+      // the fee does not depend on the operation, so setting it cannot change it
+      const asset f = calculate_fee( op, core_exchange_rate );
+      op.visit( set_fee_visitor( f ) );
+      return f;
+   }
+
    void chain_parameters::validate()const
    {
       current_fees->validate();
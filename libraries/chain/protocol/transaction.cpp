@@ -117,9 +117,15 @@ struct sign_state
          {
             auto pk = available_keys.find(k);
             if( pk  != available_keys.end() )
+            {
+               if( recording != nullptr )
+                  recording->used_keys.insert( k );
                return provided_signatures[k] = true;
+            }
             return false;
          }
+         if( recording != nullptr )
+            recording->used_keys.insert( k );
          return itr->second = true;
       }
 
@@ -159,10 +165,59 @@ struct sign_state
          return provided_signatures[itr->second] = true;
       }
 
+      const authority* active_of( account_id_type id )
+      {
+         return cache != nullptr ? cache->get_active( id, get_active ) : get_active( id );
+      }
+
       bool check_authority( account_id_type id )
       {
          if( approved_by.find(id) != approved_by.end() ) return true;
-         return check_authority( get_active(id) );
+         return check_account( id, false );
+      }
+
+      bool check_owner( account_id_type id )
+      {
+         return check_account( id, true );
+      }
+
+      /**
+       *  Checks the active or owner authority of a required account.  Authorities that delegate to other accounts
+       *  are looked up in the cache first, a check that touches address authorities is never stored because those
+       *  signatures are matched against state built up by earlier checks.
+       */
+      bool check_account( account_id_type id, bool owner )
+      {
+         if( cache == nullptr )
+            return check_authority( owner ? get_owner(id) : get_active(id) );
+
+         const authority* auth = owner ? cache->get_owner( id, get_owner ) : cache->get_active( id, get_active );
+         if( auth == nullptr || auth->account_auths.empty() )
+            return check_authority( auth );
+
+         authority_cache::check_key key;
+         key.account = id;
+         key.owner = owner;
+         key.max_recursion = max_recursion;
+         key.signatures = signatures;
+         key.available_keys = available_keys;
+         key.approved = approved_by;
+         if( const authority_cache::check_result* hit = cache->find( key ) )
+         {
+            for( const auto& k : hit->used_keys )
+               provided_signatures[k] = true;
+            approved_by.insert( hit->approved.begin(), hit->approved.end() );
+            return hit->satisfied;
+         }
+
+         authority_cache::check_result result;
+         recording = &result;
+         cacheable = true;
+         result.satisfied = check_authority( auth );
+         recording = nullptr;
+         if( cacheable )
+            cache->store( std::move( key ), result );
+         return result.satisfied;
       }
 
       /**
@@ -173,6 +228,8 @@ struct sign_state
       {
          if( au == nullptr ) return false;
          const authority& auth = *au;
+         if( !auth.address_auths.empty() )
+            cacheable = false;
 
          uint32_t total_weight = 0;
          for( const auto& k : auth.key_auths )
@@ -197,9 +254,11 @@ struct sign_state
             {
                if( depth == max_recursion )
                   continue;
-               if( check_authority( get_active( a.first ), depth+1 ) )
+               if( check_authority( active_of( a.first ), depth+1 ) )
                {
                   approved_by.insert( a.first );
+                  if( recording != nullptr )
+                     recording->approved.insert( a.first );
                   total_weight += a.second;
                   if( total_weight >= auth.weight_threshold )
                      return true;
@@ -229,8 +288,10 @@ struct sign_state
 
       sign_state( const flat_set<public_key_type>& sigs,
                   const std::function<const authority*(account_id_type)>& a,
-                  const flat_set<public_key_type>& keys = empty_keyset )
-      :get_active(a),available_keys(keys)
+                  const std::function<const authority*(account_id_type)>& o,
+                  const flat_set<public_key_type>& keys = empty_keyset,
+                  authority_cache* c = nullptr )
+      :get_active(a),get_owner(o),signatures(sigs),available_keys(keys),cache(c)
       {
          for( const auto& key : sigs )
             provided_signatures[ key ] = false;
@@ -238,7 +299,13 @@ struct sign_state
       }
 
       const std::function<const authority*(account_id_type)>& get_active;
+      const std::function<const authority*(account_id_type)>& get_owner;
+      const flat_set<public_key_type>&                        signatures;
       const flat_set<public_key_type>&                        available_keys;
+      authority_cache*                                        cache;
+      /** the check being computed for the cache, if any */
+      authority_cache::check_result*                          recording = nullptr;
+      bool                                                    cacheable = true;
 
       flat_map<public_key_type,bool>   provided_signatures;
       flat_set<account_id_type>        approved_by;
@@ -252,7 +319,8 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
                        uint32_t max_recursion_depth,
                        bool  allow_committe,
                        const flat_set<account_id_type>& active_aprovals,
-                       const flat_set<account_id_type>& owner_approvals )
+                       const flat_set<account_id_type>& owner_approvals,
+                       authority_cache* cache )
 { try {
    flat_set<account_id_type> required_active;
    flat_set<account_id_type> required_owner;
@@ -265,7 +333,7 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
       GRAPHENE_ASSERT( required_active.find(GRAPHENE_COMMITTEE_ACCOUNT) == required_active.end(),
                        invalid_committee_approval, "Committee account may only propose transactions" );
 
-   sign_state s(sigs,get_active);
+   sign_state s( sigs, get_active, get_owner, empty_keyset, cache );
    s.max_recursion = max_recursion_depth;
    for( auto& id : active_aprovals )
       s.approved_by.insert( id );
@@ -281,14 +349,14 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
    for( auto id : required_active )
    {
       GRAPHENE_ASSERT( s.check_authority(id) || 
-                       s.check_authority(get_owner(id)), 
+                       s.check_owner(id), 
                        tx_missing_active_auth, "Missing Active Authority ${id}", ("id",id)("auth",*get_active(id))("owner",*get_owner(id)) );
    }
 
    for( auto id : required_owner )
    {
       GRAPHENE_ASSERT( owner_approvals.find(id) != owner_approvals.end() ||
-                       s.check_authority(get_owner(id)), 
+                       s.check_owner(id), 
                        tx_missing_owner_auth, "Missing Owner Authority ${id}", ("id",id)("auth",*get_owner(id)) );
    }
 
@@ -321,7 +389,8 @@ set<public_key_type> signed_transaction::get_required_signatures(
    const flat_set<public_key_type>& available_keys,
    const std::function<const authority*(account_id_type)>& get_active,
    const std::function<const authority*(account_id_type)>& get_owner,
-   uint32_t max_recursion_depth )const
+   uint32_t max_recursion_depth,
+   authority_cache* cache )const
 {
    flat_set<account_id_type> required_active;
    flat_set<account_id_type> required_owner;
@@ -329,15 +398,15 @@ set<public_key_type> signed_transaction::get_required_signatures(
    get_required_authorities( required_active, required_owner, other );
 
    flat_set<public_key_type> signature_keys = get_signature_keys( chain_id );
-   sign_state s( signature_keys, get_active, available_keys );
+   sign_state s( signature_keys, get_active, get_owner, available_keys, cache );
    s.max_recursion = max_recursion_depth;
 
    for( const auto& auth : other )
       s.check_authority(&auth);
    for( auto& owner : required_owner )
-      s.check_authority( get_owner( owner ) );
+      s.check_owner( owner );
    for( auto& active : required_active )
-      s.check_authority( active ) || s.check_authority( get_owner( active ) );
+      s.check_authority( active ) || s.check_owner( active );
 
    s.remove_unused_signatures();
 
@@ -382,9 +451,11 @@ void signed_transaction::verify_authority(
    const chain_id_type& chain_id,
    const std::function<const authority*(account_id_type)>& get_active,
    const std::function<const authority*(account_id_type)>& get_owner,
-   uint32_t max_recursion )const
+   uint32_t max_recursion,
+   authority_cache* cache )const
 { try {
-   graphene::chain::verify_authority( operations, get_signature_keys( chain_id ), get_active, get_owner, max_recursion );
+   graphene::chain::verify_authority( operations, get_signature_keys( chain_id ), get_active, get_owner, max_recursion,
+                                      false, flat_set<account_id_type>(), flat_set<account_id_type>(), cache );
 } FC_CAPTURE_AND_RETHROW( (*this) ) }
 
 } } // graphene::chain
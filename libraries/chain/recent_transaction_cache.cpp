@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/recent_transaction_cache.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+namespace graphene { namespace chain {
+
+void recent_transaction_cache::set_max_size( size_t s )
+{
+   _max_size = s;
+   while( _transactions.size() > _max_size )
+      remove_first();
+}
+
+void recent_transaction_cache::insert( const transaction_id_type& id, const signed_transaction& trx )
+{
+   if( _max_size == 0 || _transactions.find( id ) != _transactions.end() )
+      return;
+
+   _transactions[id] = std::make_shared<const signed_transaction>( trx );
+   _expiration_queue.emplace( trx.expiration, id );
+
+   if( _transactions.size() > _max_size )
+      remove_first();
+}
+
+void recent_transaction_cache::remove_expired( fc::time_point_sec now )
+{
+   while( !_expiration_queue.empty() && _expiration_queue.begin()->first < now )
+      remove_first();
+}
+
+void recent_transaction_cache::clear()
+{
+   _transactions.clear();
+   _expiration_queue.clear();
+}
+
+shared_ptr<const signed_transaction> recent_transaction_cache::fetch( const transaction_id_type& id )const
+{
+   auto itr = _transactions.find( id );
+   if( itr == _transactions.end() )
+      return shared_ptr<const signed_transaction>();
+   return itr->second;
+}
+
+void recent_transaction_cache::remove_first()
+{
+   _transactions.erase( _expiration_queue.begin()->second );
+   _expiration_queue.erase( _expiration_queue.begin() );
+}
+
+} } // graphene::chain
@@ -77,6 +77,9 @@ namespace graphene { namespace db {
          virtual void           use_next_id() = 0;
          virtual void           set_next_id( object_id_type id ) = 0;
 
+         /** @return a digest identifying the serialization of the objects in this index */
+         virtual fc::sha256     get_object_version()const = 0;
+
          virtual const object&  load( const std::vector<char>& data ) = 0;
          /**
           *  Polymorphically insert by moving an object into the index.
@@ -217,7 +220,7 @@ namespace graphene { namespace db {
          virtual void           use_next_id()override                    { ++_next_id.number;  }
          virtual void           set_next_id( object_id_type id )override { _next_id = id;      }
 
-         fc::sha256 get_object_version()const
+         virtual fc::sha256 get_object_version()const override
          {
             std::string desc = "1.0";//get_type_description<object_type>();
             return fc::sha256::hash(desc);
@@ -75,6 +75,8 @@ namespace graphene { namespace db {
          const index&  get_index()const { return get_index(T::space_id,T::type_id); }
          const index&  get_index(uint8_t space_id, uint8_t type_id)const;
          const index&  get_index(object_id_type id)const { return get_index(id.space(),id.type()); }
+         /// @return the index registered for the given space and type, or nullptr if there is none
+         const index*  find_index(uint8_t space_id, uint8_t type_id)const;
          /// @}
 
          const object& get_object( object_id_type id )const;
@@ -161,6 +163,7 @@ namespace graphene { namespace db {
          index& get_mutable_index()                   { return get_mutable_index(T::space_id,T::type_id); }
          index& get_mutable_index(object_id_type id)  { return get_mutable_index(id.space(),id.type());   }
          index& get_mutable_index(uint8_t space_id, uint8_t type_id);
+         index* find_mutable_index(uint8_t space_id, uint8_t type_id);
 
      private:
 
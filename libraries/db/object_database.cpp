@@ -68,6 +68,19 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
    return *idx;
 }
 
+const index* object_database::find_index(uint8_t space_id, uint8_t type_id)const
+{
+   if( _index.size() <= space_id || _index[space_id].size() <= type_id )
+      return nullptr;
+   return _index[space_id][type_id].get();
+}
+index* object_database::find_mutable_index(uint8_t space_id, uint8_t type_id)
+{
+   if( _index.size() <= space_id || _index[space_id].size() <= type_id )
+      return nullptr;
+   return _index[space_id][type_id].get();
+}
+
 void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
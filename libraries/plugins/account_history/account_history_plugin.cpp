@@ -23,6 +23,7 @@
  */
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/history_cold_store.hpp>
 
 #include <graphene/app/impacted.hpp>
 
@@ -67,15 +68,39 @@ class account_history_plugin_impl
       bool _partial_operations = false;
       primary_index< operation_history_index >* _oho_index;
       uint32_t _max_ops_per_account = -1;
+      bool _compact_history = false;
    private:
       /** add one history record, then check and remove the earliest history record */
       void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
 
+      /** append the entries collected for the current block to the account history chunks */
+      void flush_compact_history();
+
+      /** move the operations of irreversible blocks to the cold store */
+      void spill_operations();
+
+      bool is_irreversible( operation_history_id_type id );
+
+      /** entries of the block being processed when _compact_history is set, in application order */
+      flat_map< account_id_type, vector<operation_history_id_type> > _pending_entries;
+   public:
+      /** @return the given compact history chunk, from memory or from the cold store */
+      optional< vector<operation_history_id_type> > load_chunk( account_id_type account, uint32_t first_sequence )const;
+
+      /** @return lowest sequence of the account history which is still served */
+      uint32_t first_visible_sequence( const account_statistics_object& stats )const
+      {
+         return _cold_store.is_open() ? 1 : stats.removed_ops + 1;
+      }
+
+      history_cold_store _cold_store;
+
 };
 
 account_history_plugin_impl::~account_history_plugin_impl()
 {
-   return;
+   if( _cold_store.is_open() )
+      _cold_store.close();
 }
 
 void account_history_plugin_impl::update_account_histories( const signed_block& b )
@@ -192,10 +217,26 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
       if (_partial_operations && ! oho.valid())
          skip_oho_id();
    }
+
+   if( _compact_history )
+      flush_compact_history();
+   if( _cold_store.is_open() )
+   {
+      spill_operations();
+      // the spilled operations are gone from the database, hand them and the pages of this block to the OS now
+      // rather than whenever the stream buffers happen to fill up
+      _cold_store.flush();
+   }
 }
 
 void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_id_type op_id )
 {
+   if( _compact_history )
+   {
+      _pending_entries[account_id].push_back( op_id );
+      return;
+   }
+
    graphene::chain::database& db = database();
    const auto& stats_obj = account_id(db).statistics(db);
    // add new entry
@@ -253,6 +294,110 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
    }
 }
 
+void account_history_plugin_impl::flush_compact_history()
+{
+   graphene::chain::database& db = database();
+   const auto& by_seq_idx = db.get_index_type<account_history_chunk_index>().indices().get<by_account_seq>();
+   const uint32_t chunk_size = account_history_chunk_object::max_entries;
+
+   for( const auto& entry : _pending_entries )
+   {
+      const account_id_type account_id = entry.first;
+      const vector<operation_history_id_type>& ops = entry.second;
+      const auto& stats_obj = account_id(db).statistics(db);
+
+      // append, filling up the newest chunk before starting another one
+      uint32_t total_ops = stats_obj.total_ops;
+      size_t pos = 0;
+      while( pos < ops.size() )
+      {
+         const uint32_t offset = total_ops % chunk_size;
+         const size_t count = std::min<size_t>( ops.size() - pos, chunk_size - offset );
+         if( offset == 0 )
+         {
+            db.create<account_history_chunk_object>( [&]( account_history_chunk_object& obj ){
+               obj.account = account_id;
+               obj.first_sequence = total_ops + 1;
+               obj.operations.reserve( chunk_size );
+               obj.operations.insert( obj.operations.end(), ops.begin() + pos, ops.begin() + pos + count );
+            });
+         }
+         else
+         {
+            auto itr = by_seq_idx.find( boost::make_tuple( account_id, total_ops - offset + 1 ) );
+            FC_ASSERT( itr != by_seq_idx.end(), "Missing history chunk of account ${a}", ("a",account_id) );
+            db.modify( *itr, [&]( account_history_chunk_object& obj ){
+               obj.operations.insert( obj.operations.end(), ops.begin() + pos, ops.begin() + pos + count );
+            });
+         }
+         pos += count;
+         total_ops += count;
+      }
+
+      // trim, dropping the chunks which no longer hold any entry
+      uint32_t removed_ops = stats_obj.removed_ops;
+      if( total_ops - removed_ops > _max_ops_per_account )
+         removed_ops = total_ops - _max_ops_per_account;
+      auto itr = by_seq_idx.lower_bound( boost::make_tuple( account_id, 0 ) );
+      while( itr != by_seq_idx.end() && itr->account == account_id
+             && itr->first_sequence + chunk_size - 1 <= removed_ops )
+      {
+         if( _cold_store.is_open() )
+         {
+            // a chunk may only go to disk once none of its entries can be undone
+            if( !is_irreversible( itr->operations.back() ) )
+               break;
+            _cold_store.store_page( account_id, itr->first_sequence, itr->operations );
+         }
+         const auto itr_remove = itr;
+         ++itr;
+         db.remove( *itr_remove );
+      }
+
+      db.modify( stats_obj, [&]( account_statistics_object& obj ){
+         obj.total_ops = total_ops;
+         obj.removed_ops = removed_ops;
+      });
+   }
+   _pending_entries.clear();
+}
+
+bool account_history_plugin_impl::is_irreversible( operation_history_id_type id )
+{
+   graphene::chain::database& db = database();
+   const operation_history_object* op = db.find( id );
+   // operations are only moved to the cold store once irreversible
+   return op == nullptr || op->block_num <= db.get_dynamic_global_properties().last_irreversible_block_num;
+}
+
+void account_history_plugin_impl::spill_operations()
+{
+   graphene::chain::database& db = database();
+   const uint32_t lib = db.get_dynamic_global_properties().last_irreversible_block_num;
+   const auto& idx = _oho_index->indices();
+   auto itr = idx.begin();
+   while( itr != idx.end() && itr->block_num <= lib )
+   {
+      _cold_store.store_operation( *itr );
+      const auto itr_remove = itr;
+      ++itr;
+      db.remove( *itr_remove );
+   }
+}
+
+optional< vector<operation_history_id_type> > account_history_plugin_impl::load_chunk( account_id_type account,
+                                                                                       uint32_t first_sequence )const
+{
+   const graphene::chain::database& db = *_self.app().chain_database();
+   const auto& by_seq_idx = db.get_index_type<account_history_chunk_index>().indices().get<by_account_seq>();
+   auto itr = by_seq_idx.find( boost::make_tuple( account, first_sequence ) );
+   if( itr != by_seq_idx.end() )
+      return itr->operations;
+   if( _cold_store.is_open() )
+      return _cold_store.fetch_page( account, first_sequence );
+   return optional< vector<operation_history_id_type> >();
+}
+
 } // end namespace detail
 
 
@@ -283,6 +428,12 @@ void account_history_plugin::plugin_set_program_options(
          ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
          ("partial-operations", boost::program_options::value<bool>(), "Keep only those operations in memory that are related to account history tracking")
          ("max-ops-per-account", boost::program_options::value<uint32_t>(), "Maximum number of operations per account will be kept in memory")
+         ("compact-account-history", boost::program_options::value<bool>()->default_value(false),
+          "Store account history in chunks of operation ids instead of one object per entry, uses much less memory "
+          "(requires a replay when changed)")
+         ("history-cold-store-dir", boost::program_options::value<boost::filesystem::path>(),
+          "Move irreversible operations and trimmed compact account history to an on-disk store in this directory "
+          "and keep serving them from there (requires compact-account-history)")
          ;
    cfg.add(cli);
 }
@@ -292,6 +443,7 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
    database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
    my->_oho_index = database().add_index< primary_index< operation_history_index > >();
    database().add_index< primary_index< account_transaction_history_index > >();
+   database().add_index< primary_index< account_history_chunk_index > >();
 
    LOAD_VALUE_SET(options, "track-account", my->_tracked_accounts, graphene::chain::account_id_type);
    if (options.count("partial-operations")) {
@@ -300,6 +452,16 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
    if (options.count("max-ops-per-account")) {
        my->_max_ops_per_account = options["max-ops-per-account"].as<uint32_t>();
    }
+   if (options.count("compact-account-history")) {
+       my->_compact_history = options["compact-account-history"].as<bool>();
+   }
+   // trimmed chunks do not know whether other accounts still reference their operations
+   FC_ASSERT( !( my->_compact_history && my->_partial_operations ),
+              "compact-account-history can not be combined with partial-operations" );
+   if (options.count("history-cold-store-dir")) {
+       FC_ASSERT( my->_compact_history, "history-cold-store-dir requires compact-account-history" );
+       my->_cold_store.open( options["history-cold-store-dir"].as<boost::filesystem::path>() );
+   }
 }
 
 void account_history_plugin::plugin_startup()
@@ -311,4 +473,93 @@ flat_set<account_id_type> account_history_plugin::tracked_accounts() const
    return my->_tracked_accounts;
 }
 
+bool account_history_plugin::compact_history() const
+{
+   return my->_compact_history;
+}
+
+operation_history_object account_history_plugin::get_operation( operation_history_id_type id )const
+{
+   const database& db = *app().chain_database();
+   const operation_history_object* op = db.find( id );
+   if( op != nullptr )
+      return *op;
+   optional<operation_history_object> stored;
+   if( my->_cold_store.is_open() )
+      stored = my->_cold_store.fetch_operation( id );
+   FC_ASSERT( stored.valid(), "Operation ${id} not found", ("id",id) );
+   return *stored;
+}
+
+void account_history_plugin::for_each_compact_entry( account_id_type account, operation_history_id_type start,
+                                                     const std::function<bool(operation_history_id_type)>& f )const
+{
+   const database& db = *app().chain_database();
+   const auto& stats = account(db).statistics(db);
+   const uint32_t chunk_size = account_history_chunk_object::max_entries;
+   const uint32_t first_visible = my->first_visible_sequence( stats );
+   if( stats.total_ops < first_visible )
+      return;
+
+   // binary search for the newest chunk starting at or below start, operation ids grow with the sequence
+   uint32_t lo = ( first_visible - 1 ) / chunk_size;
+   uint32_t hi = ( stats.total_ops - 1 ) / chunk_size;
+   const uint32_t lowest = lo;
+   while( lo < hi )
+   {
+      const uint32_t mid = ( lo + hi + 1 ) / 2;
+      auto chunk = my->load_chunk( account, mid * chunk_size + 1 );
+      FC_ASSERT( chunk.valid(), "Missing history chunk of account ${a}", ("a",account) );
+      if( !( start < chunk->front() ) )
+         lo = mid;
+      else
+         hi = mid - 1;
+   }
+
+   for( int64_t k = lo; k >= lowest; --k )
+   {
+      const uint32_t first_sequence = uint32_t(k) * chunk_size + 1;
+      auto chunk = my->load_chunk( account, first_sequence );
+      FC_ASSERT( chunk.valid(), "Missing history chunk of account ${a}", ("a",account) );
+      for( int64_t i = int64_t(chunk->size()) - 1; i >= 0; --i )
+      {
+         if( first_sequence + i < first_visible )
+            return;
+         const operation_history_id_type id = (*chunk)[i];
+         if( start < id )
+            continue;
+         if( !f( id ) )
+            return;
+      }
+   }
+}
+
+vector<operation_history_id_type> account_history_plugin::get_compact_relative_history( account_id_type account,
+                                                                                         uint32_t stop, unsigned limit,
+                                                                                         uint32_t start )const
+{
+   const database& db = *app().chain_database();
+   vector<operation_history_id_type> result;
+   const auto& stats = account(db).statistics(db);
+   if( start == 0 )
+      start = stats.total_ops;
+   else
+      start = std::min( stats.total_ops, start );
+   stop = std::max( stop, my->first_visible_sequence( stats ) );
+   if( start < stop || limit == 0 )
+      return result;
+
+   const uint32_t chunk_size = account_history_chunk_object::max_entries;
+   uint32_t seq = start;
+   while( seq >= stop && result.size() < limit )
+   {
+      const uint32_t first_sequence = seq - ( seq - 1 ) % chunk_size;
+      auto chunk = my->load_chunk( account, first_sequence );
+      FC_ASSERT( chunk.valid(), "Missing history chunk of account ${a}", ("a",account) );
+      for( ; seq >= stop && seq >= first_sequence && result.size() < limit; --seq )
+         result.push_back( (*chunk)[ seq - first_sequence ] );
+   }
+   return result;
+}
+
 } }
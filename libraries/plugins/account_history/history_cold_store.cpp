@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/account_history/history_cold_store.hpp>
+
+#include <graphene/chain/protocol/fee_schedule.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+namespace graphene { namespace account_history {
+
+namespace {
+
+struct operation_index_entry
+{
+   uint64_t pos = 0;
+   uint32_t size = 0;
+   uint32_t reserved = 0;
+};
+
+struct page_header
+{
+   uint64_t account = 0;
+   uint32_t first_sequence = 0;
+   uint32_t count = 0;
+};
+
+const size_t page_record_size = sizeof(page_header) + history_cold_store::page_entries * sizeof(uint64_t);
+
+void open_file( std::fstream& f, const fc::path& p )
+{
+   f.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   if( !fc::exists( p ) )
+      f.open( p.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc );
+   else
+      f.open( p.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+}
+
+} // anonymous namespace
+
+void history_cold_store::open( const fc::path& dir )
+{ try {
+   fc::create_directories( dir );
+   open_file( _operations, dir / "operations" );
+   open_file( _operation_index, dir / "operations.index" );
+   open_file( _pages, dir / "pages" );
+
+   // rebuild the page offsets, ignoring a partially written trailing page
+   _page_offsets.clear();
+   _pages.seekg( 0, _pages.end );
+   const uint64_t page_count = uint64_t( _pages.tellg() ) / page_record_size;
+   for( uint64_t i = 0; i < page_count; ++i )
+   {
+      page_header h;
+      _pages.seekg( i * page_record_size );
+      _pages.read( (char*)&h, sizeof(h) );
+      vector<uint64_t>& offsets = _page_offsets[ account_id_type( h.account ) ];
+      FC_ASSERT( h.first_sequence == offsets.size() * page_entries + 1, "Corrupted history page ${i}", ("i",i) );
+      offsets.push_back( i * page_record_size );
+   }
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+bool history_cold_store::is_open()const
+{
+   return _pages.is_open();
+}
+
+void history_cold_store::flush()
+{
+   _operations.flush();
+   _operation_index.flush();
+   _pages.flush();
+}
+
+void history_cold_store::close()
+{
+   _operations.close();
+   _operation_index.close();
+   _pages.close();
+   _page_offsets.clear();
+}
+
+void history_cold_store::store_operation( const operation_history_object& op )
+{
+   const int64_t index_pos = sizeof(operation_index_entry) * int64_t( op.id.instance() );
+   _operation_index.seekg( 0, _operation_index.end );
+   if( _operation_index.tellg() >= int64_t( index_pos + sizeof(operation_index_entry) ) )
+   {
+      operation_index_entry e;
+      _operation_index.seekg( index_pos );
+      _operation_index.read( (char*)&e, sizeof(e) );
+      if( e.size > 0 )
+         return;
+   }
+
+   auto vec = fc::raw::pack( op );
+   operation_index_entry e;
+   _operations.seekp( 0, _operations.end );
+   e.pos = _operations.tellp();
+   e.size = vec.size();
+   _operations.write( vec.data(), vec.size() );
+   _operation_index.seekp( index_pos );
+   _operation_index.write( (char*)&e, sizeof(e) );
+}
+
+optional<operation_history_object> history_cold_store::fetch_operation( operation_history_id_type id )const
+{ try {
+   operation_index_entry e;
+   const int64_t index_pos = sizeof(e) * int64_t( id.instance.value );
+   _operation_index.seekg( 0, _operation_index.end );
+   if( _operation_index.tellg() < int64_t( index_pos + sizeof(e) ) )
+      return optional<operation_history_object>();
+   _operation_index.seekg( index_pos );
+   _operation_index.read( (char*)&e, sizeof(e) );
+   if( e.size == 0 )
+      return optional<operation_history_object>();
+
+   vector<char> data( e.size );
+   _operations.seekg( e.pos );
+   _operations.read( data.data(), e.size );
+   return fc::raw::unpack<operation_history_object>( data );
+} FC_CAPTURE_AND_RETHROW( (id) ) }
+
+void history_cold_store::store_page( account_id_type account, uint32_t first_sequence,
+                                     const vector<operation_history_id_type>& ops )
+{
+   FC_ASSERT( ops.size() == page_entries );
+   vector<uint64_t>& offsets = _page_offsets[account];
+   if( first_sequence <= offsets.size() * page_entries )
+      return;
+   FC_ASSERT( first_sequence == offsets.size() * page_entries + 1,
+              "History pages of account ${a} must be stored in order", ("a",account) );
+
+   page_header h;
+   h.account = account.instance.value;
+   h.first_sequence = first_sequence;
+   h.count = page_entries;
+   _pages.seekp( 0, _pages.end );
+   const uint64_t pos = _pages.tellp();
+   _pages.write( (const char*)&h, sizeof(h) );
+   for( const operation_history_id_type& id : ops )
+   {
+      const uint64_t instance = id.instance.value;
+      _pages.write( (const char*)&instance, sizeof(instance) );
+   }
+   offsets.push_back( pos );
+}
+
+uint32_t history_cold_store::stored_entries( account_id_type account )const
+{
+   auto itr = _page_offsets.find( account );
+   return itr == _page_offsets.end() ? 0 : itr->second.size() * page_entries;
+}
+
+optional<vector<operation_history_id_type>> history_cold_store::fetch_page( account_id_type account,
+                                                                              uint32_t first_sequence )const
+{ try {
+   auto itr = _page_offsets.find( account );
+   const uint32_t page = ( first_sequence - 1 ) / page_entries;
+   if( itr == _page_offsets.end() || page >= itr->second.size() )
+      return optional<vector<operation_history_id_type>>();
+
+   vector<uint64_t> instances( page_entries );
+   _pages.seekg( itr->second[page] + sizeof(page_header) );
+   _pages.read( (char*)instances.data(), instances.size() * sizeof(uint64_t) );
+
+   vector<operation_history_id_type> result;
+   result.reserve( page_entries );
+   for( uint64_t instance : instances )
+      result.push_back( operation_history_id_type( instance ) );
+   return result;
+} FC_CAPTURE_AND_RETHROW( (account)(first_sequence) ) }
+
+} } // graphene::account_history
@@ -52,9 +52,47 @@ namespace graphene { namespace account_history {
 
 enum account_history_object_type
 {
-   key_account_object_type = 0
+   key_account_object_type = 0,
+   account_history_chunk_object_type = 1
 };
 
+/**
+ *  @brief A run of consecutive history entries of one account
+ *
+ *  Used instead of account_transaction_history_object when compact-account-history is enabled. Entry number
+ *  @c i of the chunk has sequence first_sequence + i, and chunks start at sequence 1, 1 + max_entries, ... so the
+ *  chunk holding any sequence can be found directly. Entries are only ever appended; trimming just advances the
+ *  account's removed_ops counter and removes a chunk once all its entries are below it. With a cold store
+ *  configured, removed chunks are written to disk first and keep being served from there.
+ */
+class account_history_chunk_object : public abstract_object<account_history_chunk_object>
+{
+   public:
+      static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
+      static const uint8_t type_id  = account_history_chunk_object_type;
+      static const uint32_t max_entries = 64;
+
+      account_id_type                    account;
+      uint32_t                           first_sequence = 1;
+      vector<operation_history_id_type>  operations;
+};
+
+struct by_account_seq;
+typedef multi_index_container<
+   account_history_chunk_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_account_seq>,
+         composite_key< account_history_chunk_object,
+            member< account_history_chunk_object, account_id_type, &account_history_chunk_object::account>,
+            member< account_history_chunk_object, uint32_t, &account_history_chunk_object::first_sequence>
+         >
+      >
+   >
+> account_history_chunk_multi_index_type;
+
+typedef generic_index<account_history_chunk_object, account_history_chunk_multi_index_type> account_history_chunk_index;
+
 
 namespace detail
 {
@@ -76,12 +114,34 @@ class account_history_plugin : public graphene::app::plugin
 
       flat_set<account_id_type> tracked_accounts()const;
 
+      /// @return true if history is kept in account_history_chunk_object rather than account_transaction_history_object
+      bool compact_history()const;
+
+      /// @return the operation, read from the cold store if it was moved there
+      operation_history_object get_operation( operation_history_id_type id )const;
+
+      /**
+       * @brief Visit the compact history of an account from newest to oldest
+       * @param start Entries with an operation id above this one are skipped
+       * @param f Called with each operation id, returns false to stop
+       */
+      void for_each_compact_entry( account_id_type account, operation_history_id_type start,
+                                   const std::function<bool(operation_history_id_type)>& f )const;
+
+      /// @return ids of the compact history entries with sequence in [stop, start], newest first, as in
+      /// history_api::get_relative_account_history
+      vector<operation_history_id_type> get_compact_relative_history( account_id_type account, uint32_t stop,
+                                                                      unsigned limit, uint32_t start )const;
+
       friend class detail::account_history_plugin_impl;
       std::unique_ptr<detail::account_history_plugin_impl> my;
 };
 
 } } //graphene::account_history
 
+FC_REFLECT_DERIVED( graphene::account_history::account_history_chunk_object, (graphene::db::object),
+                    (account)(first_sequence)(operations) )
+
 /*struct by_id;
 struct by_seq;
 struct by_op;
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fstream>
+#include <map>
+
+namespace graphene { namespace account_history {
+   using namespace chain;
+
+   /**
+    *  @brief Append-only disk store for irreversible account history
+    *
+    *  Holds two kinds of records:
+    *  - operation_history_objects, fc::raw encoded in an "operations" file and located through an "operations.index"
+    *    file with one fixed size entry per operation instance, the same layout block_database uses for blocks;
+    *  - full account_history_chunk_object pages in a "pages" file. The per-account page offsets are rebuilt from the
+    *    page headers on open and kept in memory, which costs a few bytes per 64 history entries.
+    *
+    *  Only irreversible data may be stored. Storing a record that is already present is a no-op, so the owner can
+    *  simply store again after its in-memory state was rolled back by the undo database.
+    */
+   class history_cold_store
+   {
+      public:
+         static const uint32_t page_entries = 64;
+
+         void open( const fc::path& dir );
+         bool is_open()const;
+         void flush();
+         void close();
+
+         void store_operation( const operation_history_object& op );
+         optional<operation_history_object> fetch_operation( operation_history_id_type id )const;
+
+         /// Store entries first_sequence .. first_sequence + page_entries - 1 of the account's history
+         void store_page( account_id_type account, uint32_t first_sequence, const vector<operation_history_id_type>& ops );
+         /// @return number of history entries of the account held on disk, they are always the oldest ones
+         uint32_t stored_entries( account_id_type account )const;
+         /// @return the page starting at first_sequence, if stored
+         optional<vector<operation_history_id_type>> fetch_page( account_id_type account, uint32_t first_sequence )const;
+
+      private:
+         mutable std::fstream  _operations;
+         mutable std::fstream  _operation_index;
+         mutable std::fstream  _pages;
+         std::map< account_id_type, vector<uint64_t> >  _page_offsets;
+   };
+
+} } // graphene::account_history
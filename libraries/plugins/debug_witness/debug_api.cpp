@@ -29,6 +29,9 @@ class debug_api_impl
       void debug_update_object( const fc::variant_object& update );
       void debug_stream_json_objects( const std::string& filename );
       void debug_stream_json_objects_flush();
+      graphene::chain::apply_profile debug_get_apply_profile();
+      void debug_set_apply_profiling( bool enabled, uint32_t slow_block_threshold_ms );
+      void debug_reset_apply_profile();
       std::shared_ptr< graphene::debug_witness_plugin::debug_witness_plugin > get_plugin();
 
       graphene::app::application& app;
@@ -120,6 +123,23 @@ void debug_api_impl::debug_stream_json_objects_flush()
    get_plugin()->flush_json_object_stream();
 }
 
+graphene::chain::apply_profile debug_api_impl::debug_get_apply_profile()
+{
+   return app.chain_database()->get_apply_profiler().get_profile();
+}
+
+void debug_api_impl::debug_set_apply_profiling( bool enabled, uint32_t slow_block_threshold_ms )
+{
+   graphene::chain::apply_profiler& profiler = app.chain_database()->get_apply_profiler();
+   profiler.set_slow_block_threshold( fc::milliseconds( slow_block_threshold_ms ) );
+   profiler.enable( enabled );
+}
+
+void debug_api_impl::debug_reset_apply_profile()
+{
+   app.chain_database()->get_apply_profiler().reset();
+}
+
 } // detail
 
 debug_api::debug_api( graphene::app::application& app )
@@ -152,5 +172,20 @@ void debug_api::debug_stream_json_objects_flush()
    my->debug_stream_json_objects_flush();
 }
 
+graphene::chain::apply_profile debug_api::debug_get_apply_profile()
+{
+   return my->debug_get_apply_profile();
+}
+
+void debug_api::debug_set_apply_profiling( bool enabled, uint32_t slow_block_threshold_ms )
+{
+   my->debug_set_apply_profiling( enabled, slow_block_threshold_ms );
+}
+
+void debug_api::debug_reset_apply_profile()
+{
+   my->debug_reset_apply_profile();
+}
+
 
 } } // graphene::debug_witness
@@ -29,6 +29,8 @@
 #include <fc/api.hpp>
 #include <fc/variant_object.hpp>
 
+#include <graphene/chain/apply_profiler.hpp>
+
 namespace graphene { namespace app {
 class application;
 } }
@@ -82,6 +84,21 @@ class debug_api
        */
       void debug_stream_json_objects_flush();
 
+      /**
+       * Get the operation and block phase timings collected since the node started or the last reset.
+       */
+      graphene::chain::apply_profile debug_get_apply_profile();
+
+      /**
+       * Turn timing of block application on or off, and log blocks slower than the threshold (0 to not log).
+       */
+      void debug_set_apply_profiling( bool enabled, uint32_t slow_block_threshold_ms );
+
+      /**
+       * Clear the collected timings.
+       */
+      void debug_reset_apply_profile();
+
       std::shared_ptr< detail::debug_api_impl > my;
 };
 
@@ -93,4 +110,7 @@ FC_API(graphene::debug_witness::debug_api,
        (debug_update_object)
        (debug_stream_json_objects)
        (debug_stream_json_objects_flush)
+       (debug_get_apply_profile)
+       (debug_set_apply_profiling)
+       (debug_reset_apply_profile)
      )
@@ -52,8 +52,8 @@ public:
 
 private:
 
-   void on_changed_objects( const std::vector<graphene::db::object_id_type>& ids, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts );
-   void on_removed_objects( const std::vector<graphene::db::object_id_type>& ids, const std::vector<const graphene::db::object*> objs, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts );
+   void on_changed_objects( const std::vector<graphene::db::object_id_type>& ids, const graphene::chain::lazy_impacted_accounts& impacted_accounts );
+   void on_removed_objects( const std::vector<graphene::db::object_id_type>& ids, const std::vector<const graphene::db::object*> objs, const graphene::chain::lazy_impacted_accounts& impacted_accounts );
    void on_applied_block( const graphene::chain::signed_block& b );
 
    boost::program_options::variables_map _options;
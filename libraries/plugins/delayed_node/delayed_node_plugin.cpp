@@ -31,6 +31,9 @@
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
 #include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <deque>
 
 
 namespace graphene { namespace delayed_node {
@@ -42,6 +45,12 @@ struct delayed_node_plugin_impl {
    fc::http::websocket_client client;
    std::shared_ptr<fc::rpc::websocket_api_connection> client_connection;
    fc::api<graphene::app::database_api> database_api;
+   /// only set if the trusted node gives us access to its block_api
+   fc::optional< fc::api<graphene::app::block_api> > block_api;
+   /// decodes fetched blocks, so that the chain thread only has to push them
+   std::shared_ptr<fc::thread> decode_thread = std::make_shared<fc::thread>("delayed_node_decode");
+   uint32_t blocks_per_request = 100;
+   uint32_t requests_in_flight = 4;
    boost::signals2::scoped_connection client_connection_closed;
    graphene::chain::block_id_type last_received_remote_head;
    graphene::chain::block_id_type last_processed_remote_head;
@@ -59,6 +68,10 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
 {
    cli.add_options()
          ("trusted-node", boost::program_options::value<std::string>(), "RPC endpoint of a trusted validating node (required)")
+         ("delayed-node-blocks-per-request", boost::program_options::value<uint32_t>()->default_value(100),
+          "Number of irreversible blocks fetched from the trusted node with one request")
+         ("delayed-node-requests-in-flight", boost::program_options::value<uint32_t>()->default_value(4),
+          "Number of block requests sent to the trusted node before the oldest one is answered")
          ;
    cfg.add(cli);
 }
@@ -67,6 +80,17 @@ void delayed_node_plugin::connect()
 {
    my->client_connection = std::make_shared<fc::rpc::websocket_api_connection>(*my->client.connect(my->remote_endpoint), GRAPHENE_NET_MAX_NESTED_OBJECTS);
    my->database_api = my->client_connection->get_remote_api<graphene::app::database_api>(0);
+   my->block_api.reset();
+   try
+   {
+      auto login = my->client_connection->get_remote_api<graphene::app::login_api>(1);
+      login->login( "", "" );
+      my->block_api = login->block();
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "Trusted node does not provide block_api, fetching blocks one by one: ${e}", ("e", e.to_string()) );
+   }
    my->client_connection_closed = my->client_connection->closed.connect([this] {
       connection_failed();
    });
@@ -77,6 +101,45 @@ void delayed_node_plugin::plugin_initialize(const boost::program_options::variab
    FC_ASSERT(options.count("trusted-node") > 0);
    my = std::unique_ptr<detail::delayed_node_plugin_impl>{ new detail::delayed_node_plugin_impl() };
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   if( options.count("delayed-node-blocks-per-request") )
+      my->blocks_per_request = std::max( 1u, options.at("delayed-node-blocks-per-request").as<uint32_t>() );
+   if( options.count("delayed-node-requests-in-flight") )
+      my->requests_in_flight = std::max( 1u, options.at("delayed-node-requests-in-flight").as<uint32_t>() );
+}
+
+fc::future<std::vector<graphene::chain::signed_block>> delayed_node_plugin::fetch_blocks( uint32_t first, uint32_t last )
+{
+   auto database_api = my->database_api;
+   auto block_api = my->block_api;
+   auto decode_thread = my->decode_thread;
+   return fc::async( [database_api,block_api,decode_thread,first,last]() {
+      std::vector<graphene::chain::signed_block> blocks;
+      if( block_api.valid() )
+      {
+         auto raw_blocks = (*block_api)->get_blocks_raw( first, last );
+         blocks = decode_thread->async( [&raw_blocks]() {
+            std::vector<graphene::chain::signed_block> decoded;
+            decoded.reserve( raw_blocks.size() );
+            for( const auto& raw : raw_blocks )
+            {
+               FC_ASSERT( raw.valid(), "Trusted node claims it has blocks it doesn't actually have." );
+               decoded.push_back( fc::raw::unpack<graphene::chain::signed_block>( *raw ) );
+            }
+            return decoded;
+         }, "decode blocks" ).wait();
+      }
+      else
+      {
+         blocks.reserve( last - first + 1 );
+         for( uint32_t num = first; num <= last; ++num )
+         {
+            fc::optional<graphene::chain::signed_block> block = database_api->get_block( num );
+            FC_ASSERT( block, "Trusted node claims it has blocks it doesn't actually have." );
+            blocks.push_back( std::move(*block) );
+         }
+      }
+      return blocks;
+   }, "delayed_node fetch blocks" );
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -100,13 +163,31 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
-      while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
+      // keep several range requests in flight, so that fetching and decoding overlap with applying blocks
+      std::deque< fc::future<std::vector<graphene::chain::signed_block>> > pending;
+      uint32_t next_block = db.head_block_num() + 1;
+      while( next_block <= remote_dpo.last_irreversible_block_num || !pending.empty() )
       {
-         fc::optional<graphene::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
-         FC_ASSERT(block, "Trusted node claims it has blocks it doesn't actually have.");
-         ilog("Pushing block #${n}", ("n", block->block_num()));
-         db.push_block(*block);
-         synced_blocks++;
+         while( pending.size() < my->requests_in_flight && next_block <= remote_dpo.last_irreversible_block_num )
+         {
+            uint32_t last = std::min( remote_dpo.last_irreversible_block_num, next_block + my->blocks_per_request - 1 );
+            pending.push_back( fetch_blocks( next_block, last ) );
+            next_block = last + 1;
+         }
+         std::vector<graphene::chain::signed_block> blocks = pending.front().wait();
+         pending.pop_front();
+         if( !blocks.empty() )
+            ilog( "Pushing blocks #${f} to #${l}", ("f", blocks.front().block_num())("l", blocks.back().block_num()) );
+         for( const auto& block : blocks )
+         {
+            // the trusted node considers these blocks irreversible, so they are applied like during a replay
+            db.push_block( block, graphene::chain::database::skip_witness_signature |
+                                  graphene::chain::database::skip_transaction_signatures |
+                                  graphene::chain::database::skip_tapos_check |
+                                  graphene::chain::database::skip_witness_schedule_check |
+                                  graphene::chain::database::skip_authority_check );
+            synced_blocks++;
+         }
       }
    }
 }
@@ -24,6 +24,9 @@
 #pragma once
 
 #include <graphene/app/plugin.hpp>
+#include <graphene/chain/protocol/block.hpp>
+
+#include <fc/thread/future.hpp>
 
 namespace graphene { namespace delayed_node {
 namespace detail { struct delayed_node_plugin_impl; }
@@ -46,6 +49,8 @@ protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   /// Fetch and decode the blocks first to last from the trusted node in a separate task
+   fc::future<std::vector<graphene::chain::signed_block>> fetch_blocks( uint32_t first, uint32_t last );
 };
 
 } } //graphene::account_history
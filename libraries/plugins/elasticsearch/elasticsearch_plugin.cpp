@@ -34,6 +34,8 @@
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/transaction_evaluation_state.hpp>
 
+#include <graphene/utilities/elasticsearch.hpp>
+
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/thread.hpp>
 
@@ -54,7 +56,7 @@ class elasticsearch_plugin_impl
    public:
       elasticsearch_plugin_impl(elasticsearch_plugin& _plugin)
          : _self( _plugin )
-      {  curl = curl_easy_init(); }
+      { }
       virtual ~elasticsearch_plugin_impl();
 
       void update_account_histories( const signed_block& b );
@@ -72,12 +74,15 @@ class elasticsearch_plugin_impl
       uint32_t _elasticsearch_bulk_sync = 100;
       bool _elasticsearch_logs = true;
       bool _elasticsearch_visitor = false;
-      CURL *curl; // curl handler
+      uint32_t _elasticsearch_max_queued_batches = 64;
+      std::string _elasticsearch_spool_file;
+      uint32_t _elasticsearch_connect_timeout_ms = 5000;
+      uint32_t _elasticsearch_request_timeout_ms = 30000;
+      std::unique_ptr<graphene::utilities::es_bulk_sender> _sender;
       vector <string> bulk; //  vector of op lines
    private:
       void add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho, const signed_block& b );
       void createBulkLine(account_transaction_history_object ath, operation_history_struct os, int op_type, block_struct bs, visitor_struct vs);
-      void sendBulk(std::string _elasticsearch_node_url, bool _elasticsearch_logs);
 
 };
 
@@ -213,8 +218,8 @@ void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
 
    createBulkLine(ath, os, op_type, bs, vs); // we have everything, creating bulk line
 
-   if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      sendBulk(_elasticsearch_node_url, _elasticsearch_logs);
+   if (_sender && bulk.size() >= limit_documents) { // we are in bulk time, hand the data to the sender thread
+      _sender->send(bulk);
    }
 
    // remove everything except current object from ath
@@ -265,75 +270,6 @@ void elasticsearch_plugin_impl::createBulkLine(account_transaction_history_objec
    bulk.push_back(alltogether);
 }
 
-void elasticsearch_plugin_impl::sendBulk(std::string _elasticsearch_node_url, bool _elasticsearch_logs)
-{
-
-   // curl buffers to read
-   std::string readBuffer;
-   std::string readBuffer_logs;
-
-   std::string bulking = "";
-
-   bulking = boost::algorithm::join(bulk, "\n");
-   bulking = bulking + "\n";
-   bulk.clear();
-
-   //wlog((bulking));
-
-   struct curl_slist *headers = NULL;
-   headers = curl_slist_append(headers, "Content-Type: application/json");
-   std::string url = _elasticsearch_node_url + "_bulk";
-   curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-   curl_easy_setopt(curl, CURLOPT_POST, true);
-   curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-   curl_easy_setopt(curl, CURLOPT_POSTFIELDS, bulking.c_str());
-   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-   curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&readBuffer);
-   curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcrp/0.1");
-   //curl_easy_setopt(curl, CURLOPT_VERBOSE, true);
-   curl_easy_perform(curl);
-
-   long http_code = 0;
-   curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
-   if(http_code == 200) {
-      // all good, do nothing
-   }
-   else if(http_code == 429) {
-      // repeat request?
-   }
-   else {
-      // exit everything ?
-   }
-
-   if(_elasticsearch_logs) {
-      auto logs = readBuffer;
-      // do logs
-      std::string url_logs = _elasticsearch_node_url + "logs/data/";
-      curl_easy_setopt(curl, CURLOPT_URL, url_logs.c_str());
-      curl_easy_setopt(curl, CURLOPT_POST, true);
-      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, logs.c_str());
-      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-      curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *) &readBuffer_logs);
-      curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcrp/0.1");
-      //curl_easy_setopt(curl, CURLOPT_VERBOSE, true);
-      //ilog("log here curl: ${output}", ("output", readBuffer_logs));
-      curl_easy_perform(curl);
-
-      http_code = 0;
-      curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
-      if(http_code == 200) {
-         // all good, do nothing
-      }
-      else if(http_code == 429) {
-         // repeat request?
-      }
-      else {
-         // exit everything ?
-      }
-   }
-}
-
 } // end namespace detail
 
 elasticsearch_plugin::elasticsearch_plugin() :
@@ -365,6 +301,10 @@ void elasticsearch_plugin::plugin_set_program_options(
          ("elasticsearch-bulk-sync", boost::program_options::value<uint32_t>(), "Number of bulk documents to index on a syncronied chain(10)")
          ("elasticsearch-logs", boost::program_options::value<bool>(), "Log bulk events to database")
          ("elasticsearch-visitor", boost::program_options::value<bool>(), "Use visitor to index additional data(slows down the replay)")
+         ("elasticsearch-max-queued-batches", boost::program_options::value<uint32_t>(), "Number of bulks waiting for the sender thread before spooling or blocking(64)")
+         ("elasticsearch-spool-file", boost::program_options::value<std::string>(), "File keeping unsent bulks during Elasticsearch outages and across restarts")
+         ("elasticsearch-connect-timeout", boost::program_options::value<uint32_t>(), "Milliseconds to wait for a connection to Elasticsearch, 0 for the curl default(5000)")
+         ("elasticsearch-request-timeout", boost::program_options::value<uint32_t>(), "Milliseconds a bulk request may take before it is retried, 0 for no limit(30000)")
          ;
    cfg.add(cli);
 }
@@ -390,6 +330,29 @@ void elasticsearch_plugin::plugin_initialize(const boost::program_options::varia
    if (options.count("elasticsearch-visitor")) {
       my->_elasticsearch_visitor = options["elasticsearch-visitor"].as<bool>();
    }
+   if (options.count("elasticsearch-max-queued-batches")) {
+      my->_elasticsearch_max_queued_batches = options["elasticsearch-max-queued-batches"].as<uint32_t>();
+   }
+   if (options.count("elasticsearch-spool-file")) {
+      my->_elasticsearch_spool_file = options["elasticsearch-spool-file"].as<std::string>();
+   }
+   if (options.count("elasticsearch-connect-timeout")) {
+      my->_elasticsearch_connect_timeout_ms = options["elasticsearch-connect-timeout"].as<uint32_t>();
+   }
+   if (options.count("elasticsearch-request-timeout")) {
+      my->_elasticsearch_request_timeout_ms = options["elasticsearch-request-timeout"].as<uint32_t>();
+   }
+
+   graphene::utilities::es_bulk_sender::options sender_options;
+   sender_options.url = my->_elasticsearch_node_url;
+   sender_options.do_logs = my->_elasticsearch_logs;
+   sender_options.logs_index = "logs";
+   sender_options.max_queued_batches = my->_elasticsearch_max_queued_batches;
+   sender_options.spool_file = my->_elasticsearch_spool_file;
+   sender_options.connect_timeout_ms = my->_elasticsearch_connect_timeout_ms;
+   sender_options.request_timeout_ms = my->_elasticsearch_request_timeout_ms;
+   my->_sender.reset( new graphene::utilities::es_bulk_sender( sender_options ) );
+   app().add_metrics_provider( [this]() { return my->_sender->to_prometheus_text( "graphene_elasticsearch_bulk" ); } );
 }
 
 void elasticsearch_plugin::plugin_startup()
@@ -47,12 +47,6 @@ namespace graphene { namespace elasticsearch {
 #define ELASTICSEARCH_SPACE_ID 6
 #endif
 
-static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
-{
-   ((std::string*)userp)->append((char*)contents, size * nmemb);
-   return size * nmemb;
-}
-
 namespace detail
 {
     class elasticsearch_plugin_impl;
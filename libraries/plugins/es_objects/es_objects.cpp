@@ -33,21 +33,42 @@
 
 #include <graphene/utilities/elasticsearch.hpp>
 
+#include <deque>
+
 
 namespace graphene { namespace es_objects {
 
 namespace detail
 {
 
+/**
+ * One exported document, captured when the block that changed the object was applied.
+ */
+struct es_document
+{
+   object_id_type    id;
+   std::string       index;
+   fc::variant_object doc;
+};
+
+/** Documents produced by a block that is not irreversible yet. */
+struct pending_block
+{
+   uint32_t              block_num = 0;
+   vector<es_document>   docs;
+};
+
 class es_objects_plugin_impl
 {
    public:
       es_objects_plugin_impl(es_objects_plugin& _plugin)
          : _self( _plugin )
-      {  curl = curl_easy_init(); }
+      { }
       virtual ~es_objects_plugin_impl();
 
-      void updateDatabase( const vector<object_id_type>& ids , bool isNew);
+      void on_block( const signed_block& b );
+      void mark_dirty( const vector<object_id_type>& ids );
+      void flush_dirty();
 
       es_objects_plugin& _self;
       std::string _es_objects_elasticsearch_url = "http://localhost:9200/";
@@ -60,92 +81,175 @@ class es_objects_plugin_impl
       bool _es_objects_limit_orders = true;
       bool _es_objects_asset_bitasset = true;
       bool _es_objects_logs = true;
-      CURL *curl; // curl handler
+      bool _es_objects_changed_fields_only = false;
+      bool _es_objects_irreversible_only = false;
+      uint32_t _es_objects_max_queued_batches = 64;
+      std::string _es_objects_spool_file;
+      uint32_t _es_objects_connect_timeout_ms = 5000;
+      uint32_t _es_objects_request_timeout_ms = 30000;
+      std::unique_ptr<graphene::utilities::es_bulk_sender> _sender;
       vector <std::string> bulk;
       vector<std::string> prepare;
-      map<object_id_type, bitasset_struct> bitassets;
-      map<object_id_type, account_struct> accounts;
-      map<object_id_type, proposal_struct> proposals;
-      map<object_id_type, asset_struct> assets;
-      map<object_id_type, balance_struct> balances;
-      map<object_id_type, limit_order_struct> limit_orders;
-      //uint32_t bitasset_seq;
+      /// objects changed by the block being applied, exported once the block's notifications are done
+      flat_set<object_id_type> _dirty;
+      fc::time_point_sec _block_time;
+      uint32_t _block_number = 0;
+      /// blocks waiting for irreversibility in irreversible-only mode, oldest first
+      std::deque<pending_block> _pending;
+      /// last exported state of each object, used to skip unchanged objects and to compute changed fields
+      map<object_id_type, fc::variant_object> _exported;
    private:
-      void PrepareProposal(const proposal_object* proposal_object, const fc::time_point_sec block_time, uint32_t block_number);
-      void PrepareAccount(const account_object* account_object, const fc::time_point_sec block_time, uint32_t block_number);
-      void PrepareAsset(const asset_object* asset_object, const fc::time_point_sec block_time, uint32_t block_number);
-      void PrepareBalance(const balance_object* balance_object, const fc::time_point_sec block_time, uint32_t block_number);
-      void PrepareLimit(const limit_order_object* limit_object, const fc::time_point_sec block_time, uint32_t block_number);
-      void PrepareBitAsset(const asset_bitasset_data_object* bitasset_object, const fc::time_point_sec block_time, uint32_t block_number);
+      bool is_exported_type( const object_id_type& id )const;
+      void emit( const es_document& d );
+      void send_if_full();
+
+      void PrepareProposal(const proposal_object* proposal_object, vector<es_document>& out);
+      void PrepareAccount(const account_object* account_object, vector<es_document>& out);
+      void PrepareAsset(const asset_object* asset_object, vector<es_document>& out);
+      void PrepareBalance(const balance_object* balance_object, vector<es_document>& out);
+      void PrepareLimit(const limit_order_object* limit_object, vector<es_document>& out);
+      void PrepareBitAsset(const asset_bitasset_data_object* bitasset_object, vector<es_document>& out);
+
+      template<typename T>
+      void add_document( const object_id_type& id, const char* index, const T& s, vector<es_document>& out )
+      {
+         out.push_back( es_document{ id, index, fc::variant( s, GRAPHENE_MAX_NESTED_OBJECTS ).get_object() } );
+      }
 };
 
-void es_objects_plugin_impl::updateDatabase( const vector<object_id_type>& ids , bool isNew)
+bool es_objects_plugin_impl::is_exported_type( const object_id_type& id )const
 {
+   return ( id.is<proposal_object>() && _es_objects_proposals )
+       || ( id.is<account_object>() && _es_objects_accounts )
+       || ( id.is<asset_object>() && _es_objects_assets )
+       || ( id.is<balance_object>() && _es_objects_balances )
+       || ( id.is<limit_order_object>() && _es_objects_limit_orders )
+       || ( id.is<asset_bitasset_data_object>() && _es_objects_asset_bitasset );
+}
 
-   graphene::chain::database &db = _self.database();
+void es_objects_plugin_impl::on_block( const signed_block& b )
+{
+   // objects left over from a block whose changed_objects signal did not fire
+   flush_dirty();
 
-   const fc::time_point_sec block_time = db.head_block_time();
-   const uint32_t block_number = db.head_block_num();
+   _block_time = b.timestamp;
+   _block_number = b.block_num();
 
-   // check if we are in replay or in sync and change number of bulk documents accordingly
-   uint32_t limit_documents = 0;
-   if((fc::time_point::now() - block_time) < fc::seconds(30))
-      limit_documents = _es_objects_bulk_sync;
-   else
-      limit_documents = _es_objects_bulk_replay;
+   // a block at or below a pending one means the pending ones were popped by a fork switch
+   while( !_pending.empty() && _pending.back().block_num >= _block_number )
+      _pending.pop_back();
+}
+
+void es_objects_plugin_impl::mark_dirty( const vector<object_id_type>& ids )
+{
+   for( const auto& id : ids )
+      if( is_exported_type( id ) )
+         _dirty.insert( id );
+}
+
+void es_objects_plugin_impl::flush_dirty()
+{
+   if( _dirty.empty() )
+      return;
+
+   graphene::chain::database &db = _self.database();
 
-   if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      if(!graphene::utilities::SendBulk(curl, bulk, _es_objects_elasticsearch_url, _es_objects_logs, "objects_logs"))
-         elog("Error sending data to database");
-      bulk.clear();
+   vector<es_document> docs;
+   docs.reserve( _dirty.size() );
+   for( const auto& value : _dirty ) {
+      const object* obj = db.find_object( value );
+      if( obj == nullptr )
+         continue;
+      if( value.is<proposal_object>() )
+         PrepareProposal( static_cast<const proposal_object*>(obj), docs );
+      else if( value.is<account_object>() )
+         PrepareAccount( static_cast<const account_object*>(obj), docs );
+      else if( value.is<asset_object>() )
+         PrepareAsset( static_cast<const asset_object*>(obj), docs );
+      else if( value.is<balance_object>() )
+         PrepareBalance( static_cast<const balance_object*>(obj), docs );
+      else if( value.is<limit_order_object>() )
+         PrepareLimit( static_cast<const limit_order_object*>(obj), docs );
+      else if( value.is<asset_bitasset_data_object>() )
+         PrepareBitAsset( static_cast<const asset_bitasset_data_object*>(obj), docs );
    }
+   _dirty.clear();
 
-   for(auto const& value: ids) {
-      if(value.is<proposal_object>() && _es_objects_proposals) {
-         auto obj = db.find_object(value);
-         auto p = static_cast<const proposal_object*>(obj);
-         if(p != nullptr)
-            PrepareProposal(p, block_time, block_number);
-      }
-      else if(value.is<account_object>() && _es_objects_accounts) {
-         auto obj = db.find_object(value);
-         auto a = static_cast<const account_object*>(obj);
-         if(a != nullptr)
-            PrepareAccount(a, block_time, block_number);
-      }
-      else if(value.is<asset_object>() && _es_objects_assets) {
-         auto obj = db.find_object(value);
-         auto a = static_cast<const asset_object*>(obj);
-         if(a != nullptr)
-            PrepareAsset(a, block_time, block_number);
+   if( !_es_objects_irreversible_only ) {
+      for( const auto& d : docs )
+         emit( d );
+   }
+   else {
+      if( !docs.empty() ) {
+         if( !_pending.empty() && _pending.back().block_num == _block_number )
+            std::move( docs.begin(), docs.end(), std::back_inserter( _pending.back().docs ) );
+         else {
+            _pending.emplace_back();
+            _pending.back().block_num = _block_number;
+            _pending.back().docs = std::move( docs );
+         }
       }
-      else if(value.is<balance_object>() && _es_objects_balances) {
-         auto obj = db.find_object(value);
-         auto b = static_cast<const balance_object*>(obj);
-         if(b != nullptr)
-            PrepareBalance(b, block_time, block_number);
+      const uint32_t lib = db.get_dynamic_global_properties().last_irreversible_block_num;
+      while( !_pending.empty() && _pending.front().block_num <= lib ) {
+         for( const auto& d : _pending.front().docs )
+            emit( d );
+         _pending.pop_front();
       }
-      else if(value.is<limit_order_object>() && _es_objects_limit_orders) {
-         auto obj = db.find_object(value);
-         auto l = static_cast<const limit_order_object*>(obj);
-         if(l != nullptr)
-            PrepareLimit(l, block_time, block_number);
+   }
+
+   send_if_full();
+}
+
+void es_objects_plugin_impl::emit( const es_document& d )
+{
+   auto it = _exported.find( d.id );
+   fc::mutable_variant_object out;
+   bool changed = ( it == _exported.end() );
+   for( const auto& field : d.doc ) {
+      const std::string& key = field.key();
+      if( key == "object_id" || key == "block_time" || key == "block_number" ) {
+         out( key, field.value() );
+         continue;
       }
-      else if(value.is<asset_bitasset_data_object>() && _es_objects_asset_bitasset) {
-         auto obj = db.find_object(value);
-         auto ba = static_cast<const asset_bitasset_data_object*>(obj);
-         if(ba != nullptr)
-            PrepareBitAsset(ba, block_time, block_number);
+      bool field_changed = true;
+      if( it != _exported.end() ) {
+         auto prev = it->second.find( key );
+         field_changed = ( prev == it->second.end()
+                           || fc::json::to_string( prev->value() ) != fc::json::to_string( field.value() ) );
       }
+      changed = changed || field_changed;
+      if( field_changed || !_es_objects_changed_fields_only )
+         out( key, field.value() );
    }
+   if( !changed )
+      return;
+   _exported[d.id] = d.doc;
+
+   prepare = graphene::utilities::createBulk( d.index, fc::json::to_string( out ), "", 1 );
+   bulk.insert( bulk.end(), prepare.begin(), prepare.end() );
+   prepare.clear();
 }
 
-void es_objects_plugin_impl::PrepareProposal(const proposal_object* proposal_object, const fc::time_point_sec block_time, uint32_t block_number)
+void es_objects_plugin_impl::send_if_full()
+{
+   // check if we are in replay or in sync and change number of bulk documents accordingly
+   uint32_t limit_documents = 0;
+   if((fc::time_point::now() - _block_time) < fc::seconds(30))
+      limit_documents = _es_objects_bulk_sync;
+   else
+      limit_documents = _es_objects_bulk_replay;
+
+   if (_sender && bulk.size() >= limit_documents) { // we are in bulk time, hand the data to the sender thread
+      _sender->send(bulk);
+   }
+}
+
+void es_objects_plugin_impl::PrepareProposal(const proposal_object* proposal_object, vector<es_document>& out)
 {
    proposal_struct prop;
    prop.object_id = proposal_object->id;
-   prop.block_time = block_time;
-   prop.block_number = block_number;
+   prop.block_time = _block_time;
+   prop.block_number = _block_number;
    prop.expiration_time = proposal_object->expiration_time;
    prop.review_period_time = proposal_object->review_period_time;
    prop.proposed_transaction = fc::json::to_string(proposal_object->proposed_transaction);
@@ -155,26 +259,15 @@ void es_objects_plugin_impl::PrepareProposal(const proposal_object* proposal_obj
    prop.available_key_approvals = fc::json::to_string(proposal_object->available_key_approvals);
    prop.proposer = proposal_object->proposer;
 
-   auto it = proposals.find(proposal_object->id);
-   if(it == proposals.end())
-      proposals[proposal_object->id] = prop;
-   else {
-      if(it->second == prop) return;
-      else proposals[proposal_object->id] = prop;
-   }
-
-   std::string data = fc::json::to_string(prop);
-   prepare = graphene::utilities::createBulk("bitshares-proposal", data, "", 1);
-   bulk.insert(bulk.end(), prepare.begin(), prepare.end());
-   prepare.clear();
+   add_document( proposal_object->id, "bitshares-proposal", prop, out );
 }
 
-void es_objects_plugin_impl::PrepareAccount(const account_object* account_object, const fc::time_point_sec block_time, uint32_t block_number)
+void es_objects_plugin_impl::PrepareAccount(const account_object* account_object, vector<es_document>& out)
 {
    account_struct acct;
    acct.object_id = account_object->id;
-   acct.block_time = block_time;
-   acct.block_number = block_number;
+   acct.block_time = _block_time;
+   acct.block_number = _block_number;
    acct.membership_expiration_date = account_object->membership_expiration_date;
    acct.registrar = account_object->registrar;
    acct.referrer = account_object->referrer;
@@ -191,118 +284,64 @@ void es_objects_plugin_impl::PrepareAccount(const account_object* account_object
    acct.active_address_auths = fc::json::to_string(account_object->active.address_auths);
    acct.voting_account = account_object->options.voting_account;
 
-   auto it = accounts.find(account_object->id);
-   if(it == accounts.end())
-      accounts[account_object->id] = acct;
-   else {
-      if(it->second == acct) return;
-      else accounts[account_object->id] = acct;
-   }
-
-   std::string data = fc::json::to_string(acct);
-   prepare = graphene::utilities::createBulk("bitshares-account", data, "", 1);
-   bulk.insert(bulk.end(), prepare.begin(), prepare.end());
-   prepare.clear();
+   add_document( account_object->id, "bitshares-account", acct, out );
 }
 
-void es_objects_plugin_impl::PrepareAsset(const asset_object* asset_object, const fc::time_point_sec block_time, uint32_t block_number)
+void es_objects_plugin_impl::PrepareAsset(const asset_object* asset_object, vector<es_document>& out)
 {
    asset_struct _asset;
    _asset.object_id = asset_object->id;
-   _asset.block_time = block_time;
-   _asset.block_number = block_number;
+   _asset.block_time = _block_time;
+   _asset.block_number = _block_number;
    _asset.symbol = asset_object->symbol;
    _asset.issuer = asset_object->issuer;
    _asset.is_market_issued = asset_object->is_market_issued();
    _asset.dynamic_asset_data_id = asset_object->dynamic_asset_data_id;
    _asset.bitasset_data_id = asset_object->bitasset_data_id;
 
-   auto it = assets.find(asset_object->id);
-   if(it == assets.end())
-      assets[asset_object->id] = _asset;
-   else {
-      if(it->second == _asset) return;
-      else assets[asset_object->id] = _asset;
-   }
-
-   std::string data = fc::json::to_string(_asset);
-   prepare = graphene::utilities::createBulk("bitshares-asset", data, "", 1);
-   bulk.insert(bulk.end(), prepare.begin(), prepare.end());
-   prepare.clear();
+   add_document( asset_object->id, "bitshares-asset", _asset, out );
 }
 
-void es_objects_plugin_impl::PrepareBalance(const balance_object* balance_object, const fc::time_point_sec block_time, uint32_t block_number)
+void es_objects_plugin_impl::PrepareBalance(const balance_object* balance_object, vector<es_document>& out)
 {
    balance_struct balance;
    balance.object_id = balance_object->id;
-   balance.block_time = block_time;
-   balance.block_number = block_number;balance.owner = balance_object->owner;
+   balance.block_time = _block_time;
+   balance.block_number = _block_number;
+   balance.owner = balance_object->owner;
    balance.asset_id = balance_object->balance.asset_id;
    balance.amount = balance_object->balance.amount;
 
-   auto it = balances.find(balance_object->id);
-   if(it == balances.end())
-      balances[balance_object->id] = balance;
-   else {
-      if(it->second == balance) return;
-      else balances[balance_object->id] = balance;
-   }
-
-   std::string data = fc::json::to_string(balance);
-   prepare = graphene::utilities::createBulk("bitshares-balance", data, "", 1);
-   bulk.insert(bulk.end(), prepare.begin(), prepare.end());
-   prepare.clear();
+   add_document( balance_object->id, "bitshares-balance", balance, out );
 }
 
-void es_objects_plugin_impl::PrepareLimit(const limit_order_object* limit_object, const fc::time_point_sec block_time, uint32_t block_number)
+void es_objects_plugin_impl::PrepareLimit(const limit_order_object* limit_object, vector<es_document>& out)
 {
    limit_order_struct limit;
    limit.object_id = limit_object->id;
-   limit.block_time = block_time;
-   limit.block_number = block_number;
+   limit.block_time = _block_time;
+   limit.block_number = _block_number;
    limit.expiration = limit_object->expiration;
    limit.seller = limit_object->seller;
    limit.for_sale = limit_object->for_sale;
    limit.sell_price = limit_object->sell_price;
    limit.deferred_fee = limit_object->deferred_fee;
 
-   auto it = limit_orders.find(limit_object->id);
-   if(it == limit_orders.end())
-      limit_orders[limit_object->id] = limit;
-   else {
-      if(it->second == limit) return;
-      else limit_orders[limit_object->id] = limit;
-   }
-
-   std::string data = fc::json::to_string(limit);
-   prepare = graphene::utilities::createBulk("bitshares-limitorder", data, "", 1);
-   bulk.insert(bulk.end(), prepare.begin(), prepare.end());
-   prepare.clear();
+   add_document( limit_object->id, "bitshares-limitorder", limit, out );
 }
 
-void es_objects_plugin_impl::PrepareBitAsset(const asset_bitasset_data_object* bitasset_object, const fc::time_point_sec block_time, uint32_t block_number)
+void es_objects_plugin_impl::PrepareBitAsset(const asset_bitasset_data_object* bitasset_object, vector<es_document>& out)
 {
    if(!bitasset_object->is_prediction_market) {
 
       bitasset_struct bitasset;
       bitasset.object_id = bitasset_object->id;
-      bitasset.block_time = block_time;
-      bitasset.block_number = block_number;
+      bitasset.block_time = _block_time;
+      bitasset.block_number = _block_number;
       bitasset.current_feed = fc::json::to_string(bitasset_object->current_feed);
       bitasset.current_feed_publication_time = bitasset_object->current_feed_publication_time;
 
-      auto it = bitassets.find(bitasset_object->id);
-      if(it == bitassets.end())
-         bitassets[bitasset_object->id] = bitasset;
-      else {
-         if(it->second == bitasset) return;
-         else bitassets[bitasset_object->id] = bitasset;
-      }
-
-      std::string data = fc::json::to_string(bitasset);
-      prepare = graphene::utilities::createBulk("bitshares-bitasset", data, "", 1);
-      bulk.insert(bulk.end(), prepare.begin(), prepare.end());
-      prepare.clear();
+      add_document( bitasset_object->id, "bitshares-bitasset", bitasset, out );
    }
 }
 
@@ -342,12 +381,18 @@ void es_objects_plugin::plugin_set_program_options(
          ("es-objects-logs", boost::program_options::value<bool>(), "Log bulk events to database")
          ("es-objects-bulk-replay", boost::program_options::value<uint32_t>(), "Number of bulk documents to index on replay(5000)")
          ("es-objects-bulk-sync", boost::program_options::value<uint32_t>(), "Number of bulk documents to index on a syncronied chain(10)")
+         ("es-objects-max-queued-batches", boost::program_options::value<uint32_t>(), "Number of bulks waiting for the sender thread before spooling or blocking(64)")
+         ("es-objects-spool-file", boost::program_options::value<std::string>(), "File keeping unsent bulks during Elasticsearch outages and across restarts")
+         ("es-objects-connect-timeout", boost::program_options::value<uint32_t>(), "Milliseconds to wait for a connection to Elasticsearch, 0 for the curl default(5000)")
+         ("es-objects-request-timeout", boost::program_options::value<uint32_t>(), "Milliseconds a bulk request may take before it is retried, 0 for no limit(30000)")
          ("es-objects-proposals", boost::program_options::value<bool>(), "Store proposal objects")
          ("es-objects-accounts", boost::program_options::value<bool>(), "Store account objects")
          ("es-objects-assets", boost::program_options::value<bool>(), "Store asset objects")
          ("es-objects-balances", boost::program_options::value<bool>(), "Store balances objects")
          ("es-objects-limit-orders", boost::program_options::value<bool>(), "Store limit order objects")
          ("es-objects-asset-bitasset", boost::program_options::value<bool>(), "Store feed data")
+         ("es-objects-changed-fields-only", boost::program_options::value<bool>(), "Only store the fields that changed since the previous document of an object(false)")
+         ("es-objects-irreversible-only", boost::program_options::value<bool>(), "Only store object changes made by irreversible blocks(false)")
 
          ;
    cfg.add(cli);
@@ -355,8 +400,13 @@ void es_objects_plugin::plugin_set_program_options(
 
 void es_objects_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
-   database().new_objects.connect([&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ){ my->updateDatabase(ids, 1); });
-   database().changed_objects.connect([&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ){ my->updateDatabase(ids, 0); });
+   database().applied_block.connect([&]( const signed_block& b ){ my->on_block(b); });
+   database().new_objects.connect([&]( const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts ){ my->mark_dirty(ids); });
+   // changed_objects is the last object notification of a block, so the block's changes are complete here
+   database().changed_objects.connect([&]( const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted_accounts ){
+      my->mark_dirty(ids);
+      my->flush_dirty();
+   });
 
    if (options.count("es-objects-elasticsearch-url")) {
       my->_es_objects_elasticsearch_url = options["es-objects-elasticsearch-url"].as<std::string>();
@@ -388,6 +438,35 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
    if (options.count("es-objects-asset-bitasset")) {
       my->_es_objects_asset_bitasset = options["es-objects-asset-bitasset"].as<bool>();
    }
+   if (options.count("es-objects-changed-fields-only")) {
+      my->_es_objects_changed_fields_only = options["es-objects-changed-fields-only"].as<bool>();
+   }
+   if (options.count("es-objects-irreversible-only")) {
+      my->_es_objects_irreversible_only = options["es-objects-irreversible-only"].as<bool>();
+   }
+   if (options.count("es-objects-max-queued-batches")) {
+      my->_es_objects_max_queued_batches = options["es-objects-max-queued-batches"].as<uint32_t>();
+   }
+   if (options.count("es-objects-spool-file")) {
+      my->_es_objects_spool_file = options["es-objects-spool-file"].as<std::string>();
+   }
+   if (options.count("es-objects-connect-timeout")) {
+      my->_es_objects_connect_timeout_ms = options["es-objects-connect-timeout"].as<uint32_t>();
+   }
+   if (options.count("es-objects-request-timeout")) {
+      my->_es_objects_request_timeout_ms = options["es-objects-request-timeout"].as<uint32_t>();
+   }
+
+   graphene::utilities::es_bulk_sender::options sender_options;
+   sender_options.url = my->_es_objects_elasticsearch_url;
+   sender_options.do_logs = my->_es_objects_logs;
+   sender_options.logs_index = "objects_logs";
+   sender_options.max_queued_batches = my->_es_objects_max_queued_batches;
+   sender_options.spool_file = my->_es_objects_spool_file;
+   sender_options.connect_timeout_ms = my->_es_objects_connect_timeout_ms;
+   sender_options.request_timeout_ms = my->_es_objects_request_timeout_ms;
+   my->_sender.reset( new graphene::utilities::es_bulk_sender( sender_options ) );
+   app().add_metrics_provider( [this]() { return my->_sender->to_prometheus_text( "graphene_es_objects_bulk" ); } );
 }
 
 void es_objects_plugin::plugin_startup()
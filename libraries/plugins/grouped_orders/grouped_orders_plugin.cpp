@@ -26,6 +26,8 @@
 
 #include <graphene/chain/market_object.hpp>
 
+#include <cmath>
+
 namespace graphene { namespace grouped_orders {
 
 namespace detail
@@ -49,11 +51,19 @@ class grouped_orders_plugin_impl
 
 /**
  *  @brief This secondary index is used to track changes on limit order objects.
+ *
+ *  Each group size g splits the price range of every market into fixed buckets, bucket k holding the prices in
+ *  [ (1+g/10000)^k, (1+g/10000)^(k+1) ). The bucket of an order only depends on its own price, so adding, removing
+ *  or partially filling an order touches exactly one entry per group size.
  */
 class limit_order_group_index : public secondary_index
 {
    public:
-      limit_order_group_index( const flat_set<uint16_t>& groups ) : _tracked_groups( groups ) {};
+      limit_order_group_index( const flat_set<uint16_t>& groups ) : _tracked_groups( groups )
+      {
+         for( uint16_t group : _tracked_groups )
+            _log_ratios.push_back( std::log1p( double( group ) / GRAPHENE_100_PERCENT ) );
+      }
 
       virtual void object_inserted( const object& obj ) override;
       virtual void object_removed( const object& obj ) override;
@@ -67,173 +77,122 @@ class limit_order_group_index : public secondary_index
       { return _og_data; }
 
    private:
-      void remove_order( const limit_order_object& obj, bool remove_empty = true );
+      void add_order( const price& sell_price, share_type for_sale );
+      void remove_order( const price& sell_price, share_type for_sale );
 
       /** tracked groups */
       flat_set<uint16_t> _tracked_groups;
+      /** log( 1 + group / 10000 ) for each tracked group, in the same order */
+      vector<double>     _log_ratios;
 
       /** maps the group key to group data */
       map< limit_order_group_key, limit_order_group_data > _og_data;
+
+      /** the order as it was before the modification in progress */
+      price              _modified_price;
+      share_type         _modified_for_sale;
 };
 
-void limit_order_group_index::object_inserted( const object& objct )
-{ try {
-   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
+/// @return the price closest to @p value which fits into share_type amounts
+static price price_from_double( double value, asset_id_type base, asset_id_type quote )
+{
+   const double max_amount = GRAPHENE_MAX_SHARE_SUPPLY;
+   double base_amount = max_amount;
+   double quote_amount = max_amount;
+   if( value >= 1 )
+      quote_amount = std::max( 1.0, std::floor( max_amount / value ) );
+   base_amount = std::max( 1.0, std::min( max_amount, std::round( value * quote_amount ) ) );
+   return asset( int64_t( base_amount ), base ) / asset( int64_t( quote_amount ), quote );
+}
 
-   auto& idx = _og_data;
+/// @return the key of the bucket containing @p p
+static limit_order_group_key group_key_of( uint16_t group, double log_ratio, const price& p )
+{
+   const double log_price = std::log( double( p.base.amount.value ) ) - std::log( double( p.quote.amount.value ) );
+   const double bucket = std::floor( log_price / log_ratio );
+   return limit_order_group_key( group, price_from_double( std::exp( bucket * log_ratio ),
+                                                           p.base.asset_id, p.quote.asset_id ) );
+}
 
-   for( uint16_t group : get_tracked_groups() )
+void limit_order_group_index::add_order( const price& sell_price, share_type for_sale )
+{
+   size_t i = 0;
+   for( uint16_t group : _tracked_groups )
    {
-      auto create_ogo = [&]() {
-         idx[ limit_order_group_key( group, o.sell_price ) ] = limit_order_group_data( o.sell_price, o.for_sale );
-      };
-      // if idx is empty, insert this order
-      // Note: not capped
-      if( idx.empty() )
-      {
-         create_ogo();
-         continue;
-      }
-
-      // cap the price
-      price capped_price = o.sell_price;
-      price max = o.sell_price.max();
-      price min = o.sell_price.min();
-      bool capped_max = false;
-      bool capped_min = false;
-      if( o.sell_price > max )
+      const double log_ratio = _log_ratios[i++];
+      auto key = group_key_of( group, log_ratio, sell_price );
+      auto itr = _og_data.find( key );
+      if( itr == _og_data.end() )
       {
-         capped_price = max;
-         capped_max = true;
-      }
-      else if( o.sell_price < min )
-      {
-         capped_price = min;
-         capped_min = true;
-      }
-      // if idx is not empty, find the group that is next to this order
-      auto itr = idx.lower_bound( limit_order_group_key( group, capped_price ) );
-      bool check_previous = false;
-      if( itr == idx.end() || itr->first.group != group
-            || itr->first.min_price.base.asset_id != o.sell_price.base.asset_id
-            || itr->first.min_price.quote.asset_id != o.sell_price.quote.asset_id )
-         // not same market or group type
-         check_previous = true;
-      else // same market and group type
-      {
-         bool update_max = false;
-         if( capped_price > itr->second.max_price ) // implies itr->min_price <= itr->max_price < max
-         {
-            update_max = true;
-            price max_price = itr->first.min_price * ratio_type( GRAPHENE_100_PERCENT + group, GRAPHENE_100_PERCENT );
-            // max_price should have been capped here
-            if( capped_price > max_price ) // new order is out of range
-               check_previous = true;
-         }
-         if( !check_previous ) // new order is within the range
-         {
-            if( capped_min && o.sell_price < itr->first.min_price )
-            {  // need to update itr->min_price here, if itr is below min, and new order is even lower
-               // TODO improve performance
-               limit_order_group_data data( itr->second.max_price, o.for_sale + itr->second.total_for_sale );
-               idx.erase( itr );
-               idx[ limit_order_group_key( group, o.sell_price ) ] = data;
-            }
-            else
-            {
-               if( update_max || ( capped_max && o.sell_price > itr->second.max_price ) )
-                  itr->second.max_price = o.sell_price; // store real price here, not capped
-               itr->second.total_for_sale += o.for_sale;
-            }
-         }
+         const double upper = std::exp( std::log( double( key.min_price.base.amount.value ) )
+                                        - std::log( double( key.min_price.quote.amount.value ) ) + log_ratio );
+         const price max_price = price_from_double( upper, sell_price.base.asset_id, sell_price.quote.asset_id );
+         itr = _og_data.emplace( std::move(key), limit_order_group_data( max_price, 0 ) ).first;
       }
+      itr->second.total_for_sale += for_sale;
+      ++itr->second.order_count;
+   }
+}
 
-      if( check_previous )
+void limit_order_group_index::remove_order( const price& sell_price, share_type for_sale )
+{
+   size_t i = 0;
+   for( uint16_t group : _tracked_groups )
+   {
+      auto itr = _og_data.find( group_key_of( group, _log_ratios[i++], sell_price ) );
+      if( itr == _og_data.end() ) // should not happen
+         continue;
+      if( itr->second.order_count <= 1 )
+         _og_data.erase( itr );
+      else
       {
-         if( itr == idx.begin() ) // no previous
-            create_ogo();
-         else
-         {
-            --itr; // should be valid
-            if( itr->first.group != group || itr->first.min_price.base.asset_id != o.sell_price.base.asset_id
-                                          || itr->first.min_price.quote.asset_id != o.sell_price.quote.asset_id )
-               // not same market or group type
-               create_ogo();
-            else // same market and group type
-            {
-               // due to lower_bound, always true: capped_price < itr->first.min_price, so no need to check again,
-               // if new order is in range of itr group, always need to update itr->first.min_price, unless
-               //   o.sell_price is higher than max
-               price min_price = itr->second.max_price / ratio_type( GRAPHENE_100_PERCENT + group, GRAPHENE_100_PERCENT );
-               // min_price should have been capped here
-               if( capped_price < min_price ) // new order is out of range
-                  create_ogo();
-               else if( capped_max && o.sell_price >= itr->first.min_price )
-               {  // itr is above max, and price of new order is even higher
-                  if( o.sell_price > itr->second.max_price )
-                     itr->second.max_price = o.sell_price;
-                  itr->second.total_for_sale += o.for_sale;
-               }
-               else
-               {  // new order is within the range
-                  // TODO improve performance
-                  limit_order_group_data data( itr->second.max_price, o.for_sale + itr->second.total_for_sale );
-                  idx.erase( itr );
-                  idx[ limit_order_group_key( group, o.sell_price ) ] = data;
-               }
-            }
-         }
+         itr->second.total_for_sale -= for_sale;
+         --itr->second.order_count;
       }
    }
+}
+
+void limit_order_group_index::object_inserted( const object& objct )
+{ try {
+   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
+   add_order( o.sell_price, o.for_sale );
 } FC_CAPTURE_AND_RETHROW( (objct) ); }
 
 void limit_order_group_index::object_removed( const object& objct )
 { try {
    const limit_order_object& o = static_cast<const limit_order_object&>( objct );
-   remove_order( o );
+   remove_order( o.sell_price, o.for_sale );
 } FC_CAPTURE_AND_RETHROW( (objct) ); }
 
 void limit_order_group_index::about_to_modify( const object& objct )
 { try {
    const limit_order_object& o = static_cast<const limit_order_object&>( objct );
-   remove_order( o, false );
+   _modified_price = o.sell_price;
+   _modified_for_sale = o.for_sale;
 } FC_CAPTURE_AND_RETHROW( (objct) ); }
 
 void limit_order_group_index::object_modified( const object& objct )
 { try {
-   object_inserted( objct );
-} FC_CAPTURE_AND_RETHROW( (objct) ); }
-
-void limit_order_group_index::remove_order( const limit_order_object& o, bool remove_empty )
-{
-   auto& idx = _og_data;
-
-   for( uint16_t group : get_tracked_groups() )
-   {
-      // find the group that should contain this order
-      auto itr = idx.lower_bound( limit_order_group_key( group, o.sell_price ) );
-      if( itr == idx.end() || itr->first.group != group
-            || itr->first.min_price.base.asset_id != o.sell_price.base.asset_id
-            || itr->first.min_price.quote.asset_id != o.sell_price.quote.asset_id
-            || itr->second.max_price < o.sell_price )
-      {
-         // can not find corresponding group, should not happen
-         wlog( "can not find the order group containing order for removing (price dismatch): ${o}", ("o",o) );
-         continue;
-      }
-      else // found
+   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
+   if( o.sell_price.base == _modified_price.base && o.sell_price.quote == _modified_price.quote )
+   {  // partial fills only change the amount, the order stays in its buckets
+      const share_type delta = o.for_sale - _modified_for_sale;
+      if( delta == 0 )
+         return;
+      size_t i = 0;
+      for( uint16_t group : _tracked_groups )
       {
-         if( itr->second.total_for_sale < o.for_sale )
-            // should not happen
-            wlog( "can not find the order group containing order for removing (amount dismatch): ${o}", ("o",o) );
-         else if( !remove_empty || itr->second.total_for_sale > o.for_sale )
-            itr->second.total_for_sale -= o.for_sale;
-         else
-            // it's the only order in the group and need to be removed
-            idx.erase( itr );
+         auto itr = _og_data.find( group_key_of( group, _log_ratios[i++], o.sell_price ) );
+         if( itr != _og_data.end() ) // should always be true
+            itr->second.total_for_sale += delta;
       }
    }
-}
+   else
+   {
+      remove_order( _modified_price, _modified_for_sale );
+      add_order( o.sell_price, o.for_sale );
+   }
+} FC_CAPTURE_AND_RETHROW( (objct) ); }
 
 grouped_orders_plugin_impl::~grouped_orders_plugin_impl()
 {}
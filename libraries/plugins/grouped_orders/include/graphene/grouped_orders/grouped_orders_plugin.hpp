@@ -35,7 +35,7 @@ struct limit_order_group_key
    limit_order_group_key() {}
 
    uint16_t      group = 0; ///< percentage, 1 means 1 / 10000
-   price         min_price;
+   price         min_price; ///< lower bound of the price bucket, a power of ( 1 + group / 10000 )
 
    friend bool operator < ( const limit_order_group_key& a, const limit_order_group_key& b )
    {
@@ -53,8 +53,9 @@ struct limit_order_group_data
    limit_order_group_data( const price& p, const share_type s ) : max_price(p), total_for_sale(s) {}
    limit_order_group_data() {}
 
-   price         max_price;
+   price         max_price; ///< upper bound of the price bucket, exclusive
    share_type    total_for_sale; ///< asset id is min_price.base.asset_id
+   uint32_t      order_count = 0;
 };
 
 namespace detail
@@ -65,6 +66,8 @@ namespace detail
 /**
  *  The grouped orders plugin can be configured to track any number of price diff percentages via its configuration.
  *  Every time when there is a change on an order in object database, it will update internal state to reflect the change.
+ *  For each percentage, the prices of a market are divided into fixed buckets whose bounds grow by that percentage,
+ *  and the plugin keeps the total amount for sale in each non-empty bucket.
  */
 class grouped_orders_plugin : public graphene::app::plugin
 {
@@ -92,4 +95,4 @@ class grouped_orders_plugin : public graphene::app::plugin
 } } //graphene::grouped_orders
 
 FC_REFLECT( graphene::grouped_orders::limit_order_group_key, (group)(min_price) )
-FC_REFLECT( graphene::grouped_orders::limit_order_group_data, (max_price)(total_for_sale) )
+FC_REFLECT( graphene::grouped_orders::limit_order_group_data, (max_price)(total_for_sale)(order_count) )
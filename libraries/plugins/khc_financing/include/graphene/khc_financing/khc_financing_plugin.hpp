@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/plugin.hpp>
+#include <graphene/chain/database.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace graphene { namespace khc_financing {
+using namespace chain;
+
+//
+// Plugins should #define their SPACE_ID's so plugins with
+// conflicting SPACE_ID assignments can be compiled into the
+// same binary (by simply re-assigning some of the conflicting #defined
+// SPACE_ID's in a build script).
+//
+// Assignment of SPACE_ID's cannot be done at run-time because
+// various template automagic depends on them being known at compile
+// time.
+//
+#ifndef KHC_FINANCING_SPACE_ID
+#define KHC_FINANCING_SPACE_ID 7
+#endif
+
+enum khc_financing_object_type
+{
+   financing_project_object_type = 0,
+   financing_bucket_object_type = 1,
+   financing_investor_object_type = 2
+};
+
+/**
+ *  Running totals of one public offering project, as seen in the operations applied since genesis.
+ */
+struct financing_project_object : public abstract_object<financing_project_object>
+{
+   static const uint8_t space_id = KHC_FINANCING_SPACE_ID;
+   static const uint8_t type_id  = financing_project_object_type;
+
+   /// KHD still held for the project, it mirrors asset_dynamic_data_object::financing_current_supply
+   share_type financing_supply()const { return total_invested - total_refunded - issuer_claimed; }
+
+   asset_id_type       asset_id;
+   share_type          total_invested;        ///< KHD actually accepted, after capping at max_financing_amount
+   share_type          total_refunded;
+   share_type          issuer_claimed;        ///< KHD claimed by the issuer
+   share_type          tokens_issued;
+   share_type          tokens_claimed;        ///< project tokens claimed by investors
+   uint32_t            investment_count = 0;
+   uint32_t            investor_count = 0;
+   uint32_t            refund_count = 0;
+   uint32_t            issuer_claim_count = 0;
+   uint32_t            investor_claim_count = 0;
+   fc::time_point_sec  first_investment_time;
+   fc::time_point_sec  last_investment_time;
+   fc::time_point_sec  issue_time;
+};
+
+struct financing_bucket_key
+{
+   financing_bucket_key( asset_id_type a, uint32_t s, fc::time_point_sec o )
+   :asset_id(a),seconds(s),open(o){}
+   financing_bucket_key(){}
+
+   asset_id_type      asset_id;
+   uint32_t           seconds = 0;
+   fc::time_point_sec open;
+
+   friend bool operator < ( const financing_bucket_key& a, const financing_bucket_key& b )
+   {
+      return std::tie( a.asset_id, a.seconds, a.open ) < std::tie( b.asset_id, b.seconds, b.open );
+   }
+   friend bool operator == ( const financing_bucket_key& a, const financing_bucket_key& b )
+   {
+      return std::tie( a.asset_id, a.seconds, a.open ) == std::tie( b.asset_id, b.seconds, b.open );
+   }
+};
+
+/**
+ *  Financing activity of one project within one time bucket.
+ */
+struct financing_bucket_object : public abstract_object<financing_bucket_object>
+{
+   static const uint8_t space_id = KHC_FINANCING_SPACE_ID;
+   static const uint8_t type_id  = financing_bucket_object_type;
+
+   financing_bucket_key key;
+   share_type           invested;
+   share_type           refunded;
+   share_type           issuer_claimed;
+   share_type           tokens_claimed;
+   uint32_t             investment_count = 0;
+   uint32_t             new_investors = 0;
+   uint32_t             refund_count = 0;
+   uint32_t             issuer_claim_count = 0;
+   uint32_t             investor_claim_count = 0;
+   share_type           total_invested;       ///< project total_invested at the close of the bucket
+};
+
+/**
+ *  What one account invested in one project.
+ */
+struct financing_investor_object : public abstract_object<financing_investor_object>
+{
+   static const uint8_t space_id = KHC_FINANCING_SPACE_ID;
+   static const uint8_t type_id  = financing_investor_object_type;
+
+   asset_id_type       asset_id;
+   account_id_type     account;
+   share_type          invested;
+   uint32_t            investment_count = 0;
+   bool                refunded = false;
+   bool                claimed = false;
+};
+
+struct by_financing_project;
+typedef multi_index_container<
+   financing_project_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_financing_project>, member< financing_project_object, asset_id_type, &financing_project_object::asset_id > >
+   >
+> financing_project_multi_index_type;
+
+struct by_financing_key;
+typedef multi_index_container<
+   financing_bucket_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_financing_key>, member< financing_bucket_object, financing_bucket_key, &financing_bucket_object::key > >
+   >
+> financing_bucket_multi_index_type;
+
+struct by_financing_investor;
+typedef multi_index_container<
+   financing_investor_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique<
+         tag<by_financing_investor>,
+         composite_key<
+            financing_investor_object,
+            member<financing_investor_object, asset_id_type, &financing_investor_object::asset_id>,
+            member<financing_investor_object, account_id_type, &financing_investor_object::account>
+         >
+      >
+   >
+> financing_investor_multi_index_type;
+
+typedef generic_index<financing_project_object, financing_project_multi_index_type> financing_project_index;
+typedef generic_index<financing_bucket_object, financing_bucket_multi_index_type> financing_bucket_index;
+typedef generic_index<financing_investor_object, financing_investor_multi_index_type> financing_investor_index;
+
+/**
+ *  Totals of a project together with its financing targets.
+ */
+struct financing_progress
+{
+   financing_project_object project;
+   share_type               min_financing_amount;
+   share_type               max_financing_amount;
+   uint32_t                 start_financing_block_num = 0;
+   uint32_t                 end_financing_block_num = 0;
+   uint8_t                  state = 0;            ///< asset_dynamic_data_object::project_state
+   uint16_t                 percent_of_max = 0;   ///< total_invested / max_financing_amount, in GRAPHENE_100_PERCENT units
+   bool                     min_reached = false;
+};
+
+namespace detail
+{
+    class khc_financing_plugin_impl;
+}
+
+/**
+ *  The KHC financing plugin keeps per project rollups of public offerings.  Once per block it scans the applied
+ *  operations for investments, refunds, token issues and claims, aggregates them per project and then adjusts the
+ *  project totals and the configured time buckets once for the whole block.
+ *
+ *  Amounts that are not part of the operations (capped investments, refunds and claims) are derived from the state
+ *  the plugin tracked since genesis, so the plugin needs a replay when it is enabled on an existing node.
+ */
+class khc_financing_plugin : public graphene::app::plugin
+{
+   public:
+      khc_financing_plugin();
+      virtual ~khc_financing_plugin();
+
+      std::string plugin_name()const override;
+      virtual void plugin_set_program_options(
+         boost::program_options::options_description& cli,
+         boost::program_options::options_description& cfg) override;
+      virtual void plugin_initialize(
+         const boost::program_options::variables_map& options) override;
+      virtual void plugin_startup() override;
+
+      const flat_set<uint32_t>&   tracked_buckets()const;
+
+   private:
+      friend class detail::khc_financing_plugin_impl;
+      std::unique_ptr<detail::khc_financing_plugin_impl> my;
+};
+
+} } //graphene::khc_financing
+
+FC_REFLECT_DERIVED( graphene::khc_financing::financing_project_object, (graphene::db::object),
+                    (asset_id)
+                    (total_invested)(total_refunded)(issuer_claimed)
+                    (tokens_issued)(tokens_claimed)
+                    (investment_count)(investor_count)(refund_count)(issuer_claim_count)(investor_claim_count)
+                    (first_investment_time)(last_investment_time)(issue_time) )
+FC_REFLECT( graphene::khc_financing::financing_bucket_key, (asset_id)(seconds)(open) )
+FC_REFLECT_DERIVED( graphene::khc_financing::financing_bucket_object, (graphene::db::object),
+                    (key)
+                    (invested)(refunded)(issuer_claimed)(tokens_claimed)
+                    (investment_count)(new_investors)(refund_count)(issuer_claim_count)(investor_claim_count)
+                    (total_invested) )
+FC_REFLECT_DERIVED( graphene::khc_financing::financing_investor_object, (graphene::db::object),
+                    (asset_id)(account)(invested)(investment_count)(refunded)(claimed) )
+FC_REFLECT( graphene::khc_financing::financing_progress,
+            (project)(min_financing_amount)(max_financing_amount)
+            (start_financing_block_num)(end_financing_block_num)
+            (state)(percent_of_max)(min_reached) )
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/khc_financing/khc_financing_plugin.hpp>
+
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/config.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <graphene/khc/config.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+namespace graphene { namespace khc_financing {
+
+namespace detail
+{
+
+/// Financing activity of one project within one block
+struct project_activity
+{
+   share_type              invested;
+   share_type              refunded;
+   share_type              issuer_claimed;
+   share_type              tokens_claimed;
+   uint32_t                investment_count = 0;
+   uint32_t                new_investors = 0;
+   uint32_t                refund_count = 0;
+   uint32_t                issuer_claim_count = 0;
+   uint32_t                investor_claim_count = 0;
+   optional<share_type>    tokens_issued;
+};
+
+class khc_financing_plugin_impl
+{
+   public:
+      khc_financing_plugin_impl(khc_financing_plugin& _plugin)
+      :_self( _plugin ) {}
+      virtual ~khc_financing_plugin_impl();
+
+      /** this method is called as a callback after a block is applied
+       * and will aggregate the financing operations of the block per project.
+       */
+      void update_financing_histories( const signed_block& b );
+
+      graphene::chain::database& database()
+      {
+         return _self.database();
+      }
+
+      khc_financing_plugin&      _self;
+      flat_set<uint32_t>         _tracked_buckets;
+
+   private:
+      const financing_project_object* find_project( asset_id_type asset_id );
+      /// financing_current_supply of the project before the current operation
+      share_type financing_supply( asset_id_type asset_id, const project_activity& act );
+
+      void record_investment( const asset_investment_operation& o, project_activity& act );
+      void record_refund( const refund_investment_operation& o, project_activity& act );
+      void record_issue( const issue_asset_to_investors_operation& o, project_activity& act );
+      void record_issuer_claim( const claim_bitasset_investment_operation& o, project_activity& act );
+      void record_investor_claim( const claim_asset_investment_operation& o, project_activity& act );
+
+      void update_project( asset_id_type asset_id, const project_activity& act, fc::time_point_sec block_time );
+      void update_buckets( const financing_project_object& project, const project_activity& act,
+                           fc::time_point_sec block_time );
+};
+
+khc_financing_plugin_impl::~khc_financing_plugin_impl()
+{}
+
+const financing_project_object* khc_financing_plugin_impl::find_project( asset_id_type asset_id )
+{
+   const auto& idx = database().get_index_type<financing_project_index>().indices().get<by_financing_project>();
+   auto itr = idx.find( asset_id );
+   return itr == idx.end() ? nullptr : &*itr;
+}
+
+share_type khc_financing_plugin_impl::financing_supply( asset_id_type asset_id, const project_activity& act )
+{
+   const financing_project_object* project = find_project( asset_id );
+   share_type supply = ( project == nullptr ? share_type() : project->financing_supply() );
+   return supply + act.invested - act.refunded - act.issuer_claimed;
+}
+
+void khc_financing_plugin_impl::record_investment( const asset_investment_operation& o, project_activity& act )
+{
+   graphene::chain::database& db = database();
+   const asset_object& project_asset = o.investment_asset_id( db );
+
+   // the evaluator caps the last investment at max_financing_amount
+   share_type room = project_asset.proj_options.max_financing_amount - financing_supply( o.investment_asset_id, act );
+   share_type actual = std::max( std::min( o.amount.amount, room ), share_type() );
+
+   act.invested += actual;
+   ++act.investment_count;
+
+   const auto& idx = db.get_index_type<financing_investor_index>().indices().get<by_financing_investor>();
+   auto itr = idx.find( boost::make_tuple( o.investment_asset_id, o.account_id ) );
+   if( itr == idx.end() )
+   {
+      db.create<financing_investor_object>( [&]( financing_investor_object& i ) {
+         i.asset_id = o.investment_asset_id;
+         i.account = o.account_id;
+         i.invested = actual;
+         i.investment_count = 1;
+      });
+      ++act.new_investors;
+   }
+   else
+   {
+      db.modify( *itr, [&]( financing_investor_object& i ) {
+         i.invested += actual;
+         ++i.investment_count;
+      });
+   }
+}
+
+void khc_financing_plugin_impl::record_refund( const refund_investment_operation& o, project_activity& act )
+{
+   graphene::chain::database& db = database();
+   const auto& idx = db.get_index_type<financing_investor_index>().indices().get<by_financing_investor>();
+   auto itr = idx.find( boost::make_tuple( o.investment_asset_id, o.account_id ) );
+   if( itr == idx.end() || itr->refunded )
+      return;
+
+   act.refunded += itr->invested;
+   ++act.refund_count;
+   db.modify( *itr, []( financing_investor_object& i ) {
+      i.refunded = true;
+   });
+}
+
+void khc_financing_plugin_impl::record_issue( const issue_asset_to_investors_operation& o, project_activity& act )
+{
+   graphene::chain::database& db = database();
+   act.tokens_issued = o.investment_asset_id( db ).dynamic_asset_data_id( db ).investment_confidential_supply;
+}
+
+void khc_financing_plugin_impl::record_issuer_claim( const claim_bitasset_investment_operation& o, project_activity& act )
+{
+   graphene::chain::database& db = database();
+   const financing_project_object* project = find_project( o.asset_id );
+   const uint32_t claim_times = ( project == nullptr ? 0 : project->issuer_claim_count ) + act.issuer_claim_count;
+
+   // same schedule as claim_bitasset_investment_evaluator, the financed amount no longer changes at this point
+   const share_type financed = o.asset_id( db ).dynamic_asset_data_id( db ).financing_confidential_supply;
+   const share_type first = ( fc::uint128_t( financed.value ) * KHC_FIRST_CLAIM_INVESTMENT_RATIO / KHC_100_PERCENT ).to_uint64();
+   const share_type second = ( fc::uint128_t( financed.value ) * KHC_SECOND_CLAIM_INVESTMENT_TATIO / KHC_100_PERCENT ).to_uint64();
+   share_type amount;
+   if( claim_times == 0 )
+      amount = first;
+   else if( claim_times == 1 )
+      amount = second;
+   else
+      amount = financed - first - second;
+
+   act.issuer_claimed += amount;
+   ++act.issuer_claim_count;
+}
+
+void khc_financing_plugin_impl::record_investor_claim( const claim_asset_investment_operation& o, project_activity& act )
+{
+   graphene::chain::database& db = database();
+   share_type tokens;
+   const auto& inv_idx = db.get_index_type<asset_investment_index>().indices().get<by_account>();
+   auto range = inv_idx.equal_range( o.account_id );
+   for( auto itr = range.first; itr != range.second; ++itr )
+      if( itr->investment_asset_id == o.asset_id )
+         tokens += itr->investment_tokens;
+
+   act.tokens_claimed += tokens;
+   ++act.investor_claim_count;
+
+   const auto& idx = db.get_index_type<financing_investor_index>().indices().get<by_financing_investor>();
+   auto itr = idx.find( boost::make_tuple( o.asset_id, o.account_id ) );
+   if( itr != idx.end() )
+      db.modify( *itr, []( financing_investor_object& i ) {
+         i.claimed = true;
+      });
+}
+
+void khc_financing_plugin_impl::update_project( asset_id_type asset_id, const project_activity& act,
+                                                fc::time_point_sec block_time )
+{
+   graphene::chain::database& db = database();
+   auto apply = [&]( financing_project_object& p ) {
+      p.total_invested += act.invested;
+      p.total_refunded += act.refunded;
+      p.issuer_claimed += act.issuer_claimed;
+      p.tokens_claimed += act.tokens_claimed;
+      p.investment_count += act.investment_count;
+      p.investor_count += act.new_investors;
+      p.refund_count += act.refund_count;
+      p.issuer_claim_count += act.issuer_claim_count;
+      p.investor_claim_count += act.investor_claim_count;
+      if( act.investment_count > 0 )
+      {
+         if( p.first_investment_time == fc::time_point_sec() )
+            p.first_investment_time = block_time;
+         p.last_investment_time = block_time;
+      }
+      if( act.tokens_issued.valid() )
+      {
+         p.tokens_issued = *act.tokens_issued;
+         p.issue_time = block_time;
+      }
+   };
+
+   const financing_project_object* project = find_project( asset_id );
+   if( project == nullptr )
+      project = &db.create<financing_project_object>( [&]( financing_project_object& p ) {
+         p.asset_id = asset_id;
+         apply( p );
+      });
+   else
+      db.modify( *project, apply );
+
+   update_buckets( *project, act, block_time );
+}
+
+void khc_financing_plugin_impl::update_buckets( const financing_project_object& project, const project_activity& act,
+                                                fc::time_point_sec block_time )
+{
+   if( _tracked_buckets.empty() )
+      return;
+
+   graphene::chain::database& db = database();
+   const auto& by_key_idx = db.get_index_type<financing_bucket_index>().indices().get<by_financing_key>();
+   for( uint32_t bucket : _tracked_buckets )
+   {
+      financing_bucket_key key( project.asset_id, bucket, block_time - ( block_time.sec_since_epoch() % bucket ) );
+      auto apply = [&]( financing_bucket_object& b ) {
+         b.invested += act.invested;
+         b.refunded += act.refunded;
+         b.issuer_claimed += act.issuer_claimed;
+         b.tokens_claimed += act.tokens_claimed;
+         b.investment_count += act.investment_count;
+         b.new_investors += act.new_investors;
+         b.refund_count += act.refund_count;
+         b.issuer_claim_count += act.issuer_claim_count;
+         b.investor_claim_count += act.investor_claim_count;
+         b.total_invested = project.total_invested;
+      };
+
+      auto itr = by_key_idx.find( key );
+      if( itr == by_key_idx.end() )
+         db.create<financing_bucket_object>( [&]( financing_bucket_object& b ) {
+            b.key = key;
+            apply( b );
+         });
+      else
+         db.modify( *itr, apply );
+   }
+}
+
+void khc_financing_plugin_impl::update_financing_histories( const signed_block& b )
+{
+   graphene::chain::database& db = database();
+
+   // operations are recorded in order, since capped investments and claims depend on the earlier ones
+   flat_map<asset_id_type, project_activity> activities;
+   const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
+   for( const optional< operation_history_object >& o_op : hist )
+   {
+      if( !o_op.valid() )
+         continue;
+      const operation& op = o_op->op;
+      try
+      {
+         switch( op.which() )
+         {
+            case operation::tag<asset_investment_operation>::value:
+            {
+               const auto& o = op.get<asset_investment_operation>();
+               record_investment( o, activities[o.investment_asset_id] );
+               break;
+            }
+            case operation::tag<refund_investment_operation>::value:
+            {
+               const auto& o = op.get<refund_investment_operation>();
+               record_refund( o, activities[o.investment_asset_id] );
+               break;
+            }
+            case operation::tag<issue_asset_to_investors_operation>::value:
+            {
+               const auto& o = op.get<issue_asset_to_investors_operation>();
+               record_issue( o, activities[o.investment_asset_id] );
+               break;
+            }
+            case operation::tag<claim_bitasset_investment_operation>::value:
+            {
+               const auto& o = op.get<claim_bitasset_investment_operation>();
+               record_issuer_claim( o, activities[o.asset_id] );
+               break;
+            }
+            case operation::tag<claim_asset_investment_operation>::value:
+            {
+               const auto& o = op.get<claim_asset_investment_operation>();
+               record_investor_claim( o, activities[o.asset_id] );
+               break;
+            }
+            default:
+               break;
+         }
+      } FC_CAPTURE_AND_LOG( (op) )
+   }
+
+   for( const auto& item : activities )
+   {
+      try
+      {
+         update_project( item.first, item.second, b.timestamp );
+      } FC_CAPTURE_AND_LOG( (item.first)(b.block_num()) )
+   }
+}
+
+} // end namespace detail
+
+
+
+
+
+
+khc_financing_plugin::khc_financing_plugin() :
+   my( new detail::khc_financing_plugin_impl(*this) )
+{
+}
+
+khc_financing_plugin::~khc_financing_plugin()
+{
+}
+
+std::string khc_financing_plugin::plugin_name()const
+{
+   return "khc_financing";
+}
+
+void khc_financing_plugin::plugin_set_program_options(
+   boost::program_options::options_description& cli,
+   boost::program_options::options_description& cfg
+   )
+{
+   cli.add_options()
+         ("financing-bucket-size", boost::program_options::value<string>()->default_value("[3600,86400]"),
+           "Track KHC financing activity by grouping it into buckets of equal size measured in seconds specified as a JSON array of numbers")
+         ;
+   cfg.add(cli);
+}
+
+void khc_financing_plugin::plugin_initialize(const boost::program_options::variables_map& options)
+{ try {
+   database().applied_block.connect( [this]( const signed_block& b){ my->update_financing_histories(b); } );
+   database().add_index< primary_index< financing_project_index > >();
+   database().add_index< primary_index< financing_bucket_index > >();
+   database().add_index< primary_index< financing_investor_index > >();
+
+   if( options.count( "financing-bucket-size" ) )
+   {
+      const std::string& buckets = options["financing-bucket-size"].as<string>();
+      my->_tracked_buckets = fc::json::from_string(buckets).as<flat_set<uint32_t>>(2);
+      my->_tracked_buckets.erase( 0 );
+   }
+} FC_CAPTURE_AND_RETHROW() }
+
+void khc_financing_plugin::plugin_startup()
+{
+}
+
+const flat_set<uint32_t>& khc_financing_plugin::tracked_buckets() const
+{
+   return my->_tracked_buckets;
+}
+
+} }
@@ -223,8 +223,11 @@ namespace detail
 
 /**
  *  The market history plugin can be configured to track any number of intervals via its configuration.  Once per block it
- *  will scan the virtual operations and look for fill_order_operations and then adjust the appropriate bucket objects for
- *  each fill order.
+ *  will scan the virtual operations and look for fill_order_operations, aggregate them per market and then adjust the
+ *  appropriate ticker and bucket objects once for the whole block.
+ *
+ *  Buckets and order history beyond the configured limits are removed after each maintenance interval, so between
+ *  two maintenances they may temporarily hold more data than configured.
  */
 class market_history_plugin : public graphene::app::plugin
 {
@@ -41,6 +41,30 @@ namespace graphene { namespace market_history {
 namespace detail
 {
 
+typedef std::pair<asset_id_type,asset_id_type> market_type;
+
+/// Maker fills of one market within one block, prices and volumes oriented like bucket_key
+struct market_fills
+{
+   uint32_t       fill_count = 0;
+   price          open;
+   price          close;
+   price          high;
+   price          low;
+   share_type     base_volume;        ///< saturating, for buckets
+   share_type     quote_volume;
+   fc::uint128    ticker_base_volume; ///< wrapping, for tickers
+   fc::uint128    ticker_quote_volume;
+};
+
+/// Fills rolled out of the 24h ticker window of one market within one block
+struct market_rolled_out
+{
+   price          last_day;
+   fc::uint128    base_volume;
+   fc::uint128    quote_volume;
+};
+
 class market_history_plugin_impl
 {
    public:
@@ -63,17 +87,28 @@ class market_history_plugin_impl
       uint32_t                   _maximum_history_per_bucket_size = 1000;
       uint32_t                   _max_order_his_records_per_market = 1000;
       uint32_t                   _max_order_his_seconds_per_market = 259200;
+      /// next_maintenance_time seen in the last block, old data is pruned whenever it changes
+      fc::time_point_sec         _next_maintenance_time;
+
+   private:
+      void record_fill( const fill_order_operation& o, fc::time_point_sec now,
+                        flat_map<market_type,int64_t>& next_sequence,
+                        flat_map<market_type,market_fills>& fills,
+                        const market_ticker_meta_object*& meta );
+      void update_tickers( const flat_map<market_type,market_fills>& fills );
+      void update_buckets( const flat_map<market_type,market_fills>& fills, fc::time_point_sec now );
+      void roll_ticker_window( const market_ticker_meta_object& meta, fc::time_point_sec now );
+      void prune_buckets( fc::time_point_sec now );
+      void prune_order_history( fc::time_point_sec now );
 };
 
 
 struct operation_process_fill_order
 {
-   market_history_plugin&            _plugin;
-   fc::time_point_sec                _now;
-   const market_ticker_meta_object*& _meta;
+   vector<const fill_order_operation*>& _fills;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, const market_ticker_meta_object*& meta )
-   :_plugin(mhp),_now(n),_meta(meta) {}
+   operation_process_fill_order( vector<const fill_order_operation*>& fills )
+   :_fills(fills) {}
 
    typedef void result_type;
 
@@ -81,58 +116,331 @@ struct operation_process_fill_order
    template<typename T>
    void operator()( const T& )const{}
 
-   void operator()( const fill_order_operation& o )const 
+   void operator()( const fill_order_operation& o )const
    {
-      //ilog( "processing ${o}", ("o",o) );
-      auto& db         = _plugin.database();
-      const auto& order_his_idx = db.get_index_type<history_index>().indices();
-      const auto& history_idx = order_his_idx.get<by_key>();
-      const auto& his_time_idx = order_his_idx.get<by_market_time>();
-
-      // To save new filled order data
-      history_key hkey;
-      hkey.base = o.pays.asset_id;
-      hkey.quote = o.receives.asset_id;
-      if( hkey.base > hkey.quote ) 
-         std::swap( hkey.base, hkey.quote );
-      hkey.sequence = std::numeric_limits<int64_t>::min();
+      _fills.push_back( &o );
+   }
+};
 
-      auto itr = history_idx.lower_bound( hkey );
+static void add_saturating( share_type& total, share_type amount )
+{
+   try {
+      total += amount;
+   } catch( fc::overflow_exception ) {
+      total = std::numeric_limits<int64_t>::max();
+   }
+}
+
+/// @return the open time of the oldest bucket of the given size to keep at @p now
+static fc::time_point_sec bucket_cutoff( uint32_t bucket, uint32_t max_history, fc::time_point_sec now )
+{
+   auto bucket_num = now.sec_since_epoch() / bucket;
+   fc::time_point_sec cutoff;
+   if( bucket_num > max_history )
+      cutoff = cutoff + ( bucket * ( bucket_num - max_history ) );
+   return cutoff;
+}
 
+market_history_plugin_impl::~market_history_plugin_impl()
+{}
+
+void market_history_plugin_impl::record_fill( const fill_order_operation& o, fc::time_point_sec now,
+                                              flat_map<market_type,int64_t>& next_sequence,
+                                              flat_map<market_type,market_fills>& fills,
+                                              const market_ticker_meta_object*& meta )
+{
+   auto& db = database();
+
+   // To save new filled order data
+   history_key hkey;
+   hkey.base = o.pays.asset_id;
+   hkey.quote = o.receives.asset_id;
+   if( hkey.base > hkey.quote )
+      std::swap( hkey.base, hkey.quote );
+
+   const market_type market( hkey.base, hkey.quote );
+   auto seq_itr = next_sequence.find( market );
+   if( seq_itr == next_sequence.end() )
+   {
+      const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
+      hkey.sequence = std::numeric_limits<int64_t>::min();
+      auto itr = history_idx.lower_bound( hkey );
+      int64_t sequence = 0;
       if( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
-         hkey.sequence = itr->key.sequence - 1;
+         sequence = itr->key.sequence - 1;
+      seq_itr = next_sequence.emplace( market, sequence ).first;
+   }
+   hkey.sequence = seq_itr->second--;
+
+   const auto& new_order_his_obj = db.create<order_history_object>( [&]( order_history_object& ho ) {
+      ho.key = hkey;
+      ho.time = now;
+      ho.op = o;
+   });
+
+   // save a reference to market ticker meta object
+   if( meta == nullptr )
+   {
+      const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
+      if( meta_idx.size() == 0 )
+         meta = &db.create<market_ticker_meta_object>( [&]( market_ticker_meta_object& mtm ) {
+            mtm.rolling_min_order_his_id = new_order_his_obj.id;
+            mtm.skip_min_order_his_id = false;
+         });
+      else
+         meta = &( *meta_idx.begin() );
+   }
+
+   // To update ticker data and buckets data, only update for maker orders
+   if( !o.is_maker )
+      return;
+
+   price trade_price = o.pays / o.receives;
+   if( o.pays.asset_id > o.receives.asset_id )
+      trade_price = ~trade_price;
+
+   price fill_price = o.fill_price;
+   if( fill_price.base.asset_id > fill_price.quote.asset_id )
+      fill_price = ~fill_price;
+
+   auto& f = fills[market];
+   if( f.fill_count == 0 )
+   {
+      f.open = fill_price;
+      f.high = fill_price;
+      f.low = fill_price;
+   }
+   else
+   {
+      if( f.high < fill_price )
+         f.high = fill_price;
+      if( f.low > fill_price )
+         f.low = fill_price;
+   }
+   f.close = fill_price;
+   ++f.fill_count;
+   add_saturating( f.base_volume, trade_price.base.amount );
+   add_saturating( f.quote_volume, trade_price.quote.amount );
+   f.ticker_base_volume += trade_price.base.amount.value;  // ignore overflow
+   f.ticker_quote_volume += trade_price.quote.amount.value; // ignore overflow
+}
+
+void market_history_plugin_impl::update_tickers( const flat_map<market_type,market_fills>& fills )
+{
+   auto& db = database();
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   for( const auto& item : fills )
+   {
+      const market_fills& f = item.second;
+      auto ticker_itr = ticker_idx.find( std::make_tuple( item.first.first, item.first.second ) );
+      if( ticker_itr == ticker_idx.end() )
+      {
+         db.create<market_ticker_object>( [&]( market_ticker_object& mt ) {
+            mt.base           = item.first.first;
+            mt.quote          = item.first.second;
+            mt.last_day_base  = 0;
+            mt.last_day_quote = 0;
+            mt.latest_base    = f.close.base.amount;
+            mt.latest_quote   = f.close.quote.amount;
+            mt.base_volume    = f.ticker_base_volume;
+            mt.quote_volume   = f.ticker_quote_volume;
+         });
+      }
       else
-         hkey.sequence = 0;
+      {
+         db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
+            mt.latest_base    = f.close.base.amount;
+            mt.latest_quote   = f.close.quote.amount;
+            mt.base_volume    += f.ticker_base_volume;  // ignore overflow
+            mt.quote_volume   += f.ticker_quote_volume; // ignore overflow
+         });
+      }
+   }
+}
 
-      const auto& new_order_his_obj = db.create<order_history_object>( [&]( order_history_object& ho ) {
-         ho.key = hkey;
-         ho.time = _now;
-         ho.op = o;
-      });
+void market_history_plugin_impl::update_buckets( const flat_map<market_type,market_fills>& fills,
+                                                 fc::time_point_sec now )
+{
+   if( _maximum_history_per_bucket_size == 0 || _tracked_buckets.size() == 0 )
+      return;
 
-      // save a reference to market ticker meta object
-      if( _meta == nullptr )
+   auto& db = database();
+   const auto& by_key_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+   for( const auto& item : fills )
+   {
+      const market_fills& f = item.second;
+      bucket_key key;
+      key.base  = item.first.first;
+      key.quote = item.first.second;
+      for( auto bucket : _tracked_buckets )
       {
-         const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
-         if( meta_idx.size() == 0 )
-            _meta = &db.create<market_ticker_meta_object>( [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = new_order_his_obj.id;
-               mtm.skip_min_order_his_id = false;
+         key.seconds = bucket;
+         key.open    = fc::time_point_sec() + ( now.sec_since_epoch() / bucket * bucket );
+
+         auto bucket_itr = by_key_idx.find( key );
+         if( bucket_itr == by_key_idx.end() )
+         { // create new bucket
+            db.create<bucket_object>( [&]( bucket_object& b ){
+               b.key = key;
+               b.base_volume = f.base_volume;
+               b.quote_volume = f.quote_volume;
+               b.open_base = f.open.base.amount;
+               b.open_quote = f.open.quote.amount;
+               b.close_base = f.close.base.amount;
+               b.close_quote = f.close.quote.amount;
+               b.high_base = f.high.base.amount;
+               b.high_quote = f.high.quote.amount;
+               b.low_base = f.low.base.amount;
+               b.low_quote = f.low.quote.amount;
             });
+         }
          else
-            _meta = &( *meta_idx.begin() );
+         { // update existing bucket
+            db.modify( *bucket_itr, [&]( bucket_object& b ){
+               add_saturating( b.base_volume, f.base_volume );
+               add_saturating( b.quote_volume, f.quote_volume );
+               b.close_base = f.close.base.amount;
+               b.close_quote = f.close.quote.amount;
+               if( b.high() < f.high )
+               {
+                  b.high_base = f.high.base.amount;
+                  b.high_quote = f.high.quote.amount;
+               }
+               if( b.low() > f.low )
+               {
+                  b.low_base = f.low.base.amount;
+                  b.low_quote = f.low.quote.amount;
+               }
+            });
+         }
+      }
+   }
+}
+
+void market_history_plugin_impl::roll_ticker_window( const market_ticker_meta_object& meta, fc::time_point_sec now )
+{
+   auto& db = database();
+   time_point_sec last_day = now - 86400;
+   object_id_type last_min_his_id = meta.rolling_min_order_his_id;
+   bool skip = meta.skip_min_order_his_id;
+
+   flat_map<market_type,market_rolled_out> rolled_out;
+   const auto& history_idx = db.get_index_type<history_index>().indices().get<by_id>();
+   auto history_itr = history_idx.lower_bound( meta.rolling_min_order_his_id );
+   while( history_itr != history_idx.end() && history_itr->time < last_day )
+   {
+      const fill_order_operation& o = history_itr->op;
+      if( skip && history_itr->id == meta.rolling_min_order_his_id )
+         skip = false;
+      else if( o.is_maker )
+      {
+         price trade_price = o.pays / o.receives;
+         if( o.pays.asset_id > o.receives.asset_id )
+            trade_price = ~trade_price;
+
+         price fill_price = o.fill_price;
+         if( fill_price.base.asset_id > fill_price.quote.asset_id )
+            fill_price = ~fill_price;
+
+         auto& r = rolled_out[ market_type( history_itr->key.base, history_itr->key.quote ) ];
+         r.last_day = fill_price;
+         r.base_volume += trade_price.base.amount.value;
+         r.quote_volume += trade_price.quote.amount.value;
+      }
+      last_min_his_id = history_itr->id;
+      ++history_itr;
+   }
+
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   for( const auto& item : rolled_out )
+   {
+      auto ticker_itr = ticker_idx.find( std::make_tuple( item.first.first, item.first.second ) );
+      if( ticker_itr != ticker_idx.end() ) // should always be true
+      {
+         db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
+            mt.last_day_base  = item.second.last_day.base.amount;
+            mt.last_day_quote = item.second.last_day.quote.amount;
+            mt.base_volume    -= item.second.base_volume;  // ignore underflow
+            mt.quote_volume   -= item.second.quote_volume; // ignore underflow
+         });
+      }
+   }
+
+   // update meta
+   if( history_itr != history_idx.end() ) // if still has some data rolling
+   {
+      if( history_itr->id != meta.rolling_min_order_his_id ) // if rolled out some
+      {
+         db.modify( meta, [&]( market_ticker_meta_object& mtm ) {
+            mtm.rolling_min_order_his_id = history_itr->id;
+            mtm.skip_min_order_his_id = false;
+         });
+      }
+   }
+   else // if all data are rolled out
+   {
+      if( last_min_his_id != meta.rolling_min_order_his_id ) // if rolled out some
+      {
+         db.modify( meta, [&]( market_ticker_meta_object& mtm ) {
+            mtm.rolling_min_order_his_id = last_min_his_id;
+            mtm.skip_min_order_his_id = true;
+         });
+      }
+   }
+}
+
+void market_history_plugin_impl::prune_buckets( fc::time_point_sec now )
+{
+   if( _maximum_history_per_bucket_size == 0 )
+      return;
+
+   auto& db = database();
+   const auto& by_key_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+   auto bucket_itr = by_key_idx.begin();
+   while( bucket_itr != by_key_idx.end() )
+   {
+      bucket_key key = bucket_itr->key;
+      if( _tracked_buckets.find( key.seconds ) != _tracked_buckets.end() )
+      {
+         const auto cutoff = bucket_cutoff( key.seconds, _maximum_history_per_bucket_size, now );
+         while( bucket_itr != by_key_idx.end() &&
+                bucket_itr->key.base == key.base &&
+                bucket_itr->key.quote == key.quote &&
+                bucket_itr->key.seconds == key.seconds &&
+                bucket_itr->key.open < cutoff )
+         {
+            auto old_bucket_itr = bucket_itr;
+            ++bucket_itr;
+            db.remove( *old_bucket_itr );
+         }
       }
+      // skip to the next market and bucket size
+      key.open = fc::time_point_sec::maximum();
+      bucket_itr = by_key_idx.upper_bound( key );
+   }
+}
 
-      // To remove old filled order data
-      const auto max_records = _plugin.max_order_his_records_per_market();
-      hkey.sequence += max_records;
-      itr = history_idx.lower_bound( hkey );
+void market_history_plugin_impl::prune_order_history( fc::time_point_sec now )
+{
+   auto& db = database();
+   const auto& order_his_idx = db.get_index_type<history_index>().indices();
+   const auto& history_idx = order_his_idx.get<by_key>();
+   const auto& his_time_idx = order_his_idx.get<by_market_time>();
+
+   const auto max_seconds = _max_order_his_seconds_per_market;
+   fc::time_point_sec min_time;
+   if( min_time + max_seconds < now )
+      min_time = now - max_seconds;
+
+   auto market_itr = history_idx.begin();
+   while( market_itr != history_idx.end() )
+   {
+      // the first entry of a market is its latest fill
+      history_key hkey = market_itr->key;
+      hkey.sequence += _max_order_his_records_per_market;
+      auto itr = history_idx.lower_bound( hkey );
       if( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
       {
-         const auto max_seconds = _plugin.max_order_his_seconds_per_market();
-         fc::time_point_sec min_time;
-         if( min_time + max_seconds < _now )
-            min_time = _now - max_seconds;
          auto time_itr = his_time_idx.lower_bound( std::make_tuple( hkey.base, hkey.quote, min_time ) );
          if( time_itr != his_time_idx.end() && time_itr->key.base == hkey.base && time_itr->key.quote == hkey.quote )
          {
@@ -156,143 +464,11 @@ struct operation_process_fill_order
             }
          }
       }
-
-      // To update ticker data and buckets data, only update for maker orders
-      if( !o.is_maker )
-         return;
-
-      bucket_key key;
-      key.base    = o.pays.asset_id;
-      key.quote   = o.receives.asset_id;
-
-      price trade_price = o.pays / o.receives;
-
-      if( key.base > key.quote )
-      {
-         std::swap( key.base, key.quote );
-         trade_price = ~trade_price;
-      }
-
-      price fill_price = o.fill_price;
-      if( fill_price.base.asset_id > fill_price.quote.asset_id )
-         fill_price = ~fill_price;
-
-      // To update ticker data
-      const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
-      auto ticker_itr = ticker_idx.find( std::make_tuple( key.base, key.quote ) );
-      if( ticker_itr == ticker_idx.end() )
-      {
-         db.create<market_ticker_object>( [&]( market_ticker_object& mt ) {
-            mt.base           = key.base;
-            mt.quote          = key.quote;
-            mt.last_day_base  = 0;
-            mt.last_day_quote = 0;
-            mt.latest_base    = fill_price.base.amount;
-            mt.latest_quote   = fill_price.quote.amount;
-            mt.base_volume    = trade_price.base.amount.value;
-            mt.quote_volume   = trade_price.quote.amount.value;
-         });
-      }
-      else
-      {
-         db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
-            mt.latest_base    = fill_price.base.amount;
-            mt.latest_quote   = fill_price.quote.amount;
-            mt.base_volume    += trade_price.base.amount.value;  // ignore overflow
-            mt.quote_volume   += trade_price.quote.amount.value; // ignore overflow
-         });
-      }
-
-      // To update buckets data
-      const auto max_history = _plugin.max_history();
-      if( max_history == 0 ) return;
-
-      const auto& buckets = _plugin.tracked_buckets();
-      if( buckets.size() == 0 ) return;
-
-      const auto& bucket_idx = db.get_index_type<bucket_index>();
-      for( auto bucket : buckets )
-      {
-          auto bucket_num = _now.sec_since_epoch() / bucket;
-          fc::time_point_sec cutoff;
-          if( bucket_num > max_history )
-             cutoff = cutoff + ( bucket * ( bucket_num - max_history ) );
-
-          key.seconds = bucket;
-          key.open    = fc::time_point_sec() + ( bucket_num * bucket );
-
-          const auto& by_key_idx = bucket_idx.indices().get<by_key>();
-          auto bucket_itr = by_key_idx.find( key );
-          if( bucket_itr == by_key_idx.end() )
-          { // create new bucket
-            /* const auto& obj = */
-            db.create<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.base_volume = trade_price.base.amount;
-                 b.quote_volume = trade_price.quote.amount;
-                 b.open_base = fill_price.base.amount;
-                 b.open_quote = fill_price.quote.amount;
-                 b.close_base = fill_price.base.amount;
-                 b.close_quote = fill_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
-            });
-            //wlog( "    creating bucket ${b}", ("b",obj) );
-          }
-          else
-          { // update existing bucket
-             //wlog( "    before updating bucket ${b}", ("b",*bucket_itr) );
-             db.modify( *bucket_itr, [&]( bucket_object& b ){
-                  try {
-                     b.base_volume += trade_price.base.amount;
-                  } catch( fc::overflow_exception ) {
-                     b.base_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  try {
-                     b.quote_volume += trade_price.quote.amount;
-                  } catch( fc::overflow_exception ) {
-                     b.quote_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  b.close_base = fill_price.base.amount;
-                  b.close_quote = fill_price.quote.amount;
-                  if( b.high() < fill_price )
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > fill_price )
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
-             });
-             //wlog( "    after bucket bucket ${b}", ("b",*bucket_itr) );
-          }
-
-          {
-             key.open = fc::time_point_sec();
-             bucket_itr = by_key_idx.lower_bound( key );
-
-             while( bucket_itr != by_key_idx.end() &&
-                    bucket_itr->key.base == key.base &&
-                    bucket_itr->key.quote == key.quote &&
-                    bucket_itr->key.seconds == bucket &&
-                    bucket_itr->key.open < cutoff )
-             {
-              //  elog( "    removing old bucket ${b}", ("b", *bucket_itr) );
-                auto old_bucket_itr = bucket_itr;
-                ++bucket_itr;
-                db.remove( *old_bucket_itr );
-             }
-          }
-      }
+      // skip to the next market
+      hkey.sequence = std::numeric_limits<int64_t>::max();
+      market_itr = history_idx.upper_bound( hkey );
    }
-};
-
-market_history_plugin_impl::~market_history_plugin_impl()
-{}
+}
 
 void market_history_plugin_impl::update_market_histories( const signed_block& b )
 {
@@ -301,85 +477,42 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
    if( meta_idx.size() > 0 )
       _meta = &( *meta_idx.begin() );
+
+   vector<const fill_order_operation*> fill_ops;
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
       if( o_op.valid() )
-      {
-         try
-         {
-            o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _meta ) );
-         } FC_CAPTURE_AND_LOG( (o_op) )
-      }
+         o_op->op.visit( operation_process_fill_order( fill_ops ) );
    }
-   // roll out expired data from ticker
-   if( _meta != nullptr )
+
+   // Fills are aggregated per market, so that every ticker and bucket is written at most once per block
+   flat_map<market_type,int64_t> next_sequence;
+   flat_map<market_type,market_fills> fills;
+   for( const fill_order_operation* o : fill_ops )
    {
-      time_point_sec last_day = b.timestamp - 86400;
-      object_id_type last_min_his_id = _meta->rolling_min_order_his_id;
-      bool skip = _meta->skip_min_order_his_id;
-
-      const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
-      const auto& history_idx = db.get_index_type<history_index>().indices().get<by_id>();
-      auto history_itr = history_idx.lower_bound( _meta->rolling_min_order_his_id );
-      while( history_itr != history_idx.end() && history_itr->time < last_day )
+      try
       {
-         const fill_order_operation& o = history_itr->op;
-         if( skip && history_itr->id == _meta->rolling_min_order_his_id )
-            skip = false;
-         else if( o.is_maker )
-         {
-            bucket_key key;
-            key.base    = o.pays.asset_id;
-            key.quote   = o.receives.asset_id;
-
-            price trade_price = o.pays / o.receives;
-
-            if( key.base > key.quote )
-            {
-               std::swap( key.base, key.quote );
-               trade_price = ~trade_price;
-            }
+         record_fill( *o, b.timestamp, next_sequence, fills, _meta );
+      } FC_CAPTURE_AND_LOG( (*o) )
+   }
+   try
+   {
+      update_tickers( fills );
+      update_buckets( fills, b.timestamp );
+   } FC_CAPTURE_AND_LOG( (b.block_num()) )
 
-            price fill_price = o.fill_price;
-            if( fill_price.base.asset_id > fill_price.quote.asset_id )
-               fill_price = ~fill_price;
+   // roll out expired data from ticker
+   if( _meta != nullptr )
+      roll_ticker_window( *_meta, b.timestamp );
 
-            auto ticker_itr = ticker_idx.find( std::make_tuple( key.base, key.quote ) );
-            if( ticker_itr != ticker_idx.end() ) // should always be true
-            {
-               db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
-                  mt.last_day_base  = fill_price.base.amount;
-                  mt.last_day_quote = fill_price.quote.amount;
-                  mt.base_volume    -= trade_price.base.amount.value;  // ignore underflow
-                  mt.quote_volume   -= trade_price.quote.amount.value; // ignore underflow
-               });
-            }
-         }
-         last_min_his_id = history_itr->id;
-         ++history_itr;
-      }
-      // update meta
-      if( history_itr != history_idx.end() ) // if still has some data rolling
-      {
-         if( history_itr->id != _meta->rolling_min_order_his_id ) // if rolled out some
-         {
-            db.modify( *_meta, [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = history_itr->id;
-               mtm.skip_min_order_his_id = false;
-            });
-         }
-      }
-      else // if all data are rolled out
-      {
-         if( last_min_his_id != _meta->rolling_min_order_his_id ) // if rolled out some
-         {
-            db.modify( *_meta, [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = last_min_his_id;
-               mtm.skip_min_order_his_id = true;
-            });
-         }
-      }
+   // old buckets and order history are removed in one pass after each maintenance
+   const auto& dgp = db.get_dynamic_global_properties();
+   if( dgp.next_maintenance_time != _next_maintenance_time )
+   {
+      _next_maintenance_time = dgp.next_maintenance_time;
+      prune_buckets( b.timestamp );
+      prune_order_history( b.timestamp );
    }
 }
 
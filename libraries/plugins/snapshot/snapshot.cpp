@@ -36,6 +36,8 @@ namespace bpo = boost::program_options;
 static const char* OPT_BLOCK_NUM  = "snapshot-at-block";
 static const char* OPT_BLOCK_TIME = "snapshot-at-time";
 static const char* OPT_DEST       = "snapshot-to";
+static const char* OPT_FORMAT     = "snapshot-format";
+static const char* OPT_THREADS    = "snapshot-threads";
 
 void snapshot_plugin::plugin_set_program_options(
    boost::program_options::options_description& command_line_options,
@@ -44,7 +46,11 @@ void snapshot_plugin::plugin_set_program_options(
    command_line_options.add_options()
          (OPT_BLOCK_NUM, bpo::value<uint32_t>(), "Block number after which to do a snapshot")
          (OPT_BLOCK_TIME, bpo::value<string>(), "Block time (ISO format) after which to do a snapshot")
-         (OPT_DEST, bpo::value<string>(), "Pathname of JSON file where to store the snapshot")
+         (OPT_DEST, bpo::value<string>(), "Pathname of the file where to store the snapshot")
+         (OPT_FORMAT, bpo::value<string>()->default_value("binary"),
+          "Snapshot format: binary (can be loaded with --import-snapshot) or json (one object per line)")
+         (OPT_THREADS, bpo::value<uint32_t>()->default_value(0),
+          "Number of threads writing a binary snapshot, 0 to use all cores")
          ;
    config_file_options.add(command_line_options);
 }
@@ -67,6 +73,14 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
    {
       FC_ASSERT( options.count(OPT_DEST), "Must specify snapshot-to in addition to snapshot-at-block or snapshot-at-time!" );
       dest = options[OPT_DEST].as<std::string>();
+      if( options.count(OPT_FORMAT) )
+      {
+         const std::string format = options[OPT_FORMAT].as<std::string>();
+         FC_ASSERT( format == "binary" || format == "json", "Unknown snapshot-format ${f}", ("f",format) );
+         json_format = ( format == "json" );
+      }
+      if( options.count(OPT_THREADS) )
+         threads = options[OPT_THREADS].as<uint32_t>();
       if( options.count(OPT_BLOCK_NUM) )
          snapshot_block = options[OPT_BLOCK_NUM].as<uint32_t>();
       if( options.count(OPT_BLOCK_TIME) )
@@ -84,9 +98,9 @@ void snapshot_plugin::plugin_startup() {}
 
 void snapshot_plugin::plugin_shutdown() {}
 
-static void create_snapshot( const graphene::chain::database& db, const fc::path& dest )
+static void create_json_snapshot( const graphene::chain::database& db, const fc::path& dest )
 {
-   ilog("snapshot plugin: creating snapshot");
+   ilog("snapshot plugin: creating JSON snapshot");
    fc::ofstream out;
    try
    {
@@ -100,16 +114,10 @@ static void create_snapshot( const graphene::chain::database& db, const fc::path
    for( uint32_t space_id = 0; space_id < 256; space_id++ )
       for( uint32_t type_id = 0; type_id < 256; type_id++ )
       {
-         try
-         {
-            db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         }
-         catch (fc::assert_exception e)
-         {
+         const auto* index = db.find_index( (uint8_t)space_id, (uint8_t)type_id );
+         if( index == nullptr )
             continue;
-         }
-         auto& index = db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         index.inspect_all_objects( [&out]( const graphene::db::object& o ) {
+         index->inspect_all_objects( [&out]( const graphene::db::object& o ) {
             out << fc::json::to_string( o.to_variant() ) << '\n';
          });
       }
@@ -122,7 +130,22 @@ void snapshot_plugin::check_snapshot( const graphene::chain::signed_block& b )
     uint32_t current_block = b.block_num();
     if( (last_block < snapshot_block && snapshot_block <= current_block)
            || (last_time < snapshot_time && snapshot_time <= b.timestamp) )
-       create_snapshot( database(), dest );
+    {
+       if( json_format )
+          create_json_snapshot( database(), dest );
+       else
+       {
+          ilog("snapshot plugin: creating binary snapshot");
+          try
+          {
+             database().export_snapshot( b, dest, threads );
+          }
+          catch( const fc::exception& e )
+          {
+             wlog( "Failed to create snapshot: ${ex}", ("ex",e) );
+          }
+       }
+    }
     last_block = current_block;
     last_time = b.timestamp;
 } FC_LOG_AND_RETHROW() }
@@ -24,11 +24,16 @@
 #include <graphene/utilities/elasticsearch.hpp>
 
 #include <boost/algorithm/string/join.hpp>
+#include <fc/exception/exception.hpp>
 #include <fc/log/logger.hpp>
 
+#include <chrono>
+#include <sstream>
+
 namespace graphene { namespace utilities {
 
-bool SendBulk(CURL *curl, std::vector<std::string>& bulk, std::string elasticsearch_url, bool do_logs, std::string logs_index)
+bool SendBulk(CURL *curl, std::vector<std::string>& bulk, std::string elasticsearch_url, bool do_logs, std::string logs_index,
+              uint32_t connect_timeout_ms, uint32_t request_timeout_ms)
 {
   // curl buffers to read
   std::string readBuffer;
@@ -50,6 +55,8 @@ bool SendBulk(CURL *curl, std::vector<std::string>& bulk, std::string elasticsea
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&readBuffer);
   curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcrp/0.1");
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long)connect_timeout_ms);
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)request_timeout_ms);
   //curl_easy_setopt(curl, CURLOPT_VERBOSE, true);
   curl_easy_perform(curl);
 
@@ -119,5 +126,254 @@ std::vector<std::string> createBulk(std::string index_name, std::string data, st
    return bulk;
 }
 
+es_bulk_sender::es_bulk_sender( const options& o )
+   : _options( o )
+{
+   FC_ASSERT( _options.max_queued_batches > 0 );
+   _curl = curl_easy_init();
+   FC_ASSERT( _curl, "Unable to initialize curl" );
+   // the timeouts stay set on the handle for every request; without signals, as they would hit other threads
+   curl_easy_setopt( _curl, CURLOPT_NOSIGNAL, 1L );
+   curl_easy_setopt( _curl, CURLOPT_CONNECTTIMEOUT_MS, (long)_options.connect_timeout_ms );
+   curl_easy_setopt( _curl, CURLOPT_TIMEOUT_MS, (long)_options.request_timeout_ms );
+   if( !_options.spool_file.empty() )
+   {
+      // a spool left over by a previous run is sent first
+      _spool.open( _options.spool_file.c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::app );
+      FC_ASSERT( _spool.is_open(), "Unable to open spool file ${f}", ("f",_options.spool_file) );
+      _spool.seekg( 0, _spool.end );
+      _spool_size = _spool.tellg();
+      _stats.spooled_bytes = _spool_size;
+   }
+   _thread = std::thread( [this](){ run(); } );
+}
+
+es_bulk_sender::~es_bulk_sender()
+{
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _stopping = true;
+   }
+   _cv.notify_all();
+   _thread.join();
+
+   if( !_queue.empty() )
+   {
+      if( _spool.is_open() )
+      {
+         // the spool must keep the order, so memory batches go in front of the unsent spool tail
+         std::string tail;
+         if( _spool_read_pos < _spool_size )
+         {
+            tail.resize( _spool_size - _spool_read_pos );
+            _spool.seekg( _spool_read_pos );
+            _spool.read( &tail[0], tail.size() );
+         }
+         _spool.close();
+         _spool.open( _options.spool_file.c_str(), std::fstream::binary | std::fstream::out | std::fstream::trunc );
+         _spool_read_pos = _spool_size = 0;
+         for( const batch& b : _queue )
+            spool( b );
+         _spool.write( tail.data(), tail.size() );
+         ilog( "Spooled ${n} unsent Elasticsearch bulks to ${f}", ("n",_queue.size())("f",_options.spool_file) );
+      }
+      else
+         elog( "Dropping ${n} unsent Elasticsearch bulks", ("n",_queue.size()) );
+   }
+   if( _spool.is_open() )
+      _spool.close();
+   curl_easy_cleanup( _curl );
+}
+
+void es_bulk_sender::send( std::vector<std::string>& bulk )
+{
+   if( bulk.empty() )
+      return;
+   batch b;
+   b.lines = bulk.size();
+   b.body = boost::algorithm::join( bulk, "\n" ) + "\n";
+   bulk.clear();
+
+   std::unique_lock<std::mutex> lock( _mutex );
+   if( _spool.is_open() )
+   {
+      // once anything is spooled, later batches follow it to keep the order
+      if( _spool_size > _spool_read_pos || _queue.size() >= _options.max_queued_batches )
+      {
+         spool( b );
+         lock.unlock();
+         _cv.notify_all();
+         return;
+      }
+   }
+   else if( _queue.size() >= _options.max_queued_batches )
+   {
+      wlog( "Elasticsearch bulk queue is full, waiting for the sender" );
+      _cv.wait( lock, [this](){ return _queue.size() < _options.max_queued_batches || _stopping; } );
+   }
+   _stats.queued_batches++;
+   _stats.queued_lines += b.lines;
+   _queue.push_back( std::move(b) );
+   lock.unlock();
+   _cv.notify_all();
+}
+
+void es_bulk_sender::spool( const batch& b )
+{
+   const uint32_t size = b.body.size();
+   _spool.seekp( 0, _spool.end );
+   _spool.write( (const char*)&b.lines, sizeof(b.lines) );
+   _spool.write( (const char*)&size, sizeof(size) );
+   _spool.write( b.body.data(), size );
+   _spool.flush();
+   _spool_size += sizeof(b.lines) + sizeof(size) + size;
+   _stats.spooled_bytes = _spool_size - _spool_read_pos;
+}
+
+bool es_bulk_sender::next_batch( batch& b )
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( true )
+   {
+      _cv.wait( lock, [this](){ return _stopping || !_queue.empty() || _spool_size > _spool_read_pos; } );
+      if( _stopping )
+         return false;
+      if( !_queue.empty() )
+      {
+         b = _queue.front();
+         _from_spool = false;
+         return true;
+      }
+      uint32_t size = 0;
+      _spool.seekg( _spool_read_pos );
+      _spool.read( (char*)&b.lines, sizeof(b.lines) );
+      _spool.read( (char*)&size, sizeof(size) );
+      b.body.resize( size );
+      if( _spool )
+         _spool.read( &b.body[0], size );
+      if( _spool )
+      {
+         _from_spool = true;
+         return true;
+      }
+      elog( "Discarding corrupted tail of Elasticsearch spool ${f}", ("f",_options.spool_file) );
+      _spool.close();
+      _spool.open( _options.spool_file.c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc );
+      _spool_read_pos = _spool_size = 0;
+      _stats.spooled_bytes = 0;
+   }
+}
+
+void es_bulk_sender::batch_sent( const batch& b )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _stats.sent_batches++;
+   _stats.sent_lines += b.lines;
+   if( !_from_spool )
+   {
+      _queue.pop_front();
+      _stats.queued_batches--;
+      _stats.queued_lines -= b.lines;
+   }
+   else
+   {
+      _spool_read_pos += 2 * sizeof(uint32_t) + b.body.size();
+      if( _spool_read_pos >= _spool_size )
+      {
+         // fully drained, start over with an empty file
+         _spool.close();
+         _spool.open( _options.spool_file.c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc );
+         _spool_read_pos = _spool_size = 0;
+      }
+      _stats.spooled_bytes = _spool_size - _spool_read_pos;
+   }
+   _cv.notify_all();
+}
+
+void es_bulk_sender::run()
+{
+   batch b;
+   while( next_batch( b ) )
+   {
+      uint32_t backoff = _options.initial_backoff_ms;
+      bool sent = post( b );
+      while( !sent )
+      {
+         {
+            std::unique_lock<std::mutex> lock( _mutex );
+            _stats.failed_requests++;
+            if( _cv.wait_for( lock, std::chrono::milliseconds( backoff ), [this](){ return _stopping; } ) )
+               return;
+         }
+         backoff = std::min( backoff * 2, _options.max_backoff_ms );
+         sent = post( b );
+      }
+      batch_sent( b );
+   }
+}
+
+bool es_bulk_sender::post( const batch& b )
+{
+   std::string reply;
+   struct curl_slist *headers = NULL;
+   headers = curl_slist_append(headers, "Content-Type: application/json");
+   std::string url = _options.url + "_bulk";
+   curl_easy_setopt(_curl, CURLOPT_URL, url.c_str());
+   curl_easy_setopt(_curl, CURLOPT_POST, true);
+   curl_easy_setopt(_curl, CURLOPT_HTTPHEADER, headers);
+   curl_easy_setopt(_curl, CURLOPT_POSTFIELDS, b.body.c_str());
+   curl_easy_setopt(_curl, CURLOPT_POSTFIELDSIZE, (long)b.body.size());
+   curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+   curl_easy_setopt(_curl, CURLOPT_WRITEDATA, (void *)&reply);
+   curl_easy_setopt(_curl, CURLOPT_USERAGENT, "libcrp/0.1");
+   CURLcode res = curl_easy_perform(_curl);
+
+   long http_code = 0;
+   curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, &http_code);
+   if( res != CURLE_OK || http_code != 200 )
+   {
+      if( http_code == 413 )
+         elog("413 error: Can be low space disk");
+      else
+         elog("Elasticsearch bulk request failed, curl code ${c}, http code ${h}", ("c",(int)res)("h",http_code));
+      curl_slist_free_all(headers);
+      return false;
+   }
+
+   if( _options.do_logs )
+   {
+      // logging the reply is best effort, a failure here does not resend the bulk
+      std::string reply_logs;
+      std::string url_logs = _options.url + _options.logs_index + "/data/";
+      curl_easy_setopt(_curl, CURLOPT_URL, url_logs.c_str());
+      curl_easy_setopt(_curl, CURLOPT_POSTFIELDS, reply.c_str());
+      curl_easy_setopt(_curl, CURLOPT_POSTFIELDSIZE, (long)reply.size());
+      curl_easy_setopt(_curl, CURLOPT_WRITEDATA, (void *)&reply_logs);
+      curl_easy_perform(_curl);
+   }
+   curl_slist_free_all(headers);
+   return true;
+}
+
+es_bulk_sender_stats es_bulk_sender::get_stats()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _stats;
+}
+
+std::string es_bulk_sender::to_prometheus_text( const std::string& prefix )const
+{
+   const es_bulk_sender_stats stats = get_stats();
+   std::ostringstream out;
+   out << "# TYPE " << prefix << "_queued_batches gauge\n" << prefix << "_queued_batches " << stats.queued_batches << "\n";
+   out << "# TYPE " << prefix << "_queued_lines gauge\n" << prefix << "_queued_lines " << stats.queued_lines << "\n";
+   out << "# TYPE " << prefix << "_spooled_bytes gauge\n" << prefix << "_spooled_bytes " << stats.spooled_bytes << "\n";
+   out << "# TYPE " << prefix << "_sent_batches_total counter\n"
+       << prefix << "_sent_batches_total " << stats.sent_batches << "\n";
+   out << "# TYPE " << prefix << "_sent_lines_total counter\n" << prefix << "_sent_lines_total " << stats.sent_lines << "\n";
+   out << "# TYPE " << prefix << "_failed_requests_total counter\n"
+       << prefix << "_failed_requests_total " << stats.failed_requests << "\n";
+   return out.str();
+}
 
 } } // end namespace graphene::utilities
@@ -22,8 +22,13 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <curl/curl.h>
@@ -36,7 +41,81 @@ static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *use
 
 namespace graphene { namespace utilities {
 
-   bool SendBulk(CURL *curl, std::vector <std::string>& bulk, std::string elasticsearch_url, bool do_logs, std::string logs_index);
+   bool SendBulk(CURL *curl, std::vector <std::string>& bulk, std::string elasticsearch_url, bool do_logs, std::string logs_index,
+                 uint32_t connect_timeout_ms = 5000, uint32_t request_timeout_ms = 30000);
    std::vector<std::string> createBulk(std::string type, std::string data, std::string id, bool onlycreate);
 
+   struct es_bulk_sender_stats
+   {
+      uint64_t queued_batches = 0;
+      uint64_t queued_lines = 0;
+      uint64_t spooled_bytes = 0;
+      uint64_t sent_batches = 0;
+      uint64_t sent_lines = 0;
+      uint64_t failed_requests = 0;
+   };
+
+   /**
+    * @brief Sends bulk requests to Elasticsearch from a dedicated thread
+    *
+    * Producers hand over whole bulks and continue immediately. The bulks are sent in order. A failed request is
+    * retried with exponential backoff until it succeeds, so an Elasticsearch outage never stalls the caller. Once
+    * max_queued_batches bulks are waiting, new bulks are appended to the spool file and sent from there after the
+    * queue drains. Without a spool file the producer blocks until the queue has room again. Bulks left over at
+    * shutdown are spooled and resent after restart, so delivery is at least once. Requests time out, so that a
+    * hung node can neither stall the sender thread nor the shutdown, which waits for the request in progress.
+    */
+   class es_bulk_sender
+   {
+      public:
+         struct options
+         {
+            std::string url;                   ///< Elasticsearch node url, ending with '/'
+            bool        do_logs = false;       ///< post every bulk reply to logs_index
+            std::string logs_index;
+            uint32_t    max_queued_batches = 64;
+            std::string spool_file;            ///< empty to block producers when the queue is full
+            uint32_t    initial_backoff_ms = 100;
+            uint32_t    max_backoff_ms = 30000;
+            uint32_t    connect_timeout_ms = 5000;  ///< 0 for the default of curl
+            uint32_t    request_timeout_ms = 30000; ///< limit for a whole request including the reply, 0 for none
+         };
+
+         explicit es_bulk_sender( const options& o );
+         ~es_bulk_sender();
+
+         /// Queue the lines of a bulk request for sending, @p bulk is left empty
+         void send( std::vector<std::string>& bulk );
+
+         es_bulk_sender_stats get_stats()const;
+         /// @return the stats in Prometheus text format, metric names start with @p prefix
+         std::string to_prometheus_text( const std::string& prefix )const;
+
+      private:
+         struct batch
+         {
+            std::string body;
+            uint32_t    lines = 0;
+         };
+
+         void run();
+         bool post( const batch& b );
+         bool next_batch( batch& b );
+         void batch_sent( const batch& b );
+         void spool( const batch& b );
+
+         const options                  _options;
+         CURL*                          _curl = nullptr;
+         mutable std::mutex             _mutex;
+         std::condition_variable        _cv;
+         std::deque<batch>              _queue;
+         std::fstream                   _spool;
+         uint64_t                       _spool_read_pos = 0;
+         uint64_t                       _spool_size = 0;
+         bool                           _from_spool = false; ///< the batch being sent was read from the spool
+         bool                           _stopping = false;
+         es_bulk_sender_stats           _stats;
+         std::thread                    _thread;
+   };
+
 } } // end namespace graphene::utilities
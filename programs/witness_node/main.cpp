@@ -33,6 +33,7 @@
 #include <graphene/snapshot/snapshot.hpp>
 #include <graphene/es_objects/es_objects.hpp>
 #include <graphene/grouped_orders/grouped_orders_plugin.hpp>
+#include <graphene/khc_financing/khc_financing_plugin.hpp>
 #include <graphene/khc/config.hpp>
 
 #include <fc/exception/exception.hpp>
@@ -203,6 +204,7 @@ int main(int argc, char** argv) {
       auto snapshot_plug = node->register_plugin<snapshot_plugin::snapshot_plugin>();
       auto es_objects_plug = node->register_plugin<es_objects::es_objects_plugin>();
       auto grouped_orders_plug = node->register_plugin<grouped_orders::grouped_orders_plugin>();
+      auto khc_financing_plug = node->register_plugin<khc_financing::khc_financing_plugin>();
 
       try
       {
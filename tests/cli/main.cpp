@@ -34,6 +34,7 @@
 
 #include <fc/thread/thread.hpp>
 #include <fc/smart_ref_impl.hpp>
+#include <fc/io/json.hpp>
 #include <fc/network/http/websocket.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/rpc/cli.hpp>
@@ -388,3 +389,70 @@ BOOST_AUTO_TEST_CASE( cli_set_voting_proxy )
    }
    app1->shutdown();
 }
+
+///////////////////////
+// Send JSON-RPC batches over a raw websocket and check that every reply is valid JSON
+///////////////////////
+BOOST_AUTO_TEST_CASE( cli_batch_request_errors )
+{
+   std::shared_ptr<graphene::app::application> app1;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+
+      app1 = std::make_shared<graphene::app::application>();
+      app1->register_plugin<graphene::account_history::account_history_plugin>();
+      app1->startup_plugins();
+      boost::program_options::variables_map cfg;
+      const int server_port_number = get_available_port();
+      cfg.emplace("rpc-endpoint", boost::program_options::variable_value(string("127.0.0.1:" + std::to_string(server_port_number)), false));
+      cfg.emplace("genesis-json", boost::program_options::variable_value(create_genesis_file(app_dir), false));
+      cfg.emplace("seed-nodes", boost::program_options::variable_value(string("[]"), false));
+      cfg.emplace("rpc-max-batch-size", boost::program_options::variable_value(uint32_t(3), false));
+      app1->initialize(app_dir.path(), cfg);
+      app1->startup();
+      fc::usleep(fc::milliseconds(500));
+
+      fc::http::websocket_client client;
+      fc::http::websocket_connection_ptr connection = client.connect( "ws://127.0.0.1:" + std::to_string(server_port_number) );
+      std::vector<std::string> replies;
+      connection->on_message_handler( [&]( const std::string& msg ){ replies.push_back( msg ); } );
+      auto send = [&]( const std::string& msg ) {
+         replies.clear();
+         connection->send_message( msg );
+         for( int i = 0; i < 500 && replies.empty(); ++i )
+            fc::usleep( fc::milliseconds(10) );
+         BOOST_REQUIRE_EQUAL( replies.size(), 1u );
+         return fc::json::from_string( replies[0] );
+      };
+      const std::string login = "{\"id\":1,\"method\":\"call\",\"params\":[1,\"login\",[\"\",\"\"]]}";
+
+      BOOST_TEST_MESSAGE( "A batch element which is not an object" );
+      fc::variant reply = send( "[1," + login + "]" );
+      BOOST_REQUIRE( reply.is_array() );
+      BOOST_REQUIRE_EQUAL( reply.get_array().size(), 2u );
+      const fc::variant_object& invalid = reply.get_array()[0].get_object();
+      BOOST_CHECK( invalid["id"].is_null() );
+      BOOST_CHECK_EQUAL( invalid["error"].get_object()["code"].as_int64(), -32600 );
+      BOOST_CHECK( reply.get_array()[1].get_object()["result"].as_bool() );
+
+      BOOST_TEST_MESSAGE( "An empty batch" );
+      reply = send( "[]" );
+      BOOST_REQUIRE( reply.is_object() );
+      BOOST_CHECK( reply.get_object()["id"].is_null() );
+      BOOST_CHECK_EQUAL( reply.get_object()["error"].get_object()["code"].as_int64(), -32600 );
+
+      BOOST_TEST_MESSAGE( "A batch above rpc-max-batch-size" );
+      reply = send( "[" + login + "," + login + "," + login + "," + login + "]" );
+      BOOST_REQUIRE( reply.is_object() );
+      BOOST_CHECK_EQUAL( reply.get_object()["error"].get_object()["code"].as_int64(), -32600 );
+
+      BOOST_TEST_MESSAGE( "A batch which is not valid JSON" );
+      reply = send( "[" + login );
+      BOOST_REQUIRE( reply.is_object() );
+      BOOST_CHECK_EQUAL( reply.get_object()["error"].get_object()["code"].as_int64(), -32700 );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+   app1->shutdown();
+}
@@ -27,6 +27,7 @@
 #include <graphene/account_history/account_history_plugin.hpp>
 #include <graphene/market_history/market_history_plugin.hpp>
 #include <graphene/grouped_orders/grouped_orders_plugin.hpp>
+#include <graphene/khc_financing/khc_financing_plugin.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
@@ -76,6 +77,7 @@ database_fixture::database_fixture()
    auto ahplugin = app.register_plugin<graphene::account_history::account_history_plugin>();
    auto mhplugin = app.register_plugin<graphene::market_history::market_history_plugin>();
    auto goplugin = app.register_plugin<graphene::grouped_orders::grouped_orders_plugin>();
+   auto kfplugin = app.register_plugin<graphene::khc_financing::khc_financing_plugin>();
    init_account_pub_key = init_account_priv_key.get_public_key();
 
    boost::program_options::variables_map options;
@@ -126,6 +128,17 @@ database_fixture::database_fixture()
       options.insert(std::make_pair("track-account", boost::program_options::variable_value(track_account, false)));
    }
 
+   // compact account history storage with trimming
+   if( boost::unit_test::framework::current_test_case().p_name.value == "compact_account_history"
+         || boost::unit_test::framework::current_test_case().p_name.value == "cold_account_history" ) {
+      options.insert(std::make_pair("compact-account-history", boost::program_options::variable_value(true, false)));
+      options.insert(std::make_pair("max-ops-per-account", boost::program_options::variable_value((uint32_t)70, false)));
+   }
+   if( boost::unit_test::framework::current_test_case().p_name.value == "cold_account_history" ) {
+      boost::filesystem::path cold_dir( ( data_dir->path() / "cold_history" ).generic_string() );
+      options.insert(std::make_pair("history-cold-store-dir", boost::program_options::variable_value(cold_dir, false)));
+   }
+
    ahplugin->plugin_set_app(&app);
    ahplugin->plugin_initialize(options);
 
@@ -136,9 +149,14 @@ database_fixture::database_fixture()
    goplugin->plugin_set_app(&app);
    goplugin->plugin_initialize(options);
 
+   options.insert(std::make_pair("financing-bucket-size", boost::program_options::variable_value(string("[3600]"),false)));
+   kfplugin->plugin_set_app(&app);
+   kfplugin->plugin_initialize(options);
+
    ahplugin->plugin_startup();
    mhplugin->plugin_startup();
    goplugin->plugin_startup();
+   kfplugin->plugin_startup();
 
    generate_block();
 
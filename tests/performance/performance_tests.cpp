@@ -28,15 +28,43 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/market_evaluator.hpp>
+#include <graphene/chain/transfer_evaluator.hpp>
+#include <graphene/chain/financing_evaluator.hpp>
+#include <graphene/khc/config.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
 
+namespace {
+   /// every heap allocation made by this program, see operation_allocation_test
+   std::atomic<uint64_t> allocation_count( 0 );
+}
+
+void* operator new( std::size_t size )
+{
+   ++allocation_count;
+   if( void* p = std::malloc( size > 0 ? size : 1 ) )
+      return p;
+   throw std::bad_alloc();
+}
+void* operator new[]( std::size_t size ) { return operator new( size ); }
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete[]( void* p ) noexcept { std::free( p ); }
+
 //BOOST_FIXTURE_TEST_SUITE( performance_tests, database_fixture )
 
 BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
@@ -51,6 +79,273 @@ BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
    auto elapsed = end-start;
    wdump( ((100000.0*1000000.0) / elapsed.count()) );
 }
+BOOST_AUTO_TEST_CASE( block_serialization_benchmark )
+{
+   fc::ecc::private_key nathan_key = fc::ecc::private_key::generate();
+   signed_block blk;
+   for( uint32_t i = 0; i < 1000; ++i )
+   {
+      signed_transaction trx;
+      transfer_operation op;
+      op.from = account_id_type(i);
+      op.to = account_id_type(i+1);
+      op.amount = asset(1000+i);
+      trx.operations.push_back( op );
+      trx.expiration = fc::time_point_sec( 1500000000 + i );
+      trx.sign( nathan_key, chain_id_type() );
+      blk.transactions.emplace_back( trx );
+   }
+
+   const uint32_t rounds = 100;
+   uint64_t json_bytes = 0;
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < rounds; ++i )
+      json_bytes += fc::json::to_string( fc::variant( blk, GRAPHENE_MAX_NESTED_OBJECTS ) ).size();
+   auto json_elapsed = fc::time_point::now() - start;
+
+   uint64_t raw_bytes = 0;
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < rounds; ++i )
+      raw_bytes += fc::raw::pack( blk ).size();
+   auto raw_elapsed = fc::time_point::now() - start;
+
+   // the binary transport hex encodes the packed block, so it costs twice the packed size on the wire
+   auto json_blocks_per_sec = ( rounds * 1000000.0 ) / json_elapsed.count();
+   auto raw_blocks_per_sec = ( rounds * 1000000.0 ) / raw_elapsed.count();
+   auto json_block_size = json_bytes / rounds;
+   auto raw_block_size = 2 * raw_bytes / rounds;
+   wdump( (json_blocks_per_sec)(raw_blocks_per_sec)(json_block_size)(raw_block_size) );
+}
+
+BOOST_FIXTURE_TEST_CASE( market_history_fill_benchmark, graphene::chain::database_fixture )
+{ try {
+   ACTORS( (maker)(taker) );
+   const asset_object& test = create_user_issued_asset( "UIATEST" );
+   const asset_object& core = asset_id_type()(db);
+   transfer( committee_account, maker_id, asset( 100000000 ) );
+   issue_uia( taker, test.amount( 100000000 ) );
+
+   // every block fills a few hundred maker orders of one market at different prices
+   const uint32_t blocks = 20;
+   const uint32_t fills_per_block = 250;
+   fc::microseconds elapsed;
+   for( uint32_t b = 0; b < blocks; ++b )
+   {
+      share_type test_total = 0;
+      for( uint32_t i = 0; i < fills_per_block; ++i )
+      {
+         create_sell_order( maker, core.amount(10), test.amount(10 + i % 7) );
+         test_total += 10 + i % 7;
+      }
+      create_sell_order( taker, test.amount(test_total), core.amount(1) );
+      auto start = fc::time_point::now();
+      generate_block();
+      elapsed += fc::time_point::now() - start;
+   }
+   auto fills_per_sec = ( 2.0 * blocks * fills_per_block * 1000000.0 ) / elapsed.count();
+   wdump( (blocks)(fills_per_block)(elapsed)(fills_per_sec) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE( grouped_orders_churn_benchmark, graphene::chain::database_fixture )
+{ try {
+   // orders are created, partially filled and cancelled directly in the object database, so that the time is
+   // dominated by the secondary indexes on limit orders, including the one of the grouped_orders plugin
+   const asset_id_type test_id = create_user_issued_asset( "UIATEST" ).id;
+   const uint32_t rounds = 20000;
+   const uint32_t live_orders = 1000;
+   std::deque<limit_order_id_type> orders;
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < rounds; ++i )
+   {
+      orders.push_back( db.create<limit_order_object>( [&]( limit_order_object& o ) {
+         o.seller = account_id_type();
+         o.for_sale = 100000;
+         o.sell_price = asset( 100000 ) / asset( 100000 + ( i * 7919 ) % 5000, test_id );
+         o.expiration = time_point_sec::maximum();
+      }).id );
+      db.modify( orders.back()(db), []( limit_order_object& o ) {
+         o.for_sale -= 1000;
+      });
+      if( orders.size() > live_orders )
+      {
+         db.remove( orders.front()(db) );
+         orders.pop_front();
+      }
+   }
+   auto elapsed = fc::time_point::now() - start;
+   auto operations_per_sec = ( 3.0 * rounds * 1000000.0 ) / elapsed.count();
+   wdump( (rounds)(live_orders)(elapsed)(operations_per_sec) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE( operation_allocation_test, graphene::chain::database_fixture )
+{ try {
+   ACTORS( (alice)(bob)(feeder) );
+   const asset_id_type test_id = create_user_issued_asset( "UIATEST" ).id;
+   const asset_object& khd = create_bitasset( "KHD", feeder_id );
+   const asset_id_type khd_id = khd.id;
+   const asset_id_type project_id = create_user_issued_asset( "PROJECT" ).id;
+   transfer( committee_account, alice_id, asset( 100000000 ) );
+   update_feed_producers( khd, {feeder_id} );
+   price_feed feed;
+   feed.settlement_price = khd.amount( 1 ) / asset( 1 );
+   feed.maintenance_collateral_ratio = 1750;
+   publish_feed( khd, feeder, feed );
+   borrow( alice, khd.amount( 1000000 ), asset( 10000000 ) );
+   generate_block();
+   db.modify( project_id( db ), [&]( asset_object& a ) {
+      a.proj_options.name = "project";
+      a.proj_options.financing_type = KHC_PUBLIC_OFFERING;
+      a.proj_options.min_financing_amount = 1;
+      a.proj_options.max_financing_amount = GRAPHENE_MAX_SHARE_SUPPLY;
+      a.proj_options.start_financing_block_num = 0;
+      a.proj_options.end_financing_block_num = db.head_block_num() + 1000;
+   });
+
+   // operations are applied directly with the undo history disabled, as during a replay, so that only the
+   // allocations of the evaluators and the objects they create are counted
+   db._undo_db.disable();
+   transaction_evaluation_state eval_state( &db );
+   // debug logging formats its arguments on the heap
+   fc::logger khc_logger = fc::logger::get( "khc" );
+   const fc::log_level khc_level = khc_logger.get_log_level();
+   khc_logger.set_log_level( fc::log_level::warn );
+
+   // every operation adds an entry to the applied operations of the block, which is a vector; it has grown to 16384
+   // entries after the warm-up, enough for all operations applied below
+   transfer_operation xfer;
+   xfer.from = alice_id;
+   xfer.to = bob_id;
+   xfer.amount = asset( 1 );
+   for( uint32_t i = 0; i < 10000; ++i )
+      db.apply_operation( eval_state, xfer );
+
+   // applies op the given number of times after a short warm-up, @return the number of allocations while measuring
+   const uint32_t rounds = 1000;
+   auto count_allocations = [&]( const operation& op ) {
+      for( uint32_t i = 0; i < 10; ++i )
+         db.apply_operation( eval_state, op );
+      const uint64_t before = allocation_count;
+      for( uint32_t i = 0; i < rounds; ++i )
+         db.apply_operation( eval_state, op );
+      return allocation_count - before;
+   };
+
+   const uint64_t transfer_allocations = count_allocations( xfer );
+   BOOST_CHECK_EQUAL( transfer_allocations, 0u );
+
+   // creating an order allocates its node in the limit order index, which is the only allocation allowed. The resting
+   // order keeps the order groups of its price alive, so that the grouped orders plugin does not add and erase them.
+   limit_order_create_operation create;
+   create.seller = alice_id;
+   create.amount_to_sell = asset( 10 );
+   create.min_to_receive = asset( 10, test_id );
+   create.expiration = time_point_sec::maximum();
+   db.apply_operation( eval_state, create );
+   limit_order_cancel_operation cancel;
+   cancel.fee_paying_account = alice_id;
+   uint64_t before = allocation_count;
+   for( uint32_t i = 0; i < rounds; ++i )
+   {
+      cancel.order = db.apply_operation( eval_state, create ).get<object_id_type>();
+      db.apply_operation( eval_state, cancel );
+   }
+   const uint64_t order_allocations = allocation_count - before;
+   BOOST_CHECK_EQUAL( order_allocations, rounds );
+
+   // every investment allocates the node of its asset_investment_object
+   asset_investment_operation invest;
+   invest.account_id = alice_id;
+   invest.investment_asset_id = project_id;
+   invest.amount = asset( 1, khd_id );
+   const uint64_t investment_allocations = count_allocations( invest );
+   BOOST_CHECK_EQUAL( investment_allocations, rounds );
+
+   // the converted power is added to the account_power_object created by the warm-up
+   power_convert_operation convert;
+   convert.account = alice_id;
+   convert.amount = asset( 1000 );
+   convert.refer_amount = asset( 0, khd_id );
+   const uint64_t convert_allocations = count_allocations( convert );
+   BOOST_CHECK_EQUAL( convert_allocations, 0u );
+
+   khc_logger.set_log_level( khc_level );
+
+   // give the invested KHD back, the supply check of the fixture does not count investments
+   db.modify( project_id( db ).dynamic_asset_data_id( db ), []( asset_dynamic_data_object& d ) {
+      d.state = asset_dynamic_data_object::project_state::financing_failue;
+   });
+   refund_investment_operation refund;
+   refund.account_id = alice_id;
+   refund.investment_asset_id = project_id;
+   db.apply_operation( eval_state, refund );
+   db._undo_db.enable();
+
+   wdump( (rounds)(transfer_allocations)(order_allocations)(investment_allocations)(convert_allocations) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE( evaluator_reuse_benchmark, graphene::chain::database_fixture )
+{ try {
+   ACTORS( (alice) );
+   const asset_id_type project_id = create_user_issued_asset( "PROJECT" ).id;
+   generate_block();
+   db._undo_db.disable();
+   transaction_evaluation_state eval_state( &db );
+
+   // alice holds many investments in a project which has issued its tokens, so every claim collects them into the
+   // investment_objects buffer of the evaluator
+   const uint32_t investments = 64;
+   db.modify( project_id( db ), []( asset_object& a ) {
+      a.proj_options.name = "project";
+      a.proj_options.financing_type = KHC_PUBLIC_OFFERING;
+   });
+   db.modify( project_id( db ).dynamic_asset_data_id( db ), [&]( asset_dynamic_data_object& d ) {
+      d.state = asset_dynamic_data_object::project_state::project_in_progress;
+      d.investment_confidential_supply = investments;
+      d.investment_current_supply = investments;
+   });
+   for( uint32_t i = 0; i < investments; ++i )
+      db.create<asset_investment_object>( [&]( asset_investment_object& o ) {
+         o.investment_account_id = alice_id;
+         o.investment_asset_id = project_id;
+         o.investment_tokens = 1;
+         o.has_receive_token = false;
+      });
+
+   claim_asset_investment_operation claim;
+   claim.account_id = alice_id;
+   claim.asset_id = project_id;
+   const operation op( claim );
+   const uint32_t rounds = 100000;
+
+   // the claim is only evaluated, so that it can be repeated
+   uint64_t before = allocation_count;
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < rounds; ++i )
+   {
+      claim_asset_investment_evaluator eval;
+      eval.start_evaluate( eval_state, op, false );
+   }
+   const auto fresh_elapsed = fc::time_point::now() - start;
+   const uint64_t fresh_allocations = allocation_count - before;
+
+   op_evaluator_impl<claim_asset_investment_evaluator> reused;
+   reused.evaluate( eval_state, op, false );
+   before = allocation_count;
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < rounds; ++i )
+      reused.evaluate( eval_state, op, false );
+   const auto reused_elapsed = fc::time_point::now() - start;
+   const uint64_t reused_allocations = allocation_count - before;
+   db._undo_db.enable();
+
+   BOOST_CHECK( fresh_allocations >= rounds );
+   BOOST_CHECK_EQUAL( reused_allocations, 0u );
+
+   const double fresh_ops_per_sec = ( rounds * 1000000.0 ) / fresh_elapsed.count();
+   const double reused_ops_per_sec = ( rounds * 1000000.0 ) / reused_elapsed.count();
+   wdump( (rounds)(investments)(fresh_allocations)(fresh_ops_per_sec)(reused_ops_per_sec) );
+} FC_LOG_AND_RETHROW() }
+
 /*
 BOOST_AUTO_TEST_CASE( transfer_benchmark )
 {
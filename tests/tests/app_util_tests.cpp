@@ -24,7 +24,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/api.hpp>
 #include <graphene/app/util.hpp>
+#include <graphene/app/api_admission_control.hpp>
+#include <graphene/app/api_metrics.hpp>
+#include <graphene/app/block_export.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -242,4 +246,148 @@ BOOST_AUTO_TEST_CASE(price_to_string_test) {
 
 }
 
+BOOST_AUTO_TEST_CASE(api_metrics_test) {
+
+   histogram h;
+   h.record( 0 );
+   h.record( 1 );
+   h.record( 3 );
+   h.record( 1000000000 );
+   BOOST_CHECK_EQUAL( h.count(), 4u );
+   BOOST_CHECK_EQUAL( h.sum(), 1000000004u );
+   BOOST_CHECK_EQUAL( h.cumulative_count( 0 ), 2u );
+   BOOST_CHECK_EQUAL( h.cumulative_count( 1 ), 3u );
+   BOOST_CHECK_EQUAL( h.cumulative_count( histogram::bucket_count - 1 ), 3u );
+
+   api_metrics metrics;
+   metrics.record_call( "get_objects", fc::microseconds( 10 ), 50, 1000 );
+   metrics.record_call( "get_objects", fc::microseconds( 20 ), 50, 3000 );
+   metrics.record_rejected_call( "get all \"holders\"" );
+   metrics.record_block_applied();
+
+   const std::string text = metrics.to_prometheus_text( db );
+   BOOST_CHECK( text.find( "graphene_api_call_duration_microseconds_count{method=\"get_objects\"} 2\n" ) != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_api_call_duration_microseconds_sum{method=\"get_objects\"} 30\n" ) != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_api_request_bytes_total{method=\"get_objects\"} 100\n" ) != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_api_rejected_calls_total{method=\"get_all__holders_\"} 1\n" ) != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_blocks_applied_total 1\n" ) != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_head_block_number " + std::to_string( db.head_block_num() ) + "\n" ) != std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE(api_admission_control_test) {
+
+   api_cost_limits limits;
+   limits.tokens_per_second = 1;
+   limits.burst = 3;
+   limits.max_concurrent_calls_per_connection = 2;
+   limits.max_concurrent_calls = 3;
+   limits.method_costs["get_all_asset_holders"] = 2;
+   limits.method_costs["list_asset_investment"] = 100;
+   BOOST_CHECK( limits.enabled() );
+   BOOST_CHECK( !api_cost_limits().enabled() );
+
+   auto global = std::make_shared<api_admission_control>( limits );
+   BOOST_CHECK_EQUAL( global->method_cost( "get_objects" ), 1u );
+   BOOST_CHECK_EQUAL( global->method_cost( "get_all_asset_holders" ), 2u );
+   BOOST_CHECK_EQUAL( global->method_cost( "list_asset_investment" ), 100u ); // the node clamps at startup
+
+   // token bucket
+   api_session_limiter session1( global );
+   BOOST_CHECK( session1.admit( "list_asset_investment" ).valid() );
+   BOOST_CHECK( !session1.admit( "get_objects" ).valid() );
+   session1.release();
+   BOOST_CHECK( !session1.admit( "get_all_asset_holders" ).valid() );
+   session1.release();
+   BOOST_CHECK( session1.admit( "get_all_asset_holders" ).valid() );
+
+   // per connection concurrency
+   api_session_limiter session2( global );
+   BOOST_CHECK( !session2.admit( "get_objects" ).valid() );
+   BOOST_CHECK( !session2.admit( "get_objects" ).valid() );
+   BOOST_CHECK( session2.admit( "get_objects" ).valid() );
+
+   // global concurrency
+   api_session_limiter session3( global );
+   BOOST_CHECK( !session3.admit( "get_objects" ).valid() );
+   BOOST_CHECK( session3.admit( "get_objects" ).valid() );
+   session2.release();
+   BOOST_CHECK( !session3.admit( "get_objects" ).valid() );
+}
+
+BOOST_AUTO_TEST_CASE(block_export_buffer_test) {
+   try {
+      ACTORS( (alice) );
+      generate_block();
+
+      block_export_buffer buffer;
+      buffer.set_max_blocks( 2 );
+      boost::signals2::scoped_connection conn;
+      conn = db.applied_block.connect( [&]( const signed_block& b ) {
+         buffer.on_applied_block( db, b );
+      });
+
+      transfer( committee_account, alice_id, asset(10000) );
+      generate_block();
+      const uint32_t transfer_block = db.head_block_num();
+
+      optional<exported_block> exported = buffer.fetch( db, transfer_block );
+      BOOST_REQUIRE( exported.valid() );
+      BOOST_CHECK( exported->virtual_ops_included );
+      BOOST_CHECK( exported->block_id == db.head_block_id() );
+      BOOST_REQUIRE_EQUAL( exported->operations.size(), 1u );
+      BOOST_CHECK_EQUAL( exported->operations[0].op.which(), operation::tag<transfer_operation>::value );
+
+      // once evicted, the export is rebuilt from the block's transactions
+      generate_block();
+      generate_block();
+      BOOST_CHECK_EQUAL( buffer.size(), 2u );
+      exported = buffer.fetch( db, transfer_block );
+      BOOST_REQUIRE( exported.valid() );
+      BOOST_CHECK( !exported->virtual_ops_included );
+      BOOST_REQUIRE_EQUAL( exported->operations.size(), 1u );
+      BOOST_CHECK_EQUAL( exported->operations[0].op.which(), operation::tag<transfer_operation>::value );
+      BOOST_CHECK_EQUAL( exported->operations[0].block_num, transfer_block );
+
+      BOOST_CHECK( !buffer.fetch( db, db.head_block_num() + 1 ).valid() );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(block_export_api_fork_switch) {
+   try {
+      generate_blocks( 3 );
+
+      auto export_api = std::make_shared<block_export_api>( std::ref( app ) );
+      vector<exported_block> pushed;
+      export_api->subscribe_blocks( [&]( const variant& v ) {
+         pushed.push_back( v.as<exported_block>( GRAPHENE_MAX_NESTED_OBJECTS ) );
+      }, 1, 1000 );
+      // blocks are pushed asynchronously
+      fc::usleep( fc::milliseconds( 20 ) );
+      const uint32_t head = db.head_block_num();
+      const block_id_type old_head_id = db.head_block_id();
+      BOOST_REQUIRE_EQUAL( pushed.size(), head );
+      BOOST_CHECK( pushed.back().block_id == old_head_id );
+
+      // switch the head block to another fork, which moves the cursor back to it
+      db.pop_block();
+      generate_block( ~0, generate_private_key( "null_key" ), 1 );
+      BOOST_REQUIRE_EQUAL( db.head_block_num(), head );
+      BOOST_REQUIRE( db.head_block_id() != old_head_id );
+
+      // the acknowledgement of the old head was already in flight
+      export_api->acknowledge( head );
+      fc::usleep( fc::milliseconds( 20 ) );
+      BOOST_REQUIRE_EQUAL( pushed.size(), head + 1 );
+      BOOST_CHECK_EQUAL( pushed.back().block_num, head );
+      BOOST_CHECK( pushed.back().block_id == db.head_block_id() );
+
+      // the replacement block is acknowledged normally and pushing continues
+      export_api->acknowledge( head );
+      generate_block();
+      fc::usleep( fc::milliseconds( 20 ) );
+      BOOST_REQUIRE_EQUAL( pushed.size(), head + 2 );
+      BOOST_CHECK_EQUAL( pushed.back().block_num, head + 1 );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
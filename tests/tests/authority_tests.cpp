@@ -1404,6 +1404,82 @@ BOOST_FIXTURE_TEST_CASE( parent_owner_test, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( authority_cache_test, database_fixture )
+{ try {
+   ACTORS( (alice)(bob)(multi) );
+   fund( multi );
+
+   auto set_auth = [&]( account_id_type aid, const authority& auth )
+   {
+      signed_transaction tx;
+      account_update_operation op;
+      op.account = aid;
+      op.active = auth;
+      op.owner = auth;
+      tx.operations.push_back( op );
+      set_expiration( db, tx );
+      PUSH_TX( db, tx, database::skip_transaction_signatures | database::skip_authority_check );
+   };
+   auto get_active = [&]( account_id_type aid ) -> const authority* { return &(aid(db).active); };
+   auto get_owner  = [&]( account_id_type aid ) -> const authority* { return &(aid(db).owner); };
+   auto make_transfer = [&]( share_type amount ) -> signed_transaction
+   {
+      signed_transaction tx;
+      transfer_operation op;
+      op.from = multi_id;
+      op.to = alice_id;
+      op.amount = asset( amount );
+      tx.operations.push_back( op );
+      set_expiration( db, tx );
+      return tx;
+   };
+   authority_cache& cache = db.get_authority_cache();
+   const uint32_t depth = db.get_global_properties().parameters.max_authority_depth;
+
+   set_auth( multi_id, authority( 2, alice_id, 1, bob_id, 1 ) );
+   generate_block();
+
+   // the same keys approving the same account are checked once
+   signed_transaction tx = make_transfer( 1 );
+   sign( tx, alice_private_key );
+   sign( tx, bob_private_key );
+   PUSH_TX( db, tx, 0 );
+   const uint64_t hits = cache.hits();
+   tx = make_transfer( 2 );
+   sign( tx, alice_private_key );
+   sign( tx, bob_private_key );
+   PUSH_TX( db, tx, 0 );
+   BOOST_CHECK_EQUAL( cache.hits(), hits + 1 );
+   generate_block();
+
+   // the API gets the same answer with and without the cache
+   flat_set<public_key_type> keys{ alice_public_key, bob_public_key };
+   tx = make_transfer( 3 );
+   BOOST_CHECK( tx.get_required_signatures( db.get_chain_id(), keys, get_active, get_owner, depth )
+                == tx.get_required_signatures( db.get_chain_id(), keys, get_active, get_owner, depth, &cache ) );
+   BOOST_CHECK( cache.size() > 0 );
+
+   // an account update drops what was remembered about the old authority
+   set_auth( multi_id, authority( 1, alice_id, 1 ) );
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+   generate_block();
+   tx = make_transfer( 4 );
+   sign( tx, alice_private_key );
+   sign( tx, bob_private_key );
+   GRAPHENE_REQUIRE_THROW( PUSH_TX( db, tx, 0 ), fc::exception );
+   tx = make_transfer( 5 );
+   sign( tx, alice_private_key );
+   PUSH_TX( db, tx, 0 );
+   tx.verify_authority( db.get_chain_id(), get_active, get_owner, depth, &cache );
+   BOOST_CHECK( cache.size() > 0 );
+
+   // and so does undoing it
+   db.pop_block();
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+   GRAPHENE_REQUIRE_THROW( tx.verify_authority( db.get_chain_id(), get_active, get_owner, depth, &cache ),
+                           fc::exception );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( issue_214 )
 { try {
    ACTORS( (alice)(bob) );
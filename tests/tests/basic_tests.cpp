@@ -584,6 +584,31 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( merkle_root_large_block )
+{
+   // enough transactions for the leaves to be hashed on several threads
+   signed_block block;
+   vector<digest_type> t;
+   const uint32_t num_tx = 1500;
+   for( uint32_t i=0; i<num_tx; i++ )
+   {
+      block.transactions.emplace_back();
+      block.transactions.back().ref_block_prefix = i;
+      t.push_back( block.transactions.back().merkle_digest() );
+   }
+
+   while( t.size() > 1 )
+   {
+      vector<digest_type> next;
+      for( size_t i = 0; i + 1 < t.size(); i += 2 )
+         next.push_back( digest_type::hash( std::make_pair( t[i], t[i+1] ) ) );
+      if( t.size() & 1 )
+         next.push_back( t.back() );
+      t.swap( next );
+   }
+   BOOST_CHECK( block.calculate_merkle_root() == checksum_type::hash( t[0] ) );
+}
+
 /**
  * Reproduces https://github.com/bitshares/bitshares-core/issues/888 and tests fix for it.
  */
@@ -599,4 +624,67 @@ BOOST_AUTO_TEST_CASE( bitasset_feed_expiration_test )
    BOOST_CHECK( !o.feed_is_expired( now ) );
 }
 
+BOOST_AUTO_TEST_CASE( expiration_scheduler_test )
+{ try {
+   expiration_scheduler scheduler;
+   const fc::time_point_sec start( 1500000000 );
+   auto id = []( uint64_t n ) { return object_id_type( protocol_ids, limit_order_object_type, n ); };
+
+   // due times spread over every wheel, in an order different from their ids
+   std::mt19937 gen( 7 );
+   std::uniform_int_distribution<uint32_t> offset( 1, 1u << 26 );
+   map<object_id_type, fc::time_point_sec> expected;
+   for( uint64_t i = 0; i < 2000; ++i )
+   {
+      fc::time_point_sec when = start + ( i % 7 == 0 ? uint32_t(i % 50) : offset( gen ) );
+      scheduler.schedule( expired_limit_orders, id(i), when );
+      expected[id(i)] = when;
+   }
+   BOOST_CHECK_EQUAL( scheduler.size( expired_limit_orders ), 2000u );
+   BOOST_CHECK_EQUAL( scheduler.size( expired_proposals ), 0u );
+
+   // rescheduling and cancelling
+   scheduler.schedule( expired_limit_orders, id(1), start + 3 );
+   expected[id(1)] = start + 3;
+   scheduler.cancel( id(2) );
+   expected.erase( id(2) );
+   scheduler.cancel( id(5000) );
+   BOOST_CHECK_EQUAL( scheduler.size( expired_limit_orders ), expected.size() );
+
+   // advance in block sized steps first, then in large jumps
+   fc::time_point_sec now = start;
+   while( !expected.empty() )
+   {
+      now += ( now < start + 600 ) ? 3 : 100000;
+      scheduler.advance( now );
+      vector<object_id_type> due = scheduler.due( expired_limit_orders, now );
+
+      vector<object_id_type> wanted;
+      vector<pair<fc::time_point_sec, object_id_type>> ordered;
+      for( const auto& e : expected )
+         if( e.second <= now )
+            ordered.emplace_back( e.second, e.first );
+      std::sort( ordered.begin(), ordered.end() );
+      for( const auto& e : ordered )
+         wanted.push_back( e.second );
+      BOOST_REQUIRE( due == wanted );
+
+      for( const auto& i : due )
+      {
+         scheduler.cancel( i );
+         expected.erase( i );
+      }
+   }
+   BOOST_CHECK_EQUAL( scheduler.size( expired_limit_orders ), 0u );
+
+   // going back in time does not hand out objects that are not due yet
+   scheduler.schedule( expired_limit_orders, id(1), now + 10 );
+   scheduler.advance( now + 20 );
+   BOOST_CHECK( scheduler.due( expired_limit_orders, now + 5 ).empty() );
+   BOOST_CHECK_EQUAL( scheduler.due( expired_limit_orders, now + 10 ).size(), 1u );
+   // scheduling at or before the time advanced to makes the object due at once
+   scheduler.schedule( expired_proposals, object_id_type( protocol_ids, proposal_object_type, 1 ), now );
+   BOOST_CHECK_EQUAL( scheduler.due( expired_proposals, now ).size(), 1u );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -31,6 +31,7 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/transaction_object.hpp>
 #include <graphene/chain/market_object.hpp>
 #include <graphene/chain/hardfork.hpp>
 
@@ -38,6 +39,8 @@
 
 #include <fc/crypto/digest.hpp>
 
+#include <fstream>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -94,7 +97,11 @@ BOOST_AUTO_TEST_CASE( block_database_test )
          fetch = bdb.fetch_optional( b.id() );
          FC_ASSERT( fetch.valid() );
          FC_ASSERT( fetch->witness ==  b.witness );
+         auto raw = bdb.fetch_raw_by_number( b.block_num() );
+         FC_ASSERT( raw.valid() );
+         FC_ASSERT( *raw == fc::raw::pack( b ) );
       }
+      FC_ASSERT( !bdb.fetch_raw_by_number( 6 ).valid() );
 
       for( uint32_t i = 1; i < 5; ++i )
       {
@@ -353,6 +360,60 @@ BOOST_AUTO_TEST_CASE( fork_blocks )
 }
 
 
+BOOST_AUTO_TEST_CASE( fork_db_max_bytes )
+{
+   try {
+      fork_database fdb;
+      vector<signed_block> main_chain;
+      signed_block prev;
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         signed_block b;
+         b.previous = prev.id();
+         b.timestamp = fc::time_point_sec( 1000 + i );
+         fdb.push_block( b );
+         main_chain.push_back( b );
+         prev = b;
+      }
+      // an abandoned fork off the fifth block
+      vector<signed_block> side_chain;
+      prev = main_chain[4];
+      for( uint32_t i = 0; i < 3; ++i )
+      {
+         signed_block b;
+         b.previous = prev.id();
+         b.timestamp = fc::time_point_sec( 2000 + i );
+         fdb.push_block( b );
+         side_chain.push_back( b );
+         prev = b;
+      }
+      BOOST_CHECK( fdb.head()->id == main_chain.back().id() );
+
+      // dropping the oldest block of the abandoned fork drops the whole fork, so no block is left unlinked
+      const size_t main_bytes = fdb.total_bytes() - 3 * fdb.fetch_block( side_chain[0].id() )->packed_size;
+      fdb.set_max_bytes( fdb.total_bytes() - 1 );
+      BOOST_CHECK_EQUAL( fdb.total_bytes(), main_bytes );
+      for( const auto& b : side_chain )
+         BOOST_CHECK( !fdb.fetch_block( b.id() ) );
+
+      // a block extending the dropped fork no longer links
+      signed_block orphan;
+      orphan.previous = side_chain.back().id();
+      orphan.timestamp = fc::time_point_sec( 3000 );
+      BOOST_CHECK_THROW( fdb.push_block( orphan ), unlinkable_block_exception );
+      BOOST_CHECK( fdb.head()->id == main_chain.back().id() );
+
+      // the branch of the head is never dropped for memory
+      fdb.set_max_bytes( 1 );
+      for( const auto& b : main_chain )
+         BOOST_CHECK( fdb.fetch_block( b.id() ) );
+
+      // the items share their block instead of holding a copy
+      auto item = fdb.fetch_block( main_chain[3].id() );
+      BOOST_CHECK( &item->data == item->block.get() );
+   } FC_LOG_AND_RETHROW()
+}
+
 /**
  *  These test has been disabled, out of order blocks should result in the node getting disconnected.
  *  
@@ -773,6 +834,61 @@ BOOST_FIXTURE_TEST_CASE( maintenance_interval, database_fixture )
 }
 
 
+BOOST_FIXTURE_TEST_CASE( parallel_vote_tally, database_fixture )
+{
+   try {
+      generate_block();
+      const share_type prec = asset::scaled_precision( asset_id_type()(db).precision );
+
+      ACTOR(zed);
+      transfer( committee_account, zed_id, asset(1000000 * prec) );
+      upgrade_to_lifetime_member( zed_id );
+      // bob comes before zed in name order, and pays its fees to zed
+      const account_id_type bob_id = create_account( "bob", zed_id(db), zed_id(db), 100 ).id;
+      transfer( committee_account, bob_id, asset(1000000 * prec) );
+      const committee_member_id_type cm_id = create_committee_member( zed_id(db) ).id;
+      {
+         account_update_operation op;
+         op.account = zed_id;
+         op.new_options = zed_id(db).options;
+         op.new_options->votes.insert( cm_id(db).vote_id );
+         trx.operations.push_back( op );
+         PUSH_TX( db, trx, ~0 );
+         trx.operations.clear();
+      }
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+
+      enable_fees();
+      transfer( bob_id, committee_account, asset(1000 * prec) );
+      BOOST_CHECK_GT( bob_id(db).statistics(db).pending_fees.value + bob_id(db).statistics(db).pending_vested_fees.value, 0 );
+
+      generate_block();
+
+      // the same maintenance block is generated twice, so it must directly follow the head block
+      const uint32_t slots_to_miss = db.get_slot_at_time( db.get_dynamic_global_properties().next_maintenance_time ) - 1;
+      db.set_maintenance_threads( 1 );
+      generate_block( ~0, init_account_priv_key, slots_to_miss );
+
+      // the cashback from bob's fees is counted in zed's stake
+      const account_object& zed_account = zed_id(db);
+      const uint64_t zed_stake = get_balance( zed_id, asset_id_type() )
+            + ( zed_account.cashback_vb.valid() ? zed_account.cashback_balance(db).balance.amount.value : 0 );
+      BOOST_CHECK( zed_account.cashback_vb.valid() );
+      BOOST_CHECK_EQUAL( cm_id(db).total_votes, zed_stake );
+
+      const uint64_t sequential_votes = cm_id(db).total_votes;
+      const auto sequential_committee = db.get_global_properties().active_committee_members;
+      const auto sequential_witnesses = db.get_global_properties().active_witnesses;
+
+      db.pop_block();
+      db.set_maintenance_threads( 4 );
+      generate_block( ~0, init_account_priv_key, slots_to_miss );
+      BOOST_CHECK_EQUAL( cm_id(db).total_votes, sequential_votes );
+      BOOST_CHECK( db.get_global_properties().active_committee_members == sequential_committee );
+      BOOST_CHECK( db.get_global_properties().active_witnesses == sequential_witnesses );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( limit_order_expiration, database_fixture )
 { try {
    //Get a sane head block time
@@ -976,6 +1092,257 @@ BOOST_FIXTURE_TEST_CASE( pop_block_twice, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( block_cache_test, database_fixture )
+{
+   try
+   {
+      db.set_block_cache_size( 3 );
+      for( int i = 0; i < 5; ++i )
+         generate_block();
+
+      const block_cache& cache = db.get_block_cache();
+      uint32_t head_num = db.head_block_num();
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      BOOST_CHECK( cache.fetch( head_num ) );
+      BOOST_CHECK( !cache.fetch( head_num - 3 ) );
+
+      // a miss is served from disk and then cached
+      optional<signed_block> old_block = db.fetch_block_by_number( head_num - 3 );
+      BOOST_REQUIRE( old_block.valid() );
+      BOOST_CHECK( cache.fetch( head_num - 3 ) );
+      BOOST_CHECK( cache.fetch_by_id( old_block->id() ) );
+
+      auto packed = cache.fetch_packed( head_num );
+      BOOST_REQUIRE( packed );
+      BOOST_CHECK( *packed == fc::raw::pack( *db.fetch_block_by_number( head_num ) ) );
+
+      block_id_type popped_id = db.head_block_id();
+      db.pop_block();
+      BOOST_CHECK( !cache.fetch( head_num ) );
+      BOOST_CHECK( !cache.fetch_by_id( popped_id ) );
+
+      generate_block();
+      BOOST_CHECK( cache.fetch( head_num ) );
+      BOOST_CHECK( cache.fetch( head_num )->id() == db.head_block_id() );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( lazy_impacted_accounts_test, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( alice );
+      generate_block();
+
+      uint32_t notifications = 0;
+      bool computed_before_asking = true;
+      flat_set<account_id_type> changed_accounts;
+      boost::signals2::scoped_connection conn( db.changed_objects.connect(
+         [&]( const vector<object_id_type>& ids, const lazy_impacted_accounts& impacted ) {
+            ++notifications;
+            computed_before_asking = impacted.computed();
+            changed_accounts = impacted.get();
+         } ) );
+
+      transfer( alice_id, bob_id, asset( 100 ) );
+      generate_block();
+      BOOST_CHECK_EQUAL( notifications, 1u );
+      BOOST_CHECK( !computed_before_asking );
+      BOOST_CHECK( changed_accounts.find( alice_id ) != changed_accounts.end() );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( recent_transaction_cache_test, database_fixture )
+{
+   try
+   {
+      generate_block();
+      ACTOR(alice);
+      generate_block();
+
+      set_expiration( db, trx );
+      transfer_operation op;
+      op.from = committee_account;
+      op.to = alice_id;
+      op.amount = asset(1000);
+      trx.operations.push_back( op );
+      PUSH_TX( db, trx, ~0 );
+      const transaction_id_type trx_id = trx.id();
+      const fc::time_point_sec expiration = trx.expiration;
+      trx.clear();
+
+      BOOST_CHECK( db.is_known_transaction( trx_id ) );
+      BOOST_CHECK( db.get_recent_transaction( trx_id ).id() == trx_id );
+      generate_block();
+
+      // the deduplication record only keeps the id and expiration
+      const auto& dedupe_index = db.get_index_type<transaction_index>().indices().get<by_trx_id>();
+      auto itr = dedupe_index.find( trx_id );
+      BOOST_REQUIRE( itr != dedupe_index.end() );
+      BOOST_CHECK( itr->expiration == expiration );
+      BOOST_REQUIRE( db.get_recent_transaction_cache().fetch( trx_id ) );
+      BOOST_CHECK_EQUAL( db.get_recent_transaction( trx_id ).operations.size(), 1u );
+
+      // dropping the full transaction does not affect duplicate detection
+      db.set_recent_transaction_cache_size( 0 );
+      BOOST_CHECK_EQUAL( db.get_recent_transaction_cache().size(), 0u );
+      BOOST_CHECK( db.is_known_transaction( trx_id ) );
+      BOOST_CHECK_THROW( db.get_recent_transaction( trx_id ), fc::exception );
+
+      db.set_recent_transaction_cache_size( 10 );
+      generate_blocks( expiration + db.get_global_properties().parameters.block_interval );
+      generate_block();
+      BOOST_CHECK( !db.is_known_transaction( trx_id ) );
+      BOOST_CHECK_THROW( db.get_recent_transaction( trx_id ), fc::exception );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( expired_transaction_impacted_accounts, database_fixture )
+{
+   try
+   {
+      generate_block();
+      ACTOR(alice);
+      generate_block();
+
+      set_expiration( db, trx );
+      transfer_operation op;
+      op.from = committee_account;
+      op.to = alice_id;
+      op.amount = asset(1000);
+      trx.operations.push_back( op );
+      PUSH_TX( db, trx, ~0 );
+      const transaction_id_type trx_id = trx.id();
+      const fc::time_point_sec expiration = trx.expiration;
+      trx.clear();
+      generate_block();
+
+      const auto& dedupe_index = db.get_index_type<transaction_index>().indices().get<by_trx_id>();
+      auto itr = dedupe_index.find( trx_id );
+      BOOST_REQUIRE( itr != dedupe_index.end() );
+      const object_id_type record_id = itr->id;
+
+      // the removal of the deduplication record is notified with the accounts of its transaction
+      bool removed = false;
+      flat_set<account_id_type> impacted;
+      boost::signals2::scoped_connection conn;
+      conn = db.removed_objects.connect( [&]( const vector<object_id_type>& ids, const vector<const object*>&,
+                                              const lazy_impacted_accounts& accounts ) {
+         if( std::find( ids.begin(), ids.end(), record_id ) == ids.end() )
+            return;
+         removed = true;
+         impacted = accounts.get();
+      });
+      generate_blocks( expiration + db.get_global_properties().parameters.block_interval );
+      generate_block();
+
+      BOOST_REQUIRE( removed );
+      BOOST_CHECK( impacted.find( alice_id ) != impacted.end() );
+      BOOST_CHECK( !db.get_recent_transaction_cache().fetch( trx_id ) );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( apply_profiler_test, database_fixture )
+{
+   try
+   {
+      generate_block();
+      apply_profiler& profiler = db.get_apply_profiler();
+      BOOST_CHECK( !profiler.enabled() );
+      BOOST_CHECK_EQUAL( profiler.get_profile().blocks.count, 0u );
+
+      profiler.enable( true );
+      ACTOR(alice);
+      transfer( committee_account, alice_id, asset(10000) );
+      // evaluating pending transactions is not recorded
+      BOOST_CHECK( profiler.get_profile().operations.empty() );
+      generate_block();
+
+      apply_profile profile = profiler.get_profile();
+      BOOST_CHECK_EQUAL( profile.blocks.count, 1u );
+      BOOST_REQUIRE_EQUAL( profile.phases.size(), size_t(apply_block_phase_count) );
+      BOOST_CHECK_EQUAL( profile.phases[phase_transactions].name, "transactions" );
+      BOOST_CHECK_EQUAL( profile.phases[phase_transactions].timing.count, 1u );
+      BOOST_CHECK_EQUAL( profile.phases[phase_notify_changed_objects].timing.count, 1u );
+
+      bool found_transfer = false;
+      for( const auto& op : profile.operations )
+      {
+         BOOST_CHECK_EQUAL( op.evaluate.count, op.apply.count );
+         if( op.which == operation::tag<transfer_operation>::value )
+         {
+            found_transfer = true;
+            BOOST_CHECK_EQUAL( op.name, "transfer_operation" );
+            BOOST_CHECK_EQUAL( op.evaluate.count, 1u );
+         }
+      }
+      BOOST_CHECK( found_transfer );
+
+      profiler.enable( false );
+      generate_block();
+      BOOST_CHECK_EQUAL( profiler.get_profile().blocks.count, 1u );
+
+      profiler.reset();
+      profile = profiler.get_profile();
+      BOOST_CHECK_EQUAL( profile.blocks.count, 0u );
+      BOOST_CHECK( profile.operations.empty() );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( apply_profiler_expirations, database_fixture )
+{
+   try
+   {
+      ACTOR(alice);
+      transfer( committee_account, alice_id, asset(10000) );
+      const asset_object& test = create_user_issued_asset( "TESTCOIN" );
+      generate_block();
+
+      apply_profiler& profiler = db.get_apply_profiler();
+      profiler.enable( true );
+      const fc::time_point_sec expiration = db.head_block_time() + 60;
+      BOOST_REQUIRE( create_sell_order( alice_id, asset(100), test.amount(100), expiration ) != nullptr );
+      BOOST_REQUIRE( create_sell_order( alice_id, asset(200), test.amount(100), expiration ) != nullptr );
+      generate_block();
+
+      apply_profile profile = profiler.get_profile();
+      BOOST_REQUIRE_EQUAL( profile.expirations.size(), size_t(expiration_kind_count) );
+      BOOST_CHECK_EQUAL( profile.expirations[expired_limit_orders].name, "limit_orders" );
+      BOOST_CHECK_EQUAL( profile.expirations[expired_limit_orders].total, 0u );
+
+      generate_blocks( expiration );
+      generate_block();
+      BOOST_CHECK( db.get_index_type<limit_order_index>().indices().empty() );
+
+      profile = profiler.get_profile();
+      const expiration_stats& limits = profile.expirations[expired_limit_orders];
+      BOOST_CHECK_EQUAL( limits.total, 2u );
+      BOOST_CHECK_EQUAL( limits.blocks, 1u );
+      BOOST_CHECK_EQUAL( limits.max_per_block, 2u );
+      BOOST_CHECK_EQUAL( profile.expirations[expired_withdraw_permissions].total, 0u );
+
+      profiler.reset();
+      BOOST_CHECK_EQUAL( profiler.get_profile().expirations[expired_limit_orders].total, 0u );
+      profiler.enable( false );
+
+      // the orders come back on schedule when the blocks that expired them are popped
+      BOOST_CHECK_EQUAL( db.get_expiration_scheduler().size( expired_limit_orders ), 0u );
+      db.pop_block();
+      db.pop_block();
+      BOOST_CHECK_EQUAL( db.get_expiration_scheduler().size( expired_limit_orders ), 2u );
+      BOOST_CHECK_EQUAL( db.get_index_type<limit_order_index>().indices().size(), 2u );
+      generate_blocks( expiration );
+      BOOST_CHECK( db.get_index_type<limit_order_index>().indices().empty() );
+      BOOST_CHECK_EQUAL( db.get_expiration_scheduler().size( expired_limit_orders ), 0u );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( rsf_missed_blocks, database_fixture )
 {
    try
@@ -1696,4 +2063,59 @@ BOOST_FIXTURE_TEST_CASE( temp_account_balance, database_fixture )
    BOOST_CHECK( get_balance( GRAPHENE_TEMP_ACCOUNT, asset_id_type() ) > 0 );
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( snapshot_export_import )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir3( graphene::utilities::temp_directory_path() );
+      fc::temp_directory snapshot_dir( graphene::utilities::temp_directory_path() );
+      const fc::path snapshot = snapshot_dir.path() / "snapshot.bin";
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+
+      database db1;
+      db1.open( data_dir1.path(), make_genesis, GRAPHENE_CURRENT_DB_VERSION );
+      for( uint32_t i = 0; i < 5; ++i )
+         db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+      db1.export_snapshot( *db1.fetch_block_by_number( db1.head_block_num() ), snapshot, 2 );
+      BOOST_CHECK( !fc::exists( snapshot_dir.path() / "snapshot.bin.tmp" ) );
+
+      database db2;
+      db2.open( data_dir2.path(), make_genesis, GRAPHENE_CURRENT_DB_VERSION, snapshot );
+      BOOST_CHECK( db2.head_block_id() == db1.head_block_id() );
+      BOOST_CHECK( db2.fetch_block_by_number( db2.head_block_num() ).valid() );
+      for( uint32_t space = 0; space < 256; ++space )
+         for( uint32_t type = 0; type < 256; ++type )
+         {
+            const auto* idx1 = db1.find_index( space, type );
+            const auto* idx2 = db2.find_index( space, type );
+            BOOST_REQUIRE( (idx1 == nullptr) == (idx2 == nullptr) );
+            if( idx1 == nullptr )
+               continue;
+            BOOST_CHECK( idx1->hash() == idx2->hash() );
+            BOOST_CHECK( idx1->get_next_id() == idx2->get_next_id() );
+         }
+
+      // the imported node follows the chain
+      for( uint32_t i = 0; i < 3; ++i )
+      {
+         auto b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+         PUSH_BLOCK( db2, b );
+      }
+      BOOST_CHECK( db2.head_block_id() == db1.head_block_id() );
+
+      // a damaged snapshot is rejected
+      {
+         std::fstream f( snapshot.generic_string(), std::ios::in | std::ios::out | std::ios::binary );
+         f.seekp( -40, std::ios::end );
+         f.put( 'x' );
+      }
+      database db3;
+      BOOST_CHECK_THROW( db3.open( data_dir3.path(), make_genesis, GRAPHENE_CURRENT_DB_VERSION, snapshot ), fc::exception );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/khc/util.hpp>
 
 #include <fc/crypto/digest.hpp>
 
@@ -692,4 +693,76 @@ BOOST_AUTO_TEST_CASE( lookup_vote_ids )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( get_objects_raw )
+{ try {
+   ACTORS( (alice) );
+
+   graphene::app::database_api db_api(db);
+
+   vector<object_id_type> ids = { alice_id, account_id_type(), asset_id_type(), account_id_type(999999) };
+   const auto packed = db_api.get_objects_raw( ids );
+   const auto json = db_api.get_objects( ids );
+
+   BOOST_REQUIRE_EQUAL( packed.size(), ids.size() );
+   BOOST_REQUIRE( packed[0].valid() );
+   BOOST_CHECK( fc::raw::unpack<account_object>( *packed[0] ).name == "alice" );
+   BOOST_CHECK( fc::raw::unpack<account_object>( *packed[1] ).id == account_id_type() );
+   BOOST_CHECK( fc::raw::unpack<asset_object>( *packed[2] ).symbol == json[2]["symbol"].as_string() );
+   BOOST_CHECK( !packed[3].valid() );
+   BOOST_CHECK( json[3].is_null() );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_power_leaderboard )
+{ try {
+   ACTORS( (alice)(bob)(carol) );
+   // the pending account creations are applied again by generate_block, add power afterwards
+   generate_block();
+
+   graphene::app::database_api db_api(db);
+   const share_type register_power = 50 * GRAPHENE_BLOCKCHAIN_PRECISION;
+   db.create<account_power_object>( [&]( account_power_object& p ) {
+      p.owner = bob_id;
+      p.power_from = graphene::khc::power_from_melt;
+      p.power_value = 100 * GRAPHENE_BLOCKCHAIN_PRECISION;
+   });
+   db.create<account_locked_power_object>( [&]( account_locked_power_object& l ) {
+      l.owner = bob_id;
+      l.power_from = graphene::khc::power_from_locked;
+      l.power_value = 120 * GRAPHENE_BLOCKCHAIN_PRECISION;
+      l.unlock_height = db.head_block_num() + 2;
+   });
+
+   auto bob_rank = db_api.get_account_power_rank( bob_id );
+   auto alice_rank = db_api.get_account_power_rank( alice_id );
+   BOOST_REQUIRE( bob_rank.valid() && alice_rank.valid() );
+   BOOST_CHECK_EQUAL( bob_rank->total_power.value, register_power.value * 3 );
+   BOOST_CHECK_EQUAL( bob_rank->available_power.value, register_power.value * 3 - 120 * GRAPHENE_BLOCKCHAIN_PRECISION );
+   BOOST_CHECK_EQUAL( bob_rank->total_power_rank, 1u );
+   BOOST_CHECK( bob_rank->available_power_rank > alice_rank->available_power_rank );
+   BOOST_CHECK( !db_api.get_account_power_rank( account_id_type() ).valid() );
+
+   auto top = db_api.get_power_leaderboard( false, 0, 101 );
+   BOOST_REQUIRE( top.size() >= 3u );
+   BOOST_CHECK( top[0].account == bob_id );
+   for( size_t i = 1; i < top.size(); ++i )
+   {
+      BOOST_CHECK( top[i-1].total_power >= top[i].total_power );
+      BOOST_CHECK_EQUAL( top[i].total_power_rank, i + 1 );
+   }
+   auto page = db_api.get_power_leaderboard( false, 1, 1 );
+   BOOST_REQUIRE_EQUAL( page.size(), 1u );
+   BOOST_CHECK( page[0].account == top[1].account );
+   BOOST_CHECK( db_api.get_power_leaderboard( false, top.size(), 10 ).empty() );
+
+   // the lock ends once the head block passes its unlock height
+   generate_blocks( 3 );
+   bob_rank = db_api.get_account_power_rank( bob_id );
+   BOOST_REQUIRE( bob_rank.valid() );
+   BOOST_CHECK_EQUAL( bob_rank->available_power.value, bob_rank->total_power.value );
+   BOOST_CHECK_EQUAL( bob_rank->available_power_rank, 1u );
+   BOOST_CHECK( db_api.get_power_leaderboard( true, 0, 1 )[0].account == bob_id );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
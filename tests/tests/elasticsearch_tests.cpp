@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/utilities/elasticsearch.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/network/http/server.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <memory>
+
+using graphene::utilities::es_bulk_sender;
+
+namespace {
+
+/// Stands in for an Elasticsearch node and keeps the body of every bulk it accepted
+struct mock_es_node
+{
+   explicit mock_es_node( const std::string& endpoint )
+   {
+      server.listen( fc::ip::endpoint::from_string( endpoint ) );
+      // due to implementation, on_request() must come AFTER listen()
+      server.on_request( [this]( const fc::http::request& req, const fc::http::server::response& resp )
+      {
+         ++requests;
+         if( failures_left > 0 )
+         {
+            --failures_left;
+            resp.set_status( fc::http::reply::InternalServerError );
+            resp.set_length( 0 );
+            return;
+         }
+         paths.push_back( req.path );
+         bulks.push_back( std::string( req.body.begin(), req.body.end() ) );
+         const std::string reply = "{\"errors\":false}";
+         resp.set_status( fc::http::reply::OK );
+         resp.set_length( reply.size() );
+         resp.write( reply.data(), reply.size() );
+      });
+   }
+
+   fc::http::server         server;
+   uint32_t                 requests = 0;
+   uint32_t                 failures_left = 0; ///< answer this many requests with a server error
+   std::vector<std::string> paths;
+   std::vector<std::string> bulks;
+};
+
+/// The mock node serves its requests on this thread, so waiting has to yield to it
+template<typename Condition>
+bool wait_for( Condition done )
+{
+   const fc::time_point deadline = fc::time_point::now() + fc::seconds( 10 );
+   while( !done() && fc::time_point::now() < deadline )
+      fc::usleep( fc::milliseconds( 10 ) );
+   return done();
+}
+
+std::vector<std::string> make_bulk( uint32_t n )
+{
+   return { "{ \"index\" : { \"_index\" : \"test\" } }", "{\"n\":" + std::to_string( n ) + "}" };
+}
+
+std::string bulk_body( uint32_t n )
+{
+   std::vector<std::string> bulk = make_bulk( n );
+   return bulk[0] + "\n" + bulk[1] + "\n";
+}
+
+es_bulk_sender::options sender_options( const std::string& endpoint )
+{
+   es_bulk_sender::options o;
+   o.url = "http://" + endpoint + "/";
+   o.max_queued_batches = 4;
+   o.initial_backoff_ms = 10;
+   o.max_backoff_ms = 50;
+   o.connect_timeout_ms = 1000;
+   o.request_timeout_ms = 2000;
+   return o;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(elasticsearch_tests)
+
+BOOST_AUTO_TEST_CASE(es_bulk_sender_batches_and_retries)
+{ try {
+   const std::string endpoint = "127.0.0.1:19293";
+   mock_es_node node( endpoint );
+   es_bulk_sender sender( sender_options( endpoint ) );
+
+   // every bulk is posted as one request, in order
+   for( uint32_t i = 0; i < 3; ++i )
+   {
+      std::vector<std::string> bulk = make_bulk( i );
+      sender.send( bulk );
+      BOOST_CHECK( bulk.empty() );
+   }
+   BOOST_REQUIRE( wait_for( [&](){ return sender.get_stats().sent_batches == 3; } ) );
+   BOOST_REQUIRE_EQUAL( node.bulks.size(), 3u );
+   for( uint32_t i = 0; i < 3; ++i )
+   {
+      BOOST_CHECK_EQUAL( node.paths[i], "/_bulk" );
+      BOOST_CHECK_EQUAL( node.bulks[i], bulk_body( i ) );
+   }
+   BOOST_CHECK_EQUAL( sender.get_stats().sent_lines, 6u );
+   BOOST_CHECK_EQUAL( sender.get_stats().queued_batches, 0u );
+   BOOST_CHECK_EQUAL( sender.get_stats().failed_requests, 0u );
+
+   // server errors are retried until the bulk is accepted
+   node.failures_left = 2;
+   std::vector<std::string> bulk = make_bulk( 3 );
+   sender.send( bulk );
+   BOOST_REQUIRE( wait_for( [&](){ return sender.get_stats().sent_batches == 4; } ) );
+   BOOST_CHECK_EQUAL( node.requests, 6u );
+   BOOST_REQUIRE_EQUAL( node.bulks.size(), 4u );
+   BOOST_CHECK_EQUAL( node.bulks[3], bulk_body( 3 ) );
+   BOOST_CHECK_EQUAL( sender.get_stats().failed_requests, 2u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(es_bulk_sender_spools_while_down)
+{ try {
+   fc::temp_directory spool_dir( graphene::utilities::temp_directory_path() );
+   const std::string endpoint = "127.0.0.1:19294";
+   es_bulk_sender::options o = sender_options( endpoint );
+   o.spool_file = ( spool_dir.path() / "spool" ).string();
+
+   {
+      // nothing listens yet: four bulks wait in the queue, the others go to the spool
+      es_bulk_sender sender( o );
+      for( uint32_t i = 0; i < 6; ++i )
+      {
+         std::vector<std::string> bulk = make_bulk( i );
+         sender.send( bulk );
+      }
+      BOOST_CHECK_EQUAL( sender.get_stats().queued_batches, 4u );
+      BOOST_CHECK( sender.get_stats().spooled_bytes > 0 );
+      BOOST_CHECK( wait_for( [&](){ return sender.get_stats().failed_requests >= 2; } ) );
+      BOOST_CHECK_EQUAL( sender.get_stats().sent_batches, 0u );
+      // shutting down spools the queued bulks in front of the others
+   }
+   BOOST_CHECK( fc::file_size( o.spool_file ) > 0 );
+
+   // once the node is up, a new sender sends the spool in the original order
+   mock_es_node node( endpoint );
+   es_bulk_sender sender( o );
+   BOOST_REQUIRE( wait_for( [&](){ return sender.get_stats().sent_batches == 6; } ) );
+   BOOST_REQUIRE_EQUAL( node.bulks.size(), 6u );
+   for( uint32_t i = 0; i < 6; ++i )
+      BOOST_CHECK_EQUAL( node.bulks[i], bulk_body( i ) );
+   BOOST_CHECK_EQUAL( sender.get_stats().spooled_bytes, 0u );
+   BOOST_CHECK_EQUAL( sender.get_stats().sent_lines, 12u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
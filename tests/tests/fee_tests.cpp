@@ -3689,6 +3689,58 @@ BOOST_AUTO_TEST_CASE( defaults_test )
   }
 }
 
+BOOST_AUTO_TEST_CASE( fee_table_test )
+{ try {
+    fee_schedule schedule = fee_schedule::get_default();
+    schedule.scale = GRAPHENE_100_PERCENT * 3 / 2;
+    schedule.parameters.erase( bid_collateral_operation::fee_parameters_type() );
+    limit_order_create_operation::fee_parameters_type order_fee; order_fee.fee = 123;
+    schedule.parameters.erase( order_fee );
+    schedule.parameters.insert( order_fee );
+    call_order_update_operation::fee_parameters_type short_fee; short_fee.fee = 77;
+    schedule.parameters.erase( short_fee );
+    schedule.parameters.insert( short_fee );
+
+    const fee_table table( schedule );
+    const price rate( asset( 10, asset_id_type(1) ), asset( 3 ) );
+
+    transfer_operation xfer;
+    xfer.memo = memo_data();
+    xfer.memo->message.resize( 3000 );
+    account_create_operation create;
+    create.name = "averylongaccountname";
+
+    vector<operation> ops{ limit_order_create_operation(), bid_collateral_operation(), transfer_operation(), xfer,
+                           create, call_order_update_operation() };
+    for( const auto& op : ops )
+    {
+       BOOST_CHECK( table.calculate_fee( op ) == schedule.calculate_fee( op ) );
+       BOOST_CHECK( table.calculate_fee( op, rate ) == schedule.calculate_fee( op, rate ) );
+       operation a = op;
+       operation b = op;
+       BOOST_CHECK( table.set_fee( a, rate ) == schedule.set_fee( b, rate ) );
+    }
+    // bid_collateral falls back to the call_order_update fee
+    BOOST_CHECK_EQUAL( table.calculate_fee( bid_collateral_operation() ).amount.value, 77 * 3 / 2 );
+    BOOST_CHECK( table.has_fixed_fee( operation::tag<limit_order_create_operation>::value ) );
+    BOOST_CHECK( !table.has_fixed_fee( operation::tag<transfer_operation>::value ) );
+
+    // the database table follows changes of the fee schedule, including undo
+    const asset before = db.current_fee_table().calculate_fee( transfer_operation() );
+    BOOST_CHECK( before == db.current_fee_schedule().calculate_fee( transfer_operation() ) );
+    {
+       auto session = db._undo_db.start_undo_session();
+       db.modify( global_property_id_type()(db), []( global_property_object& gpo )
+       {
+          gpo.parameters.current_fees = fee_schedule::get_default();
+       });
+       BOOST_CHECK( db.current_fee_table().calculate_fee( transfer_operation() )
+                    == db.current_fee_schedule().calculate_fee( transfer_operation() ) );
+       BOOST_CHECK( db.current_fee_table().calculate_fee( transfer_operation() ) != before );
+    }
+    BOOST_CHECK( db.current_fee_table().calculate_fee( transfer_operation() ) == before );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( issue_429_test )
 {
    try
@@ -27,6 +27,7 @@
 #include <graphene/app/api.hpp>
 
 #include <graphene/utilities/tempdir.hpp>
+#include <graphene/khc/config.hpp>
 
 #include <fc/crypto/digest.hpp>
 
@@ -585,4 +586,272 @@ BOOST_AUTO_TEST_CASE(get_account_history_operations) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(compact_account_history) {
+   try {
+      graphene::app::history_api hist_api(app);
+      ACTORS( (alice) );
+      generate_block();
+
+      // alice gets 1 + 100 entries, 70 are kept
+      for( int i = 0; i < 100; ++i )
+      {
+         transfer( account_id_type(), alice_id, asset(1) );
+         if( i % 30 == 29 )
+            generate_block();
+      }
+      generate_block();
+
+      const auto& stats = alice_id(db).statistics(db);
+      BOOST_CHECK_EQUAL( stats.total_ops, 101u );
+      BOOST_CHECK_EQUAL( stats.removed_ops, 31u );
+
+      const auto& chunk_idx = db.get_index_type<graphene::account_history::account_history_chunk_index>()
+                                .indices().get<graphene::account_history::by_account_seq>();
+      auto chunk_count = std::distance( chunk_idx.lower_bound( boost::make_tuple( alice_id, 0 ) ),
+                                        chunk_idx.upper_bound( boost::make_tuple( alice_id, uint32_t(-1) ) ) );
+      BOOST_CHECK_EQUAL( chunk_count, 2 );
+
+      vector<operation_history_object> relative = hist_api.get_relative_account_history( alice_id, 0, 100, 0 );
+      BOOST_REQUIRE_EQUAL( relative.size(), 70u );
+      for( size_t i = 1; i < relative.size(); ++i )
+         BOOST_CHECK( relative[i].id < relative[i-1].id );
+      const operation_history_id_type newest = relative.front().id;
+      const operation_history_id_type oldest = relative.back().id;
+
+      relative = hist_api.get_relative_account_history( alice_id, 95, 100, 100 );
+      BOOST_CHECK_EQUAL( relative.size(), 6u );
+      relative = hist_api.get_relative_account_history( alice_id, 0, 100, 20 );
+      BOOST_CHECK_EQUAL( relative.size(), 0u );
+
+      vector<operation_history_object> histories = hist_api.get_account_history( alice_id, operation_history_id_type(),
+                                                                                 100, operation_history_id_type() );
+      BOOST_REQUIRE_EQUAL( histories.size(), 70u );
+      BOOST_CHECK( histories.front().id == newest );
+      BOOST_CHECK( histories.back().id == oldest );
+
+      // start and stop by operation id
+      histories = hist_api.get_account_history( alice_id, histories[10].id, 5, histories[2].id );
+      BOOST_REQUIRE_EQUAL( histories.size(), 5u );
+      histories = hist_api.get_account_history_operations( alice_id, operation::tag<transfer_operation>::value,
+                                                           operation_history_id_type(), operation_history_id_type(), 100 );
+      BOOST_CHECK_EQUAL( histories.size(), 70u );
+
+      // undone blocks drop their entries
+      transfer( account_id_type(), alice_id, asset(1) );
+      generate_block();
+      BOOST_CHECK_EQUAL( stats.total_ops, 102u );
+      db.pop_block();
+      BOOST_CHECK_EQUAL( alice_id(db).statistics(db).total_ops, 101u );
+      BOOST_CHECK_EQUAL( hist_api.get_relative_account_history( alice_id, 0, 100, 0 ).size(), 70u );
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(cold_account_history) {
+   try {
+      graphene::app::history_api hist_api(app);
+      ACTORS( (alice) );
+      generate_block();
+
+      // alice gets 1 + 150 entries, 70 are kept in memory
+      for( int i = 0; i < 150; ++i )
+      {
+         transfer( account_id_type(), alice_id, asset(1) );
+         if( i % 30 == 29 )
+            generate_block();
+      }
+      for( int i = 0; i < 30; ++i )
+         generate_block();
+      BOOST_REQUIRE( db.get_dynamic_global_properties().last_irreversible_block_num > 0 );
+
+      // the next entry moves the first, now irreversible, chunk to disk
+      transfer( account_id_type(), alice_id, asset(1) );
+      generate_block();
+
+      const auto& stats = alice_id(db).statistics(db);
+      BOOST_CHECK_EQUAL( stats.total_ops, 152u );
+      BOOST_CHECK_EQUAL( stats.removed_ops, 82u );
+      const auto& chunk_idx = db.get_index_type<graphene::account_history::account_history_chunk_index>()
+                                .indices().get<graphene::account_history::by_account_seq>();
+      BOOST_CHECK( chunk_idx.find( boost::make_tuple( alice_id, 1u ) ) == chunk_idx.end() );
+
+      // the whole history stays available, paging across memory and disk
+      vector<operation_history_object> oldest = hist_api.get_relative_account_history( alice_id, 1, 100, 60 );
+      BOOST_REQUIRE_EQUAL( oldest.size(), 60u );
+      BOOST_CHECK_EQUAL( oldest.back().op.which(), operation::tag<account_create_operation>::value );
+      BOOST_CHECK( db.find( oldest.back().id ) == nullptr );
+
+      vector<operation_history_object> all;
+      operation_history_id_type start;
+      while( true )
+      {
+         vector<operation_history_object> page = hist_api.get_account_history( alice_id, operation_history_id_type(),
+                                                                               50, start );
+         all.insert( all.end(), page.begin(), page.end() );
+         if( page.size() < 50 || page.back().id == operation_history_id_type() )
+            break;
+         start = operation_history_id_type( page.back().id.instance() - 1 );
+      }
+      BOOST_REQUIRE_EQUAL( all.size(), 152u );
+      BOOST_CHECK( all.back().id == oldest.back().id );
+      BOOST_CHECK( all[92].id == oldest.front().id );
+
+      vector<operation_history_object> transfers = hist_api.get_account_history_operations( alice_id,
+            operation::tag<transfer_operation>::value, operation_history_id_type(), operation_history_id_type(), 100 );
+      BOOST_CHECK_EQUAL( transfers.size(), 100u );
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(get_financing_history) {
+   try {
+      graphene::app::financing_api fin_api(app);
+      ACTORS( (alice)(bob) );
+
+      const asset_object& khd = create_user_issued_asset( "KHD" );
+      const asset_id_type khd_id = khd.id;
+      const asset_id_type project_id = create_user_issued_asset( "PROJECT" ).id;
+      const asset_id_type failed_id = create_user_issued_asset( "FAILED" ).id;
+      issue_uia( alice, asset( 10000, khd_id ) );
+      issue_uia( bob, asset( 10000, khd_id ) );
+      // the pending transactions are applied again by generate_block, so set up the projects afterwards
+      generate_block();
+      auto setup_project = [&]( asset_id_type id, const string& name ) {
+         db.modify( id( db ), [&]( asset_object& a ) {
+            a.proj_options.name = name;
+            a.proj_options.financing_type = KHC_PUBLIC_OFFERING;
+            a.proj_options.min_financing_amount = 1000;
+            a.proj_options.max_financing_amount = 5000;
+            a.proj_options.start_financing_block_num = 0;
+            a.proj_options.end_financing_block_num = db.head_block_num() + 1000;
+            // every KHD buys two project tokens
+            a.proj_options.khd_exchange_rate = price( asset( 1, khd_id ), asset( 1 ) );
+            a.options.core_exchange_rate = price( asset( 2, id ), asset( 1 ) );
+         });
+      };
+      setup_project( project_id, "project" );
+      setup_project( failed_id, "failed" );
+
+      auto push = [&]( const operation& op ) {
+         trx.operations.push_back( op );
+         set_expiration( db, trx );
+         PUSH_TX( db, trx, ~0 );
+         trx.clear();
+      };
+      auto invest = [&]( account_id_type account, asset_id_type project, share_type amount ) {
+         asset_investment_operation op;
+         op.account_id = account;
+         op.investment_asset_id = project;
+         op.amount = asset( amount, khd_id );
+         push( op );
+      };
+      invest( alice_id, project_id, 1500 );
+      invest( alice_id, project_id, 1500 );
+      // capped at max_financing_amount
+      invest( bob_id, project_id, 3000 );
+      invest( alice_id, failed_id, 500 );
+      generate_block();
+
+      optional<financing_progress> progress = fin_api.get_financing_progress( project_id );
+      BOOST_REQUIRE( progress.valid() );
+      BOOST_CHECK_EQUAL( progress->project.total_invested.value, 5000 );
+      BOOST_CHECK_EQUAL( progress->project.investment_count, 3u );
+      BOOST_CHECK_EQUAL( progress->project.investor_count, 2u );
+      BOOST_CHECK_EQUAL( progress->max_financing_amount.value, 5000 );
+      BOOST_CHECK_EQUAL( progress->percent_of_max, GRAPHENE_100_PERCENT );
+      BOOST_CHECK( progress->min_reached );
+      BOOST_CHECK( !fin_api.get_financing_progress( khd_id ).valid() );
+
+      BOOST_CHECK( fin_api.get_financing_bucket_sizes() == flat_set<uint32_t>{ 3600 } );
+      vector<financing_bucket_object> buckets = fin_api.get_financing_history( project_id, 3600,
+                                                                               fc::time_point_sec(), db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( buckets.size(), 1u );
+      BOOST_CHECK_EQUAL( buckets[0].invested.value, 5000 );
+      BOOST_CHECK_EQUAL( buckets[0].new_investors, 2u );
+      BOOST_CHECK_EQUAL( buckets[0].total_invested.value, 5000 );
+      BOOST_CHECK( buckets[0].key.open <= db.head_block_time() );
+      BOOST_CHECK( fin_api.get_financing_history( project_id, 86400, fc::time_point_sec(), db.head_block_time() ).empty() );
+
+      // the first project succeeded: its tokens are issued and claimed by the investors, the KHD by the issuer
+      issue_asset_to_investors_operation issue;
+      issue.issue = project_id( db ).issuer;
+      issue.investment_asset_id = project_id;
+      push( issue );
+      for( account_id_type investor : { alice_id, bob_id } )
+      {
+         claim_asset_investment_operation claim;
+         claim.account_id = investor;
+         claim.asset_id = project_id;
+         push( claim );
+      }
+      for( int i = 0; i < 3; ++i )
+      {
+         claim_bitasset_investment_operation claim;
+         claim.account_id = project_id( db ).issuer;
+         claim.asset_id = project_id;
+         push( claim );
+      }
+
+      // the second one failed and alice takes her KHD back
+      db.modify( failed_id( db ).dynamic_asset_data_id( db ), []( asset_dynamic_data_object& d ) {
+         d.state = asset_dynamic_data_object::project_state::financing_failue;
+      });
+      refund_investment_operation refund;
+      refund.account_id = alice_id;
+      refund.investment_asset_id = failed_id;
+      push( refund );
+      generate_block();
+
+      BOOST_CHECK_EQUAL( get_balance( alice_id, project_id ), 6000 );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, project_id ), 4000 );
+
+      progress = fin_api.get_financing_progress( project_id );
+      BOOST_REQUIRE( progress.valid() );
+      BOOST_CHECK_EQUAL( progress->project.tokens_issued.value, 10000 );
+      BOOST_CHECK( progress->project.issue_time == db.head_block_time() );
+      BOOST_CHECK_EQUAL( progress->project.tokens_claimed.value, 10000 );
+      BOOST_CHECK_EQUAL( progress->project.investor_claim_count, 2u );
+      BOOST_CHECK_EQUAL( progress->project.issuer_claimed.value, 5000 );
+      BOOST_CHECK_EQUAL( progress->project.issuer_claim_count, 3u );
+      BOOST_CHECK_EQUAL( progress->project.financing_supply().value, 0 );
+
+      buckets = fin_api.get_financing_history( project_id, 3600, fc::time_point_sec(), db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( buckets.size(), 1u );
+      BOOST_CHECK_EQUAL( buckets[0].invested.value, 5000 );
+      BOOST_CHECK_EQUAL( buckets[0].tokens_claimed.value, 10000 );
+      BOOST_CHECK_EQUAL( buckets[0].investor_claim_count, 2u );
+      BOOST_CHECK_EQUAL( buckets[0].issuer_claimed.value, 5000 );
+      BOOST_CHECK_EQUAL( buckets[0].issuer_claim_count, 3u );
+      BOOST_CHECK_EQUAL( buckets[0].refund_count, 0u );
+
+      progress = fin_api.get_financing_progress( failed_id );
+      BOOST_REQUIRE( progress.valid() );
+      BOOST_CHECK_EQUAL( progress->state, asset_dynamic_data_object::project_state::financing_failue );
+      BOOST_CHECK( !progress->min_reached );
+      BOOST_CHECK_EQUAL( progress->project.total_invested.value, 500 );
+      BOOST_CHECK_EQUAL( progress->project.total_refunded.value, 500 );
+      BOOST_CHECK_EQUAL( progress->project.refund_count, 1u );
+      BOOST_CHECK_EQUAL( progress->project.financing_supply().value, 0 );
+
+      buckets = fin_api.get_financing_history( failed_id, 3600, fc::time_point_sec(), db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( buckets.size(), 1u );
+      BOOST_CHECK_EQUAL( buckets[0].invested.value, 500 );
+      BOOST_CHECK_EQUAL( buckets[0].refunded.value, 500 );
+      BOOST_CHECK_EQUAL( buckets[0].refund_count, 1u );
+      BOOST_CHECK_EQUAL( buckets[0].total_invested.value, 500 );
+
+      // all the KHD is back in balances
+      BOOST_CHECK_EQUAL( get_balance( alice_id, khd_id ) + get_balance( bob_id, khd_id )
+                         + get_balance( project_id( db ).issuer, khd_id ), 20000 );
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
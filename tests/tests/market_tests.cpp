@@ -1507,4 +1507,99 @@ BOOST_AUTO_TEST_CASE(target_cr_test_call_limit)
 
 } FC_LOG_AND_RETHROW() }
 
+/***
+ * Several fills of a market in one block are aggregated into a single bucket and ticker update
+ */
+BOOST_AUTO_TEST_CASE(market_history_aggregates_block_fills)
+{ try {
+   generate_blocks(HARDFORK_615_TIME);
+   generate_block();
+   set_expiration( db, trx );
+
+   ACTORS( (seller)(buyer) );
+   const asset_object& test = create_user_issued_asset( "UIATEST" );
+   const asset_id_type test_id = test.id;
+   const asset_object& core = asset_id_type()(db);
+   transfer( committee_account, seller_id, asset( 1000 ) );
+   issue_uia( buyer, test.amount( 1000 ) );
+
+   create_sell_order( seller, core.amount(10), test.amount(10) );
+   create_sell_order( seller, core.amount(10), test.amount(20) );
+   create_sell_order( seller, core.amount(10), test.amount(30) );
+   BOOST_CHECK( create_sell_order( buyer, test.amount(60), core.amount(20) ) == nullptr );
+   generate_block();
+
+   // 3 maker fills and 3 taker fills
+   BOOST_CHECK_EQUAL( get_market_order_history( asset_id_type(), test_id ).size(), 6u );
+
+   using namespace graphene::market_history;
+   const auto& bucket_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+   auto itr = bucket_idx.lower_bound( bucket_key( asset_id_type(), test_id, 15, fc::time_point_sec() ) );
+   BOOST_REQUIRE( itr != bucket_idx.end() );
+   BOOST_CHECK( itr->key.base == asset_id_type() && itr->key.quote == test_id && itr->key.seconds == 15u );
+   BOOST_CHECK_EQUAL( itr->base_volume.value, 30 );
+   BOOST_CHECK_EQUAL( itr->quote_volume.value, 60 );
+   BOOST_CHECK( itr->high() == core.amount(10) / test.amount(10) );
+   BOOST_CHECK( itr->low() == core.amount(10) / test.amount(30) );
+   auto next = itr;
+   ++next;
+   BOOST_CHECK( next == bucket_idx.end() || next->key.quote != test_id );
+
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   auto ticker = ticker_idx.find( std::make_tuple( asset_id_type(), test_id ) );
+   BOOST_REQUIRE( ticker != ticker_idx.end() );
+   BOOST_CHECK( ticker->base_volume == fc::uint128(30) );
+   BOOST_CHECK( ticker->quote_volume == fc::uint128(60) );
+   BOOST_CHECK( ticker->latest_base == itr->close_base );
+   BOOST_CHECK( ticker->latest_quote == itr->close_quote );
+} FC_LOG_AND_RETHROW() }
+
+/***
+ * The grouped_orders plugin keeps the amount for sale per fixed price bucket
+ */
+BOOST_AUTO_TEST_CASE(grouped_orders_bucket_totals)
+{ try {
+   ACTORS( (seller) );
+   const asset_object& test = create_user_issued_asset( "GROUPTEST" );
+   const asset_id_type test_id = test.id;
+   transfer( committee_account, seller_id, asset( 1000000 ) );
+
+   auto plugin = app.get_plugin<graphene::grouped_orders::grouped_orders_plugin>( "grouped_orders" );
+   BOOST_REQUIRE( plugin );
+   const auto& groups = plugin->limit_order_groups();
+   auto buckets_of = [&]( uint16_t group ) {
+      vector< std::pair<graphene::grouped_orders::limit_order_group_key,
+                        graphene::grouped_orders::limit_order_group_data> > result;
+      for( const auto& item : groups )
+         if( item.first.group == group && item.first.min_price.base.asset_id == asset_id_type()
+                                       && item.first.min_price.quote.asset_id == test_id )
+            result.push_back( item );
+      return result;
+   };
+
+   // 0.25% and 0.45% above 1, in the same 1% bucket but in different 0.1% buckets
+   const price p1 = asset( 10025 ) / test.amount( 10000 );
+   const price p2 = asset( 10045 ) / test.amount( 10000 );
+   const limit_order_id_type o1 = create_sell_order( seller, asset( 10025 ), test.amount( 10000 ) )->id;
+   create_sell_order( seller, asset( 10045 ), test.amount( 10000 ) );
+
+   auto wide = buckets_of( 100 );
+   BOOST_REQUIRE_EQUAL( wide.size(), 1u );
+   BOOST_CHECK_EQUAL( wide[0].second.total_for_sale.value, 20070 );
+   BOOST_CHECK_EQUAL( wide[0].second.order_count, 2u );
+   BOOST_CHECK( wide[0].first.min_price <= p1 );
+   BOOST_CHECK( p2 < wide[0].second.max_price );
+   BOOST_CHECK_EQUAL( buckets_of( 10 ).size(), 2u );
+
+   cancel_limit_order( o1(db) );
+   wide = buckets_of( 100 );
+   BOOST_REQUIRE_EQUAL( wide.size(), 1u );
+   BOOST_CHECK_EQUAL( wide[0].second.total_for_sale.value, 10045 );
+   BOOST_CHECK_EQUAL( wide[0].second.order_count, 1u );
+   auto narrow = buckets_of( 10 );
+   BOOST_REQUIRE_EQUAL( narrow.size(), 1u );
+   BOOST_CHECK( narrow[0].first.min_price <= p2 );
+   BOOST_CHECK( p2 < narrow[0].second.max_price );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()